@@ -0,0 +1,48 @@
+#ifndef BRUTUS_BENCH_CONTEXT_H_
+#define BRUTUS_BENCH_CONTEXT_H_
+
+#include "brutus.h"
+#include "compiler.h"
+
+namespace brutus {
+  namespace bench {
+    // A context without a compiler so phases can be run one at a time.
+    // Each context has its own global scope, a phase that enters
+    // symbols needs a fresh one for every run.
+    class BenchContext : public Context {
+      public:
+        BenchContext() {
+          m_arena = new internal::Arena(
+            /*initialCapacity = */512 * consts::KiloByte,
+            /*blockSize = */consts::PageSize * 4,
+            /*alignment = */consts::Alignment);
+          m_arena->init();
+          m_arenaAlloc = new internal::ArenaAllocator(m_arena);
+          m_names = new internal::NameTable();
+          m_symbolTable = new internal::syms::SymbolTable(m_names, m_arena);
+        }
+
+        ~BenchContext() {
+          delete m_symbolTable;
+          delete m_names;
+          delete m_arenaAlloc;
+          m_arena->deleteAll();
+          delete m_arena;
+        }
+
+        internal::Arena* arena() override final { return m_arena; }
+        internal::ArenaAllocator* allocator() override final { return m_arenaAlloc; }
+        internal::NameTable* names() override final { return m_names; }
+        internal::syms::SymbolTable* symbols() override final { return m_symbolTable; }
+
+      private:
+        internal::Arena* m_arena;
+        internal::ArenaAllocator* m_arenaAlloc;
+        internal::NameTable* m_names;
+        internal::syms::SymbolTable* m_symbolTable;
+
+        DISALLOW_COPY_AND_ASSIGN(BenchContext);
+    }; //class BenchContext
+  } //namespace bench
+} //namespace brutus
+#endif
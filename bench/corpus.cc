@@ -0,0 +1,360 @@
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+
+#include "corpus.h"
+
+namespace brutus {
+namespace bench {
+static const char* const kOperators[] = { "+", "-", "*", "/", "<", ">" };
+static const int kNumOperators = sizeof(kOperators) / sizeof(kOperators[0]); //NOLINT
+static const char kConsonants[] = "bdfgklmnprstvz";
+static const char kVowels[] = "aeiou";
+static const int kNumConsonants = sizeof(kConsonants) - 1; //NOLINT
+static const int kNumVowels = sizeof(kVowels) - 1; //NOLINT
+static const int kNumSyllables = kNumConsonants * kNumVowels;
+
+// Keywords that are spelled with the syllables above.
+static const char* const kKeywords[] = { "module", "native", "pure" };
+
+static uint64_t parseSize(const char* value) {
+  char* end = nullptr;
+  uint64_t result = strtoull(value, &end, 10);
+
+  switch(*end) {
+    case 'k': case 'K': result <<= 10; break;
+    case 'm': case 'M': result <<= 20; break;
+    case 'g': case 'G': result <<= 30; break;
+    default: break;
+  }
+
+  return result;
+}
+
+bool CorpusOptions::parse(const char* arg) {
+  const auto separator = strchr(arg, '=');
+
+  if(nullptr == separator) {
+    return NO;
+  }
+
+  const auto length = static_cast<size_t>(separator - arg);
+  const auto value = separator + 1;
+  const auto number = atoi(value);
+
+#define OPTION(x) (length == strlen(x) && 0 == strncmp(arg, x, length))
+  if(OPTION("--modules")) {
+    m_numModules = number;
+  } else if(OPTION("--classes")) {
+    m_numClasses = number;
+  } else if(OPTION("--members")) {
+    m_numMembers = number;
+  } else if(OPTION("--functions")) {
+    m_numFunctions = number > 0 ? number : 1;
+  } else if(OPTION("--statements")) {
+    m_numStatements = number;
+  } else if(OPTION("--depth")) {
+    m_depth = number;
+  } else if(OPTION("--names")) {
+    m_numNames = number;
+  } else if(OPTION("--overloads")) {
+    m_numOverloads = number;
+  } else if(OPTION("--size")) {
+    m_size = parseSize(value);
+  } else if(OPTION("--seed")) {
+    m_seed = strtoull(value, nullptr, 10);
+  } else {
+    return NO;
+  }
+#undef OPTION
+
+  return YES;
+}
+
+//
+
+CorpusGenerator::CorpusGenerator(const CorpusOptions& options)
+    : m_options(options),
+      m_fp(nullptr),
+      m_size(0),
+      m_random(0),
+      m_wordOffset(0),
+      m_numLocals(0) {}
+
+uint64_t CorpusGenerator::write(FILE* fp) {
+  m_fp = fp;
+  m_size = 0;
+  m_random = m_options.m_seed * 0x9e3779b97f4a7c15ULL + 1;
+
+  // Every seed starts at another word so it names modules, classes and
+  // functions differently. The default seed keeps the first words.
+  m_wordOffset = static_cast<int>(((m_options.m_seed - 1) * 0x9e3779b97f4a7c15ULL) >> 44);
+
+  for(int i = 0; ; ++i) {
+    if(0 == m_options.m_size ? i >= m_options.m_numModules : m_size >= m_options.m_size) {
+      break;
+    }
+
+    module(i);
+  }
+
+  return m_size;
+}
+
+uint32_t CorpusGenerator::next() {
+  // xorshift64*
+  m_random ^= m_random >> 12;
+  m_random ^= m_random << 25;
+  m_random ^= m_random >> 27;
+  return static_cast<uint32_t>((m_random * 0x2545f4914f6cdd1dULL) >> 32);
+}
+
+uint32_t CorpusGenerator::next(uint32_t bound) {
+  return 0 == bound ? 0 : next() % bound;
+}
+
+void CorpusGenerator::print(const char* format, ...) {
+  va_list args;
+
+  va_start(args, format);
+  const auto result = vfprintf(m_fp, format, args);
+  va_end(args);
+
+  if(result > 0) {
+    m_size += static_cast<uint64_t>(result);
+  }
+}
+
+void CorpusGenerator::indent(int level) {
+  print("%*s", level * 2, "");
+}
+
+void CorpusGenerator::word(int index) {
+  // Words are built from syllables so they are pronounceable. Longer
+  // words are mixed in so identifiers do not all have the same length.
+  char chars[32];
+  int length = 0;
+  int numSyllables = 2 + index % 3;
+  int value = index;
+
+  while(numSyllables-- > 0 || value > 0) {
+    const auto syllable = value % kNumSyllables;
+
+    chars[length++] = kConsonants[syllable / kNumVowels];
+    chars[length++] = kVowels[syllable % kNumVowels];
+    value /= kNumSyllables;
+  }
+
+  chars[length] = '\0';
+
+  // A keyword gets a suffix that no other word has since words are
+  // otherwise made of whole syllables.
+  for(const auto keyword : kKeywords) {
+    if(0 == strcmp(chars, keyword)) {
+      chars[length++] = 'x';
+      chars[length] = '\0';
+      break;
+    }
+  }
+
+  print("%s", chars);
+}
+
+void CorpusGenerator::name(int index) {
+  const auto numNames = m_options.m_numNames > 0 ? m_options.m_numNames : 1;
+
+  word(m_wordOffset + index % numNames);
+
+  if(index >= numNames) {
+    print("%d", index / numNames);
+  }
+}
+
+void CorpusGenerator::local(int id) {
+  print("v");
+  name(id < 0 ? -id : id);
+}
+
+void CorpusGenerator::module(int index) {
+  print("module m");
+  name(index);
+  print(" {\n");
+
+  for(int i = 0; i < m_options.m_numClasses; ++i) {
+    klass(index, i);
+  }
+
+  for(int i = 0; i < m_options.m_numFunctions; ++i) {
+    function(i);
+  }
+
+  print("}\n");
+}
+
+void CorpusGenerator::klass(int module, int index) {
+  const auto numOverloads = m_options.m_numOverloads > 0 ? m_options.m_numOverloads : 1;
+
+  indent(1);
+  print("class C");
+  name(module * m_options.m_numClasses + index);
+  print("[T] {\n");
+
+  for(int i = 0; i < kNumOperators; ++i) {
+    for(int arity = 1; arity <= numOverloads; ++arity) {
+      indent(2);
+      print("def %s(that: Int", kOperators[i]);
+
+      for(int j = 1; j < arity; ++j) {
+        print(", p%d: Int", j);
+      }
+
+      print("): Int = that\n");
+    }
+  }
+
+  for(int i = 0; i < m_options.m_numMembers; ++i) {
+    const auto arity = 1 + i % numOverloads;
+
+    indent(2);
+    print("def ");
+    name(i / numOverloads);
+    print("(p0: Int");
+
+    for(int j = 1; j < arity; ++j) {
+      print(", p%d: Int", j);
+    }
+
+    print("): Int = p%d\n", next(arity));
+  }
+
+  indent(1);
+  print("}\n");
+}
+
+void CorpusGenerator::function(int index) {
+  const auto numOverloads = m_options.m_numOverloads > 0 ? m_options.m_numOverloads : 1;
+  const auto arity = 1 + index % numOverloads;
+
+  indent(1);
+  print("def ");
+  name(index / numOverloads);
+  print("(p0: Int");
+
+  for(int i = 1; i < arity; ++i) {
+    print(", p%d: Int", i);
+  }
+
+  print("): Int = ");
+
+  m_locals.clear();
+  m_numLocals = 0;
+
+  if(m_options.m_depth > 0) {
+    block(1, m_options.m_depth, arity, m_options.m_numFunctions);
+  } else {
+    call(arity, m_options.m_numFunctions, 0);
+  }
+
+  print("\n");
+}
+
+void CorpusGenerator::block(int level, int depth, int arity, int numFunctions) {
+  const auto numVisible = m_locals.size();
+
+  print("{\n");
+
+  for(int i = 0; i < m_options.m_numStatements; ++i) {
+    indent(level + 1);
+
+    switch(next(4)) {
+      case 0: {
+          const auto id = ++m_numLocals;
+
+          print("val ");
+          local(id);
+          print(" = ");
+          call(arity, numFunctions, static_cast<int>(m_locals.size()));
+          m_locals.push_back(id);
+        }
+        break;
+      case 1: {
+          const auto id = ++m_numLocals;
+
+          print("var ");
+          local(id);
+          print(" = p%d", next(arity));
+          m_locals.push_back(-id);
+        }
+        break;
+      case 2:
+        if(depth > 1) {
+          print("if {\n");
+          indent(level + 2);
+          print("p%d -> p%d\n", next(arity), next(arity));
+          indent(level + 2);
+          print("p%d -> ", next(arity));
+          block(level + 2, depth - 1, arity, numFunctions);
+          print("\n");
+          indent(level + 1);
+          print("}");
+          break;
+        }
+        // fall through
+      default: {
+          int target = 0;
+
+          for(auto id : m_locals) {
+            if(id < 0 && 0 == next(2)) {
+              target = id;
+            }
+          }
+
+          if(0 != target) {
+            local(target);
+            print(" = ");
+          }
+
+          call(arity, numFunctions, static_cast<int>(m_locals.size()));
+        }
+        break;
+    }
+
+    print("\n");
+  }
+
+  indent(level + 1);
+  call(arity, numFunctions, static_cast<int>(m_locals.size()));
+  print("\n");
+  indent(level);
+  print("}");
+
+  m_locals.resize(numVisible);
+}
+
+void CorpusGenerator::call(int arity, int numFunctions, int numLocals) {
+  const auto numOverloads = m_options.m_numOverloads > 0 ? m_options.m_numOverloads : 1;
+  const auto callee = static_cast<int>(next(numFunctions > 0 ? numFunctions : 1));
+  const auto calleeArity = 1 + callee % numOverloads;
+
+  name(callee / numOverloads);
+  print("(");
+
+  for(int i = 0; i < calleeArity; ++i) {
+    if(i > 0) {
+      print(", ");
+    }
+
+    // Arguments are parameters or locals of the caller.
+    const auto value = static_cast<int>(next(static_cast<uint32_t>(arity + numLocals)));
+
+    if(value < arity) {
+      print("p%d", value);
+    } else {
+      local(m_locals[value - arity]);
+    }
+  }
+
+  print(")");
+}
+} //namespace bench
+} //namespace brutus
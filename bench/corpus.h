@@ -0,0 +1,90 @@
+#ifndef BRUTUS_BENCH_CORPUS_H_
+#define BRUTUS_BENCH_CORPUS_H_
+
+#include <cstdio>
+#include <vector>
+
+#include "brutus.h"
+
+namespace brutus {
+  namespace bench {
+    class CorpusOptions {
+      public:
+        CorpusOptions()
+            : m_numModules(10),
+              m_numClasses(2),
+              m_numMembers(4),
+              m_numFunctions(20),
+              m_numStatements(4),
+              m_depth(2),
+              m_numNames(64),
+              m_numOverloads(2),
+              m_size(0),
+              m_seed(1) {}
+
+        // Sets the option of an argument like --modules=10. Returns NO
+        // if the argument is no option of the generator.
+        bool parse(const char* arg);
+
+        int m_numModules;     // modules, unless a size is given
+        int m_numClasses;     // classes per module
+        int m_numMembers;     // methods per class besides the operators
+        int m_numFunctions;   // functions per module
+        int m_numStatements;  // statements per block
+        int m_depth;          // nesting depth of blocks in function bodies
+        int m_numNames;       // distinct words identifiers are built from
+        int m_numOverloads;   // overloads of every operator and function name
+        uint64_t m_size;      // stop after the module that reaches this many bytes
+        uint64_t m_seed;
+    };
+
+    // Writes a Brutus program that the parser accepts and the compiler
+    // links without errors.
+    //
+    // Every module has classes in the style of the Int8 class of the
+    // prelude: each operator is overloaded with one to numOverloads
+    // parameters. Functions share their name with numOverloads - 1
+    // other functions of different arity and their bodies declare
+    // values and variables, assign and call other functions of the
+    // module and branch with nested if expressions.
+    //
+    // The output only depends on the options. The random numbers come
+    // from a generator of our own so the same seed yields the same
+    // program on every platform.
+    class CorpusGenerator {
+      public:
+        explicit CorpusGenerator(const CorpusOptions& options);
+
+        // Returns the number of bytes written.
+        uint64_t write(FILE* fp);
+
+      private:
+        const CorpusOptions m_options;
+        FILE* m_fp;
+        uint64_t m_size;
+        uint64_t m_random;
+        int m_wordOffset;
+        int m_numLocals;
+
+        // Locals that are visible at the current point of a function
+        // body. A negative id is a variable that may be assigned.
+        std::vector<int> m_locals;
+
+        uint32_t next();
+        uint32_t next(uint32_t bound);
+        void print(const char* format, ...);
+        void indent(int level);
+        void word(int index);
+        void name(int index);
+        void local(int index);
+        void module(int index);
+        void klass(int module, int index);
+        void function(int index);
+        void block(int level, int depth, int arity, int numFunctions);
+        void call(int arity, int numFunctions, int numLocals);
+
+        DISALLOW_COPY_AND_ASSIGN(CorpusGenerator);
+    }; //class CorpusGenerator
+  } //namespace bench
+} //namespace brutus
+#endif
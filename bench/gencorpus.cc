@@ -0,0 +1,78 @@
+// Writes a deterministic Brutus program for benchmarks.
+//
+// Usage: brutus_corpus [--option=value ...] [output]
+//
+// Options:
+//   --modules=N     number of modules (default 10)
+//   --classes=N     classes per module (default 2)
+//   --members=N     methods per class besides the operators (default 4)
+//   --functions=N   functions per module (default 20)
+//   --statements=N  statements per block (default 4)
+//   --depth=N       nesting depth of function bodies (default 2)
+//   --names=N       distinct words identifiers are built from (default 64)
+//   --overloads=N   overloads of every operator and function (default 2)
+//   --size=N[KMG]   write modules until the output has this size
+//   --seed=N        seed of the generator (default 1)
+//   --help          print this message
+//
+// The program is written to stdout unless an output file is given.
+
+#include <cstring>
+#include <iostream>
+
+#include "corpus.h"
+
+using namespace brutus::bench;
+
+static const char* const kUsage =
+  "Usage: brutus_corpus [--option=value ...] [output]\n"
+  "\n"
+  "Options:\n"
+  "  --modules=N     number of modules (default 10)\n"
+  "  --classes=N     classes per module (default 2)\n"
+  "  --members=N     methods per class besides the operators (default 4)\n"
+  "  --functions=N   functions per module (default 20)\n"
+  "  --statements=N  statements per block (default 4)\n"
+  "  --depth=N       nesting depth of function bodies (default 2)\n"
+  "  --names=N       distinct words identifiers are built from (default 64)\n"
+  "  --overloads=N   overloads of every operator and function (default 2)\n"
+  "  --size=N[KMG]   write modules until the output has this size\n"
+  "  --seed=N        seed of the generator (default 1)\n"
+  "  --help          print this message\n";
+
+int main(int argc, char** argv) {
+  CorpusOptions options;
+  const char* path = nullptr;
+
+  for(int i = 1; i < argc; ++i) {
+    if(0 == strcmp(argv[i], "--help")) {
+      std::cout << kUsage;
+      return 0;
+    } else if(0 == strncmp(argv[i], "--", 2)) {
+      if(!options.parse(argv[i])) {
+        std::cerr << "Unknown option \"" << argv[i] << "\"." << std::endl;
+        std::cerr << kUsage;
+        return 1;
+      }
+    } else {
+      path = argv[i];
+    }
+  }
+
+  auto fp = nullptr == path ? stdout : fopen(path, "w");
+
+  if(!fp) {
+    std::cerr << "Could not write \"" << path << "\"." << std::endl;
+    return 1;
+  }
+
+  CorpusGenerator generator(options);
+  const auto size = generator.write(fp);
+
+  if(nullptr != path) {
+    fclose(fp);
+    std::cerr << "Wrote " << size << " bytes to \"" << path << "\"." << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,681 @@
+// Micro benchmarks of the data structures the compiler spends most of
+// its time in.
+//
+// Usage: brutus_microbench [--option=value ...] [filter]
+//
+// Options:
+//   --samples=N       measured samples of each benchmark (default 15)
+//   --warmup=N        samples that are not measured (default 2)
+//   --json=PATH       writes the results as JSON
+//   --baseline=PATH   compares the results with JSON written earlier
+//   --threshold=N     percent the median of a benchmark may exceed the
+//                     baseline before it counts as a regression (default 5)
+//
+// Only benchmarks whose name contains the filter are run.
+//
+// A sample times a fixed number of operations and every value reported
+// is in nanoseconds per operation. The inputs are built before the
+// clock starts and do not depend on anything but the benchmark, so two
+// runs on the same machine measure the same work. Compare the medians,
+// the minimum is the best case and p90 shows how noisy the machine is.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "brutus.h"
+#include "arena.h"
+#include "ast.h"
+#include "lexer.h"
+#include "name.h"
+#include "scopes.h"
+#include "stats.h"
+#include "stopwatch.h"
+#include "streams.h"
+#include "symbols.h"
+
+using namespace brutus;
+using namespace brutus::internal;
+using namespace brutus::bench;
+
+namespace {
+// Results are summed up here so the compiler cannot drop the work.
+volatile uintptr_t g_sink = 0;
+
+// Times numOps operations with the given stopwatch. Setup that must
+// not be measured happens before the stopwatch is resumed.
+typedef std::function<void(Stopwatch* stopwatch, int numOps)> Body; //NOLINT
+
+class Benchmark {
+  public:
+    std::string m_name;
+    int m_numOps;
+    Body m_body;
+};
+
+class Options {
+  public:
+    Options()
+        : m_samples(15),
+          m_warmup(2),
+          m_json(nullptr),
+          m_baseline(nullptr),
+          m_threshold(5.0),
+          m_filter(nullptr) {}
+
+    int m_samples;
+    int m_warmup;
+    const char* m_json;
+    const char* m_baseline;
+    double m_threshold;
+    const char* m_filter;
+};
+
+const char* valueOf(const char* arg, const char* option) {
+  const auto length = strlen(option);
+
+  if(0 == strncmp(arg, option, length) && '=' == arg[length]) {
+    return arg + length + 1;
+  }
+
+  return nullptr;
+}
+
+bool parseOption(const char* arg, Options* options) {
+  const char* value;
+
+  if(nullptr != (value = valueOf(arg, "--samples"))) {
+    options->m_samples = atoi(value) > 0 ? atoi(value) : 1;
+  } else if(nullptr != (value = valueOf(arg, "--warmup"))) {
+    options->m_warmup = atoi(value);
+  } else if(nullptr != (value = valueOf(arg, "--json"))) {
+    options->m_json = value;
+  } else if(nullptr != (value = valueOf(arg, "--baseline"))) {
+    options->m_baseline = value;
+  } else if(nullptr != (value = valueOf(arg, "--threshold"))) {
+    options->m_threshold = atof(value);
+  } else {
+    return NO;
+  }
+
+  return YES;
+}
+
+Arena* newArena() {
+  // Same configuration as the arena of a compilation unit.
+  auto arena = new Arena(
+    /*initialCapacity = */consts::PageSize * 4,
+    /*blockSize = */consts::PageSize * 4,
+    /*alignment = */consts::Alignment);
+  arena->init();
+  return arena;
+}
+
+void deleteArena(Arena* arena) {
+  arena->deleteAll();
+  delete arena;
+}
+
+// Distinct names like the identifiers of a program, "n0", "n1" and so on.
+std::vector<std::string> names(int count, const char* prefix) {
+  std::vector<std::string> result;
+
+  for(int i = 0; i < count; ++i) {
+    result.push_back(prefix + std::to_string(i));
+  }
+
+  return result;
+}
+
+syms::Symbol* newSymbol(Arena* arena, NameId name) {
+  auto symbol = new (arena) syms::VariableSymbol();
+  symbol->init(name, nullptr, nullptr);
+  return symbol;
+}
+
+//
+
+void addArenaBenchmarks(std::vector<Benchmark>* benchmarks) {
+  static const int kSizes[] = { 8, 32, 128, 1024 };
+
+  for(auto size : kSizes) {
+    // Large sizes get fewer operations so a sample never allocates
+    // more than 16MB.
+    const auto numOps = std::min(100000, 16 * consts::MegaByte / size);
+
+    benchmarks->push_back({"Arena::alloc/" + std::to_string(size), numOps,
+      [size](Stopwatch* stopwatch, int numOps) {
+        auto arena = newArena();
+        uintptr_t sum = 0;
+
+        stopwatch->resume();
+
+        for(int i = 0; i < numOps; ++i) {
+          sum += reinterpret_cast<uintptr_t>(arena->alloc(size));
+        }
+
+        stopwatch->stop();
+
+        g_sink += sum;
+        deleteArena(arena);
+      }});
+  }
+}
+
+void addNameTableBenchmarks(std::vector<Benchmark>* benchmarks) {
+  static const int kNumNames = 4096;
+
+  benchmarks->push_back({"NameTable::get/hit", 100000,
+    [](Stopwatch* stopwatch, int numOps) {
+      NameTable table;
+      const auto values = names(kNumNames, "n");
+      NameId sum = 0;
+
+      for(auto& value : values) {
+        table.get(value.c_str(), static_cast<int>(value.size()));
+      }
+
+      stopwatch->resume();
+
+      for(int i = 0; i < numOps; ++i) {
+        auto& value = values[i & (kNumNames - 1)];
+        sum += table.get(value.c_str(), static_cast<int>(value.size()));
+      }
+
+      stopwatch->stop();
+
+      g_sink += sum;
+    }});
+
+  // The parse workers intern the identifiers of their units at the same
+  // time, and nearly all of them exist already.
+  benchmarks->push_back({"NameTable::get/hit-4-threads", 100000,
+    [](Stopwatch* stopwatch, int numOps) {
+      static const int kNumThreads = 4;
+
+      NameTable table;
+      const auto values = names(kNumNames, "n");
+      std::vector<std::thread> threads;
+      std::atomic<NameId> sum(0);
+
+      for(auto& value : values) {
+        table.get(value.c_str(), static_cast<int>(value.size()));
+      }
+
+      stopwatch->resume();
+
+      for(int t = 0; t < kNumThreads; ++t) {
+        threads.push_back(std::thread([&, t]() {
+          NameId local = 0;
+
+          for(int i = t; i < numOps; i += kNumThreads) {
+            auto& value = values[i & (kNumNames - 1)];
+            local += table.get(value.c_str(), static_cast<int>(value.size()));
+          }
+
+          sum += local;
+        }));
+      }
+
+      for(auto& thread : threads) {
+        thread.join();
+      }
+
+      stopwatch->stop();
+
+      g_sink += sum;
+    }});
+
+  // Every name is new so each call interns it.
+  benchmarks->push_back({"NameTable::get/miss", 100000,
+    [](Stopwatch* stopwatch, int numOps) {
+      NameTable table;
+      const auto values = names(numOps, "n");
+      NameId sum = 0;
+
+      stopwatch->resume();
+
+      for(int i = 0; i < numOps; ++i) {
+        auto& value = values[i];
+        sum += table.get(value.c_str(), static_cast<int>(value.size()));
+      }
+
+      stopwatch->stop();
+
+      g_sink += sum;
+    }});
+
+  benchmarks->push_back({"NameTable::find/miss", 100000,
+    [](Stopwatch* stopwatch, int numOps) {
+      NameTable table;
+      const auto values = names(kNumNames, "n");
+      const auto misses = names(kNumNames, "m");
+      NameId sum = 0;
+
+      for(auto& value : values) {
+        table.get(value.c_str(), static_cast<int>(value.size()));
+      }
+
+      stopwatch->resume();
+
+      for(int i = 0; i < numOps; ++i) {
+        auto& value = misses[i & (kNumNames - 1)];
+        sum += table.find(value.c_str(), static_cast<int>(value.size()));
+      }
+
+      stopwatch->stop();
+
+      g_sink += sum;
+    }});
+}
+
+// The benchmarks of Scope::get measure lookups that hit what a scope
+// has remembered. A remembered result must not outlive a change of the
+// scopes it has been resolved through, which is checked here first.
+bool checkScopes() {
+  auto arena = newArena();
+  NameTable table;
+  const auto name = table.get("n", 1);
+  bool result = YES;
+
+  // A scope only depends on the versions of its parents, so neither
+  // another root, like that of another compiler, nor a sibling makes
+  // it forget what it has resolved.
+  auto other = new (arena) syms::Scope(arena);
+  other->init(nullptr, syms::ScopeKind::kModule);
+
+  auto parent = new (arena) syms::Scope(arena);
+  parent->init(nullptr, syms::ScopeKind::kModule);
+
+  auto child = new (arena) syms::Scope(arena);
+  child->init(parent, syms::ScopeKind::kBlock);
+
+  if(nullptr != child->get(name)) {
+    std::cerr << "Scope::get found a name that has not been put." << std::endl;
+    result = NO;
+  }
+
+  other->put(name, newSymbol(arena, name));
+
+  if(nullptr != child->get(name)) {
+    std::cerr << "Scope::get found a name of another root." << std::endl;
+    result = NO;
+  }
+
+  auto symbol = newSymbol(arena, name);
+  parent->put(name, symbol);
+
+  if(symbol != child->get(name)) {
+    std::cerr << "Scope::get kept a miss after a put in the parent." << std::endl;
+    result = NO;
+  }
+
+  // A symbol put into a scope between the one that looks it up and
+  // the one it has been found in hides the latter.
+  auto grandchild = new (arena) syms::Scope(arena);
+  grandchild->init(child, syms::ScopeKind::kBlock);
+
+  if(symbol != grandchild->get(name)) {
+    std::cerr << "Scope::get did not find a name of a grandparent." << std::endl;
+    result = NO;
+  }
+
+  auto shadow = newSymbol(arena, name);
+  child->put(name, shadow);
+
+  if(shadow != grandchild->get(name)) {
+    std::cerr << "Scope::get kept a symbol that a put in its parent hides." << std::endl;
+    result = NO;
+  }
+
+  child->remove(shadow);
+  parent->remove(symbol);
+
+  if(nullptr != child->get(name) || nullptr != grandchild->get(name)) {
+    std::cerr << "Scope::get kept a symbol after it has been removed." << std::endl;
+    result = NO;
+  }
+
+  deleteArena(arena);
+
+  return result;
+}
+
+void addScopeBenchmarks(std::vector<Benchmark>* benchmarks) {
+  static const int kDepths[] = { 1, 4, 16 };
+  static const int kNamesPerScope = 8;
+
+  // The names are declared in the outermost scope and looked up from
+  // the innermost one, like a reference to a module member from a
+  // nested block.
+  for(auto depth : kDepths) {
+    benchmarks->push_back({"Scope::get/depth-" + std::to_string(depth), 100000,
+      [depth](Stopwatch* stopwatch, int numOps) {
+        auto arena = newArena();
+        NameTable table;
+        const auto values = names(kNamesPerScope * depth, "n");
+        std::vector<NameId> ids;
+        syms::Scope* scope = nullptr;
+        uintptr_t sum = 0;
+
+        for(int level = 0; level < depth; ++level) {
+          auto child = new (arena) syms::Scope(arena);
+          child->init(scope, nullptr == scope ? syms::ScopeKind::kModule : syms::ScopeKind::kBlock);
+
+          for(int i = 0; i < kNamesPerScope; ++i) {
+            auto& value = values[level * kNamesPerScope + i];
+            const auto name = table.get(value.c_str(), static_cast<int>(value.size()));
+
+            child->put(name, newSymbol(arena, name));
+
+            if(0 == level) {
+              ids.push_back(name);
+            }
+          }
+
+          scope = child;
+        }
+
+        stopwatch->resume();
+
+        for(int i = 0; i < numOps; ++i) {
+          sum += reinterpret_cast<uintptr_t>(scope->get(ids[i & (kNamesPerScope - 1)]));
+        }
+
+        stopwatch->stop();
+
+        g_sink += sum;
+        deleteArena(arena);
+      }});
+  }
+
+  // Lookups from a nested block while symbols are put into the scopes
+  // of other functions of the same module, like the link of a unit
+  // while the symbols of another one are entered. The puts must not
+  // make the lookups forget what they have resolved.
+  benchmarks->push_back({"Scope::get/interleaved-puts", 100000,
+    [](Stopwatch* stopwatch, int numOps) {
+      static const int kDepth = 4;
+      static const int kLookupsPerPut = 4;
+
+      auto arena = newArena();
+      NameTable table;
+      const auto values = names(kNamesPerScope, "n");
+      const auto others = names(kNamesPerScope, "m");
+      std::vector<NameId> ids;
+      std::vector<syms::Symbol*> symbols;
+      std::vector<syms::Scope*> siblings;
+      syms::Scope* module = nullptr;
+      syms::Scope* scope = nullptr;
+      uintptr_t sum = 0;
+
+      for(auto& value : values) {
+        ids.push_back(table.get(value.c_str(), static_cast<int>(value.size())));
+      }
+
+      module = new (arena) syms::Scope(arena);
+      module->init(nullptr, syms::ScopeKind::kModule);
+
+      for(auto id : ids) {
+        module->put(id, newSymbol(arena, id));
+      }
+
+      scope = module;
+
+      for(int level = 1; level < kDepth; ++level) {
+        auto child = new (arena) syms::Scope(arena);
+        child->init(scope, syms::ScopeKind::kBlock);
+        scope = child;
+      }
+
+      // Each sibling gets as many symbols as a small function.
+      for(int i = 0; i < numOps / kLookupsPerPut; ++i) {
+        auto& value = others[i & (kNamesPerScope - 1)];
+        symbols.push_back(newSymbol(arena, table.get(value.c_str(), static_cast<int>(value.size()))));
+
+        if(0 == i % kNamesPerScope) {
+          siblings.push_back(new (arena) syms::Scope(arena));
+          siblings.back()->init(module, syms::ScopeKind::kFunction);
+        }
+      }
+
+      stopwatch->resume();
+
+      for(int i = 0; i < numOps; ++i) {
+        if(0 == i % kLookupsPerPut) {
+          const int j = i / kLookupsPerPut;
+          siblings[j / kNamesPerScope]->put(symbols[j]);
+        }
+
+        sum += reinterpret_cast<uintptr_t>(scope->get(ids[i & (kNamesPerScope - 1)]));
+      }
+
+      stopwatch->stop();
+
+      g_sink += sum;
+      deleteArena(arena);
+    }});
+
+  // Symbols are put into scopes of the size of a class. Every fourth
+  // symbol has a name of its own, the others overload one of the names
+  // before it like the operators of a class. The arena cannot allocate
+  // the table of a scope with many thousand names.
+  benchmarks->push_back({"Scope::putOrOverload", 20000,
+    [](Stopwatch* stopwatch, int numOps) {
+      static const int kSymbolsPerScope = 64;
+
+      auto arena = newArena();
+      NameTable table;
+      const auto values = names(kSymbolsPerScope / 4, "n");
+      std::vector<syms::Symbol*> symbols;
+      std::vector<syms::Scope*> scopes;
+      uintptr_t sum = 0;
+
+      for(int i = 0; i < numOps; ++i) {
+        auto& value = values[(i % kSymbolsPerScope) / 4];
+        symbols.push_back(newSymbol(arena, table.get(value.c_str(), static_cast<int>(value.size()))));
+
+        if(0 == i % kSymbolsPerScope) {
+          scopes.push_back(new (arena) syms::Scope(arena));
+          scopes.back()->init(nullptr, syms::ScopeKind::kClass);
+        }
+      }
+
+      stopwatch->resume();
+
+      for(int i = 0; i < numOps; ++i) {
+        auto scope = scopes[i / kSymbolsPerScope];
+        sum += reinterpret_cast<uintptr_t>(scope->putOrOverload(symbols[i]->name(), symbols[i]));
+      }
+
+      stopwatch->stop();
+
+      g_sink += sum;
+      deleteArena(arena);
+    }});
+}
+
+void addNodeListBenchmarks(std::vector<Benchmark>* benchmarks) {
+  // Lists of the length of a typical block and of a large module. The
+  // arena cannot allocate much larger arrays at once.
+  static const int kLengths[] = { 8, 1024 };
+
+  for(auto length : kLengths) {
+    benchmarks->push_back({"NodeList::add/" + std::to_string(length), 100000,
+      [length](Stopwatch* stopwatch, int numOps) {
+        auto arena = newArena();
+        auto node = new (arena) ast::Identifier();
+        uintptr_t sum = 0;
+
+        stopwatch->resume();
+
+        for(int i = 0; i < numOps; i += length) {
+          ast::NodeList list;
+
+          for(int j = 0; j < length; ++j) {
+            list.add(node, arena);
+          }
+
+          sum += list.size();
+        }
+
+        stopwatch->stop();
+
+        g_sink += sum;
+        deleteArena(arena);
+      }});
+  }
+}
+
+// Lexes a text made of one kind of token. An operation is one token of
+// that kind including the whitespace that separates it from the next.
+void addLexerBenchmark(std::vector<Benchmark>* benchmarks, const char* kind,
+                       const char* const* tokens, int numTokens, const char* separator) {
+  static const int kNumOps = 50000;
+  std::string text;
+
+  for(int i = 0; i < kNumOps; ++i) {
+    text += tokens[i % numTokens];
+    text += separator;
+  }
+
+  benchmarks->push_back({std::string("Lexer::nextToken/") + kind, kNumOps,
+    [text](Stopwatch* stopwatch, int numOps) {
+      Lexer lexer;
+      MemoryCharStream stream(text.data(), text.size());
+      int count = 0;
+
+      UNUSED(numOps);
+      stopwatch->resume();
+      lexer.init(&stream);
+
+      while(Token::kEof != lexer.nextToken()) {
+        ++count;
+      }
+
+      stopwatch->stop();
+
+      g_sink += count;
+    }});
+}
+
+void addLexerBenchmarks(std::vector<Benchmark>* benchmarks) {
+  static const char* const kIdentifiers[] = { "x", "value", "numberOfElements", "m0", "Int" };
+  static const char* const kKeywords[] = { "def", "val", "var", "class", "module", "if", "this", "require" };
+  static const char* const kOperators[] = { "+", "-", "*", "/", "<", ">", "==", "++" };
+  static const char* const kPunctuation[] = { "(", ")", "[", "]", "{", "}", ",", ".", ":", "=", "->" };
+  static const char* const kNumbers[] = { "0", "1", "42", "65535", "3.14" };
+  static const char* const kStrings[] = { "\"\"", "\"a\"", "\"Hello, World\"" };
+  static const char* const kComments[] = { "// a comment", "/* a comment */" };
+  static const char* const kNewLines[] = { "" };
+
+#define LEXER_BENCHMARK(kind, tokens, separator) \
+  addLexerBenchmark(benchmarks, kind, tokens, sizeof(tokens) / sizeof(tokens[0]), separator) //NOLINT
+  LEXER_BENCHMARK("identifier", kIdentifiers, " ");
+  LEXER_BENCHMARK("keyword", kKeywords, " ");
+  LEXER_BENCHMARK("operator", kOperators, " ");
+  LEXER_BENCHMARK("punctuation", kPunctuation, " ");
+  LEXER_BENCHMARK("number", kNumbers, " ");
+  LEXER_BENCHMARK("string", kStrings, " ");
+  LEXER_BENCHMARK("comment", kComments, "\n");
+  LEXER_BENCHMARK("newline", kNewLines, "\n");
+#undef LEXER_BENCHMARK
+}
+
+Summary measure(const Benchmark& benchmark, const Options& options) {
+  std::vector<double> samples;
+
+  for(int i = 0; i < options.m_warmup + options.m_samples; ++i) {
+    Stopwatch stopwatch;
+
+    stopwatch.start();
+    stopwatch.stop();
+    benchmark.m_body(&stopwatch, benchmark.m_numOps);
+
+    if(i >= options.m_warmup) {
+      samples.push_back(static_cast<double>(stopwatch.totalNS()) / benchmark.m_numOps);
+    }
+  }
+
+  return Summary::of(benchmark.m_name, samples);
+}
+} //namespace
+
+int main(int argc, char** argv) {
+  Options options;
+
+  for(int i = 1; i < argc; ++i) {
+    if(0 == strncmp(argv[i], "--", 2)) {
+      if(!parseOption(argv[i], &options)) {
+        std::cerr << "Unknown option \"" << argv[i] << "\"." << std::endl;
+        return 1;
+      }
+    } else {
+      options.m_filter = argv[i];
+    }
+  }
+
+  if(!checkScopes()) {
+    return 1;
+  }
+
+  std::vector<Benchmark> benchmarks;
+
+  addArenaBenchmarks(&benchmarks);
+  addNameTableBenchmarks(&benchmarks);
+  addScopeBenchmarks(&benchmarks);
+  addNodeListBenchmarks(&benchmarks);
+  addLexerBenchmarks(&benchmarks);
+
+  std::vector<Summary> results;
+
+  for(auto& benchmark : benchmarks) {
+    if(nullptr == options.m_filter || std::string::npos != benchmark.m_name.find(options.m_filter)) {
+      results.push_back(measure(benchmark, options));
+    }
+  }
+
+  if(results.empty()) {
+    std::cerr << "No benchmark matches \"" << options.m_filter << "\"." << std::endl;
+    return 1;
+  }
+
+  printSummaries(std::cout, results, 1.0, "ns/op");
+
+  if(nullptr != options.m_json) {
+    std::ofstream output(options.m_json);
+
+    output << "{" << std::endl;
+    output << "  \"samples\": " << options.m_samples << "," << std::endl;
+    output << "  \"unit\": \"ns/op\"," << std::endl;
+    writeSummaries(output, results);
+    output << "}" << std::endl;
+
+    if(!output.good()) {
+      std::cerr << "Could not write \"" << options.m_json << "\"." << std::endl;
+      return 1;
+    }
+  }
+
+  if(nullptr != options.m_baseline) {
+    std::vector<Summary> baseline;
+
+    if(!readSummaries(options.m_baseline, &baseline)) {
+      std::cerr << "Could not read \"" << options.m_baseline << "\"." << std::endl;
+      return 1;
+    }
+
+    std::cout << std::endl;
+
+    if(compareSummaries(std::cout, results, baseline, options.m_threshold, 1.0, "ns/op") > 0) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
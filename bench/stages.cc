@@ -0,0 +1,386 @@
+// Measures every stage of the compiler on the same input.
+//
+// Usage: brutus_bench [--option=value ...] [input]
+//
+// Options:
+//   --warmup=N        runs of each stage that are not measured (default 3)
+//   --iterations=N    measured runs of each stage (default 20)
+//   --stages=a,b      only the given stages, out of stream, lex, parse,
+//                     symbols, link and end-to-end (default all)
+//   --json=PATH       writes the results as JSON
+//   --baseline=PATH   compares the results with JSON written earlier
+//   --threshold=N     percent the median of a stage may exceed the
+//                     baseline before it counts as a regression (default 5)
+//
+// Without an input file a program is generated. The options of
+// brutus_corpus select its shape and size.
+//
+// Every stage after lex starts from a fresh context and only the stage
+// itself is timed, the stages before it run untimed. The parse stage
+// includes lexing since the parser pulls tokens from the lexer.
+// The exit code is 1 if a stage regressed compared to the baseline.
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "brutus.h"
+#include "compiler.h"
+#include "context.h"
+#include "corpus.h"
+#include "lexer.h"
+#include "parser.h"
+#include "phases.h"
+#include "stats.h"
+#include "stopwatch.h"
+#include "streams.h"
+
+using namespace brutus;
+using namespace brutus::internal;
+using namespace brutus::bench;
+
+namespace {
+typedef std::function<Stopwatch::Rep()> Run; //NOLINT
+
+class BenchStage {
+  public:
+    const char* m_name;
+    Run m_run;
+};
+
+class Options {
+  public:
+    Options()
+        : m_warmup(3),
+          m_iterations(20),
+          m_stages(nullptr),
+          m_json(nullptr),
+          m_baseline(nullptr),
+          m_threshold(5.0),
+          m_input(nullptr) {}
+
+    int m_warmup;
+    int m_iterations;
+    const char* m_stages;
+    const char* m_json;
+    const char* m_baseline;
+    double m_threshold;
+    const char* m_input;
+    CorpusOptions m_corpus;
+};
+
+const char* valueOf(const char* arg, const char* option) {
+  const auto length = strlen(option);
+
+  if(0 == strncmp(arg, option, length) && '=' == arg[length]) {
+    return arg + length + 1;
+  }
+
+  return nullptr;
+}
+
+bool parseOption(const char* arg, Options* options) {
+  const char* value;
+
+  if(nullptr != (value = valueOf(arg, "--warmup"))) {
+    options->m_warmup = atoi(value);
+  } else if(nullptr != (value = valueOf(arg, "--iterations"))) {
+    options->m_iterations = std::max(1, atoi(value));
+  } else if(nullptr != (value = valueOf(arg, "--stages"))) {
+    options->m_stages = value;
+  } else if(nullptr != (value = valueOf(arg, "--json"))) {
+    options->m_json = value;
+  } else if(nullptr != (value = valueOf(arg, "--baseline"))) {
+    options->m_baseline = value;
+  } else if(nullptr != (value = valueOf(arg, "--threshold"))) {
+    options->m_threshold = atof(value);
+  } else {
+    return options->m_corpus.parse(arg);
+  }
+
+  return YES;
+}
+
+bool isSelected(const char* stages, const char* name) {
+  if(nullptr == stages) {
+    return YES;
+  }
+
+  const auto length = strlen(name);
+
+  for(auto p = stages; nullptr != p; p = strchr(p, ',')) {
+    if(',' == *p) {
+      ++p;
+    }
+
+    if(0 == strncmp(p, name, length) && (',' == p[length] || '\0' == p[length])) {
+      return YES;
+    }
+  }
+
+  return NO;
+}
+
+FILE* openInput(const Options& options) {
+  if(nullptr != options.m_input) {
+    return fopen(options.m_input, "r");
+  }
+
+  auto fp = tmpfile();
+
+  if(nullptr != fp) {
+    CorpusGenerator generator(options.m_corpus);
+    generator.write(fp);
+  }
+
+  return fp;
+}
+
+std::string readAll(FILE* fp) {
+  std::string result;
+  char buffer[0x1000];
+  size_t length;
+
+  rewind(fp);
+
+  while((length = fread(buffer, 1, sizeof(buffer), fp)) > 0) { //NOLINT
+    result.append(buffer, length);
+  }
+
+  return result;
+}
+
+// Parses the text into the unit like a parse worker does.
+void parse(Context* context, CompilationUnit* unit, const std::string& text) {
+  Lexer lexer;
+  Parser parser(&lexer, context->names(), unit->arena());
+  MemoryCharStream stream(text.data(), text.size());
+
+  parser.diagnostics(unit->diagnostics());
+  lexer.init(&stream);
+  unit->ast(parser.parseProgram());
+}
+
+Summary measure(const BenchStage& stage, const Options& options) {
+  std::vector<double> samples;
+
+  for(int i = 0; i < options.m_warmup; ++i) {
+    stage.m_run();
+  }
+
+  for(int i = 0; i < options.m_iterations; ++i) {
+    samples.push_back(static_cast<double>(stage.m_run()));
+  }
+
+  return Summary::of(stage.m_name, samples);
+}
+
+bool writeJson(const char* path, const std::vector<Summary>& results,
+               const Options& options, size_t numBytes, int numErrors) {
+  std::ofstream output(path);
+
+  if(!output) {
+    return NO;
+  }
+
+  output << "{" << std::endl;
+  output << "  \"input\": \"" << (nullptr == options.m_input ? "generated" : options.m_input) << "\"," << std::endl;
+
+  if(nullptr == options.m_input) {
+    output << "  \"seed\": " << options.m_corpus.m_seed << "," << std::endl;
+  }
+
+  output << "  \"bytes\": " << numBytes << "," << std::endl;
+  output << "  \"errors\": " << numErrors << "," << std::endl;
+  output << "  \"warmup\": " << options.m_warmup << "," << std::endl;
+  output << "  \"iterations\": " << options.m_iterations << "," << std::endl;
+  output << "  \"unit\": \"ns\"," << std::endl;
+  writeSummaries(output, results);
+  output << "}" << std::endl;
+
+  return output.good();
+}
+} //namespace
+
+int main(int argc, char** argv) {
+  Options options;
+
+  for(int i = 1; i < argc; ++i) {
+    if(0 == strncmp(argv[i], "--", 2)) {
+      if(!parseOption(argv[i], &options)) {
+        std::cerr << "Unknown option \"" << argv[i] << "\"." << std::endl;
+        return 1;
+      }
+    } else {
+      options.m_input = argv[i];
+    }
+  }
+
+  auto fp = openInput(options);
+
+  if(!fp) {
+    std::cerr << "Could not read \"" << (nullptr == options.m_input ? "tmpfile" : options.m_input) << "\"." << std::endl;
+    return 1;
+  }
+
+  const auto text = readAll(fp);
+  int numErrors = 0;
+
+  // Every stage checks its work against these so a stage that is
+  // optimized away or fails does not go unnoticed.
+  size_t numChars = 0;
+  int numTokens = 0;
+
+  std::vector<BenchStage> stages;
+
+  stages.push_back({"stream", [&]() -> Stopwatch::Rep {
+    Stopwatch stopwatch;
+    size_t count = 0;
+
+    rewind(fp);
+    FileCharStream stream(fp);
+
+    stopwatch.start();
+    stream.foreach([&count](char) { ++count; });
+    stopwatch.stop();
+
+    numChars = count;
+    return stopwatch.totalNS();
+  }});
+
+  stages.push_back({"lex", [&]() -> Stopwatch::Rep {
+    Stopwatch stopwatch;
+    Lexer lexer;
+    MemoryCharStream stream(text.data(), text.size());
+    int count = 0;
+
+    stopwatch.start();
+    lexer.init(&stream);
+
+    while(Token::kEof != lexer.nextToken()) {
+      ++count;
+    }
+
+    stopwatch.stop();
+
+    numTokens = count;
+    return stopwatch.totalNS();
+  }});
+
+  stages.push_back({"parse", [&]() -> Stopwatch::Rep {
+    Stopwatch stopwatch;
+    BenchContext context;
+    CompilationUnit unit;
+
+    stopwatch.start();
+    parse(&context, &unit, text);
+    stopwatch.stop();
+
+    numErrors = unit.diagnostics()->numErrors();
+    return stopwatch.totalNS();
+  }});
+
+  stages.push_back({"symbols", [&]() -> Stopwatch::Rep {
+    Stopwatch stopwatch;
+    BenchContext context;
+    CompilationUnit unit;
+    SymbolsPhase symbols(&context);
+
+    parse(&context, &unit, text);
+
+    stopwatch.start();
+    symbols.apply(&unit);
+    stopwatch.stop();
+
+    return stopwatch.totalNS();
+  }});
+
+  stages.push_back({"link", [&]() -> Stopwatch::Rep {
+    Stopwatch stopwatch;
+    BenchContext context;
+    CompilationUnit unit;
+    SymbolsPhase symbols(&context);
+    std::recursive_mutex dependencies;
+    LinkPhase link(&context, &dependencies);
+
+    parse(&context, &unit, text);
+    symbols.apply(&unit);
+
+    stopwatch.start();
+    link.apply(&unit);
+    stopwatch.stop();
+
+    numErrors = unit.diagnostics()->numErrors();
+    return stopwatch.totalNS();
+  }});
+
+  stages.push_back({"end-to-end", [&]() -> Stopwatch::Rep {
+    Stopwatch stopwatch;
+    auto compiler = new Compiler();
+
+    rewind(fp);
+    compiler->addSource(fp);
+
+    stopwatch.start();
+    compiler->compile();
+    stopwatch.stop();
+
+    numErrors = compiler->info()->totalErrors();
+    delete compiler;
+
+    return stopwatch.totalNS();
+  }});
+
+  std::vector<Summary> results;
+
+  for(auto& stage : stages) {
+    if(isSelected(options.m_stages, stage.m_name)) {
+      results.push_back(measure(stage, options));
+    }
+  }
+
+  fclose(fp);
+
+  if(results.empty()) {
+    std::cerr << "No such stage \"" << options.m_stages << "\"." << std::endl;
+    return 1;
+  }
+
+  if((0 != numChars && numChars != text.size()) || (isSelected(options.m_stages, "lex") && 0 == numTokens)) {
+    std::cerr << "Error: Read " << numChars << " characters and " << numTokens << " tokens of " << text.size() << " bytes." << std::endl;
+    return 1;
+  }
+
+  if(numErrors > 0) {
+    std::cerr << "Warning: The input has " << numErrors << " errors." << std::endl;
+  }
+
+  std::cout << "Input: " << text.size() << " bytes, " << numTokens << " tokens" << std::endl;
+  printSummaries(std::cout, results, 1000.0, "us");
+
+  if(nullptr != options.m_json && !writeJson(options.m_json, results, options, text.size(), numErrors)) {
+    std::cerr << "Could not write \"" << options.m_json << "\"." << std::endl;
+    return 1;
+  }
+
+  if(nullptr != options.m_baseline) {
+    std::vector<Summary> baseline;
+
+    if(!readSummaries(options.m_baseline, &baseline)) {
+      std::cerr << "Could not read \"" << options.m_baseline << "\"." << std::endl;
+      return 1;
+    }
+
+    std::cout << std::endl;
+
+    if(compareSummaries(std::cout, results, baseline, options.m_threshold, 1000.0, "us") > 0) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
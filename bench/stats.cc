@@ -0,0 +1,147 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+
+#include "stats.h"
+
+namespace brutus {
+namespace bench {
+static const int kNameWidth = 32;
+static const int kValueWidth = 12;
+
+static double percentile(const std::vector<double>& samples, size_t percent) {
+  const auto rank = (samples.size() * percent + 99) / 100;
+  return samples[rank > 0 ? rank - 1 : 0];
+}
+
+Summary Summary::of(const std::string& name, std::vector<double> samples) {
+  Summary result;
+  double total = 0.0;
+
+  std::sort(samples.begin(), samples.end());
+
+  for(auto sample : samples) {
+    total += sample;
+  }
+
+  result.m_name = name;
+  result.m_min = samples.front();
+  result.m_median = percentile(samples, 50);
+  result.m_p90 = percentile(samples, 90);
+  result.m_p99 = percentile(samples, 99);
+  result.m_max = samples.back();
+  result.m_mean = total / samples.size();
+
+  return result;
+}
+
+void printSummaries(std::ostream& output, const std::vector<Summary>& summaries,
+                    double scale, const char* unit) {
+  output
+    << std::left << std::setw(kNameWidth) << "name" << std::right
+    << std::setw(kValueWidth) << "min" << std::setw(kValueWidth) << "median"
+    << std::setw(kValueWidth) << "p90" << std::setw(kValueWidth) << "p99"
+    << "  (" << unit << ")" << std::endl;
+
+  output << std::fixed << std::setprecision(1);
+
+  for(auto& summary : summaries) {
+    output
+      << std::left << std::setw(kNameWidth) << summary.m_name << std::right
+      << std::setw(kValueWidth) << summary.m_min / scale
+      << std::setw(kValueWidth) << summary.m_median / scale
+      << std::setw(kValueWidth) << summary.m_p90 / scale
+      << std::setw(kValueWidth) << summary.m_p99 / scale
+      << std::endl;
+  }
+}
+
+void writeSummaries(std::ostream& output, const std::vector<Summary>& summaries) {
+  output << "  \"results\": [" << std::endl;
+  output << std::fixed << std::setprecision(2);
+
+  for(size_t i = 0; i < summaries.size(); ++i) {
+    auto& summary = summaries[i];
+
+    output
+      << "    {\"name\": \"" << summary.m_name << "\""
+      << ", \"min\": " << summary.m_min
+      << ", \"median\": " << summary.m_median
+      << ", \"p90\": " << summary.m_p90
+      << ", \"p99\": " << summary.m_p99
+      << ", \"max\": " << summary.m_max
+      << ", \"mean\": " << summary.m_mean
+      << "}" << (i + 1 < summaries.size() ? "," : "") << std::endl;
+  }
+
+  output << "  ]" << std::endl;
+}
+
+bool readSummaries(const char* path, std::vector<Summary>* summaries) {
+  std::ifstream input(path);
+  std::string line;
+
+  if(!input) {
+    return NO;
+  }
+
+  while(std::getline(input, line)) {
+    char name[64];
+    double min;
+    double median;
+
+    if(3 == sscanf(line.c_str(), " {\"name\": \"%63[^\"]\", \"min\": %lf, \"median\": %lf", name, &min, &median)) {
+      Summary summary;
+
+      summary.m_name = name;
+      summary.m_min = min;
+      summary.m_median = median;
+      summary.m_p90 = summary.m_p99 = summary.m_max = summary.m_mean = median;
+      summaries->push_back(summary);
+    }
+  }
+
+  return YES;
+}
+
+int compareSummaries(std::ostream& output, const std::vector<Summary>& summaries,
+                     const std::vector<Summary>& baseline, double threshold,
+                     double scale, const char* unit) {
+  int numRegressions = 0;
+
+  output
+    << std::left << std::setw(kNameWidth) << "name" << std::right
+    << std::setw(kValueWidth) << "baseline" << std::setw(kValueWidth) << "median"
+    << std::setw(kValueWidth) << "change" << "  (" << unit << ")" << std::endl;
+
+  output << std::fixed << std::setprecision(1);
+
+  for(auto& summary : summaries) {
+    for(auto& base : baseline) {
+      if(base.m_name != summary.m_name) {
+        continue;
+      }
+
+      const auto change = 0.0 == base.m_median
+        ? 0.0
+        : 100.0 * (summary.m_median - base.m_median) / base.m_median;
+      const bool isRegression = change > threshold;
+
+      output
+        << std::left << std::setw(kNameWidth) << summary.m_name << std::right
+        << std::setw(kValueWidth) << base.m_median / scale
+        << std::setw(kValueWidth) << summary.m_median / scale
+        << std::setw(kValueWidth - 1) << std::showpos << change << std::noshowpos
+        << '%' << (isRegression ? "  regression" : "") << std::endl;
+
+      if(isRegression) {
+        ++numRegressions;
+      }
+    }
+  }
+
+  return numRegressions;
+}
+} //namespace bench
+} //namespace brutus
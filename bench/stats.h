@@ -0,0 +1,47 @@
+#ifndef BRUTUS_BENCH_STATS_H_
+#define BRUTUS_BENCH_STATS_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "brutus.h"
+
+namespace brutus {
+  namespace bench {
+    // Statistics of the samples of one benchmark. Percentiles are
+    // taken by nearest rank.
+    class Summary {
+      public:
+        std::string m_name;
+        double m_min;
+        double m_median;
+        double m_p90;
+        double m_p99;
+        double m_max;
+        double m_mean;
+
+        static Summary of(const std::string& name, std::vector<double> samples);
+    }; //class Summary
+
+    // Prints a table of the summaries with every value divided by scale.
+    void printSummaries(std::ostream& output, const std::vector<Summary>& summaries,
+                        double scale, const char* unit);
+
+    // Writes the summaries as the "results" member of a JSON object,
+    // one summary per line so readSummaries needs no JSON parser.
+    void writeSummaries(std::ostream& output, const std::vector<Summary>& summaries);
+
+    // Reads the name, min and median of the summaries of a file that
+    // has been written with writeSummaries.
+    bool readSummaries(const char* path, std::vector<Summary>* summaries);
+
+    // Prints the change of the median of every summary that is also
+    // part of the baseline. Returns the number of summaries whose median
+    // exceeds the one of the baseline by more than threshold percent.
+    int compareSummaries(std::ostream& output, const std::vector<Summary>& summaries,
+                         const std::vector<Summary>& baseline, double threshold,
+                         double scale, const char* unit);
+  } //namespace bench
+} //namespace brutus
+#endif
@@ -0,0 +1,151 @@
+// Compares the cost of walking a large AST with the virtual ASTVisitor
+// and with forEachChild and measures SymbolsPhase on the same AST.
+//
+// Usage: brutus_visitorbench [--iterations=N] [--option=value ...]
+//
+// The program is generated, the options of brutus_corpus select its
+// shape and size.
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "brutus.h"
+#include "compiler.h"
+#include "context.h"
+#include "corpus.h"
+#include "phases.h"
+#include "stopwatch.h"
+#include "visitor.h"
+
+using namespace brutus;
+using namespace brutus::internal;
+using namespace brutus::bench;
+
+namespace {
+class VirtualCounter : public ast::ASTVisitor {
+  public:
+    VirtualCounter() : m_count(0) {}
+
+    using ast::ASTVisitor::visit;
+
+    void visit(ast::Identifier* node) override {
+      UNUSED(node);
+      ++m_count;
+    }
+
+    int m_count;
+};
+
+int countIdentifiers(ast::Node* node) {
+  if(ast::NodeKind::kIdentifier == node->kind()) {
+    return 1;
+  }
+
+  int result = 0;
+
+  ast::forEachChild(node, [&result](ast::Node* child) {
+    result += countIdentifiers(child);
+  });
+
+  return result;
+}
+
+void report(const char* name, Stopwatch::Rep totalNS, int iterations) {
+  std::cout << name << ": " << (totalNS / iterations) << "ns" << std::endl;
+}
+} //namespace
+
+int main(int argc, char** argv) {
+  const char* const iterationsOption = "--iterations=";
+  CorpusOptions corpus;
+  int iterations = 20;
+
+  for(int i = 1; i < argc; ++i) {
+    if(0 == strncmp(argv[i], iterationsOption, strlen(iterationsOption))) {
+      iterations = std::max(1, atoi(argv[i] + strlen(iterationsOption)));
+    } else if(!corpus.parse(argv[i])) {
+      std::cerr << "Unknown option \"" << argv[i] << "\"." << std::endl;
+      return 1;
+    }
+  }
+
+  auto fp = tmpfile();
+
+  if(nullptr == fp) {
+    std::cerr << "Could not create a temporary file." << std::endl;
+    return 1;
+  }
+
+  CorpusGenerator generator(corpus);
+  generator.write(fp);
+  rewind(fp);
+
+  BenchContext context;
+  ParsePhase parsePhase(&context, 1);
+  CompilationUnit unit;
+
+  unit.source(new FileSource(fp));
+  parsePhase.parse(&unit, 0);
+
+  Stopwatch virtualTime;
+  Stopwatch childTime;
+  int virtualCount = 0;
+  int childCount = 0;
+
+  virtualTime.start();
+  virtualTime.stop();
+  childTime.start();
+  childTime.stop();
+
+  for(int i = 0; i < iterations; ++i) {
+    VirtualCounter virtualCounter;
+
+    virtualTime.resume();
+    unit.ast()->accept(&virtualCounter);
+    virtualTime.stop();
+
+    childTime.resume();
+    childCount = countIdentifiers(unit.ast());
+    childTime.stop();
+
+    virtualCount = virtualCounter.m_count;
+  }
+
+  if(virtualCount != childCount) {
+    std::cerr << "Error: Walks disagree (" << virtualCount << " != " << childCount << ")." << std::endl;
+    fclose(fp);
+    return 1;
+  }
+
+  std::cout << "Identifiers: " << childCount << std::endl;
+  report("ASTVisitor", virtualTime.totalNS(), iterations);
+  report("forEachChild", childTime.totalNS(), iterations);
+
+  // SymbolsPhase enters into the global scope so every iteration gets
+  // a fresh context and AST.
+  Stopwatch symbolsTime;
+
+  symbolsTime.start();
+  symbolsTime.stop();
+
+  for(int i = 0; i < iterations; ++i) {
+    BenchContext symbolsContext;
+    ParsePhase symbolsParsePhase(&symbolsContext, 1);
+    SymbolsPhase symbolsPhase(&symbolsContext);
+    CompilationUnit symbolsUnit;
+
+    rewind(fp);
+    symbolsUnit.source(new FileSource(fp));
+    symbolsParsePhase.parse(&symbolsUnit, 0);
+
+    symbolsTime.resume();
+    symbolsPhase.apply(&symbolsUnit);
+    symbolsTime.stop();
+  }
+
+  report("SymbolsPhase", symbolsTime.totalNS(), iterations);
+
+  fclose(fp);
+  return 0;
+}
@@ -3,9 +3,160 @@
 
 #include <iostream>
 #include <functional>
+#include <cstddef>
 #include <cstdint>
 
+// Symbols of the public API are exported from a shared libbrutus and
+// everything else is hidden.
+#if defined(BRUTUS_SHARED)
+  #if defined(OS_WINDOWS)
+    #if defined(BRUTUS_IMPLEMENTATION)
+      #define BRUTUS_EXPORT __declspec(dllexport)
+    #else
+      #define BRUTUS_EXPORT __declspec(dllimport)
+    #endif
+  #else
+    #define BRUTUS_EXPORT __attribute__((visibility("default")))
+  #endif
+#else
+  #define BRUTUS_EXPORT
+#endif
+
+// The version of the compiler.
+#define BRUTUS_VERSION "0.1.0"
+
 namespace brutus {
-  //TODO(joa): public api
+  class Compiler;
+
+  enum class Severity {
+    kWarning,
+    kError
+  }; //enum Severity
+
+  enum class Format {
+    kText,
+    kJson
+  }; //enum Format
+
+  // The phases of a compile in order.
+  enum class Stage {
+    kParse,
+    kSymbols,
+    kLink
+  }; //enum Stage
+
+  // A diagnostic of a unit. The text is only valid while the function
+  // it has been passed to runs.
+  class Message {
+    public:
+      Severity m_severity;
+      int m_unit;
+      uint32_t m_line;
+      uint32_t m_column;
+      const char* m_text;
+  }; //class Message
+
+  // The compiler as a library.
+  //
+  // A session keeps its names and the declarations of loaded images
+  // from one compile to the next. A build system can keep a session
+  // per target around, update the units that changed and compile in
+  // its own process.
+  //
+  // Units are referred to by the index returned when they are added.
+  // A session must only be used by one thread at a time. Compiling
+  // itself uses a worker per core unless told otherwise.
+  class BRUTUS_EXPORT Session {
+    public:
+      Session();
+      ~Session();
+
+      // Compiles with the given number of workers, or a worker per
+      // core if it is not positive.
+      explicit Session(int numWorkers);
+
+      // Enters the declarations of a precompiled image, like the
+      // prelude written by brutus_mkimage.
+      bool loadImage(const char* path);
+
+      // Adds a unit and returns its index, or -1 if the file cannot
+      // be read. Large files are mapped instead of read.
+      int addFile(const char* path);
+
+      // Adds a copy of the given text as a unit.
+      int addSource(const char* text, size_t length);
+
+      // Adds a unit whose function bodies are only parsed when they
+      // are used, like the prelude if there is no image.
+      int addDependency(const char* path);
+
+      // Compiles the units that have been added since the last
+      // compile. Returns true if no unit has an error.
+      bool compile();
+
+      // Keeps the results of every compile in the given directory. A
+      // unit whose text did not change, and whose declarations and
+      // those of the other units are the same, is restored from there
+      // instead of compiled.
+      bool useBuildCache(const char* directory);
+
+      // Writes an interface file for every module that is compiled into
+      // the given directory. A module that requires another one which
+      // no unit declares is compiled against its interface file there,
+      // without its source.
+      bool useModulePath(const char* directory);
+
+      // Compiles no further than the given stage, which is kLink
+      // unless told otherwise.
+      void stopAfter(Stage stage);
+
+      // Replaces the text of a compiled unit. Only the declaration
+      // that changed is compiled again if possible, otherwise the
+      // whole unit. Returns false if the unit cannot be updated,
+      // like a dependency.
+      bool update(int unit, const char* text, size_t length);
+
+      // Removes all units that are not dependencies together with the
+      // modules they declare. Loaded images and dependencies stay, so
+      // the next compile starts from a warm prelude.
+      void clear();
+
+      int numUnits() const;
+      int numErrors() const;
+      int numWarnings() const;
+
+      // Calls f with every diagnostic of every unit in order.
+      void forEachMessage(std::function<void(const Message&)> f) const; //NOLINT
+
+      // Prints the diagnostics of all units, one per line.
+      void printMessages(std::ostream& output) const;
+
+      // Wall and CPU time of the last compile in nanoseconds.
+      uint64_t wallNS() const;
+      uint64_t cpuNS() const;
+
+      // Writes the time of every phase and the counters of the last
+      // compile as a table or as JSON.
+      void writeMetrics(std::ostream& output, Format format) const;
+
+      // Writes the memory held by the units, the shared declarations
+      // and the names together with the peak resident set size.
+      void writeMemoryReport(std::ostream& output) const;
+
+      // Writes the AST of every unit to the given file once it has
+      // been parsed.
+      bool dumpAst(const char* path, Format format);
+
+      // Records a trace of everything that is compiled from now on
+      // and writes it in the trace event format of Chrome.
+      void startTrace();
+      bool writeTrace(const char* path);
+
+    private:
+      Compiler* m_compiler;
+
+      Session(const Session&);
+      void operator=(const Session&);
+  }; //class Session
 } //namespace brutus
 #endif
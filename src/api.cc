@@ -0,0 +1,202 @@
+#include <sstream>
+
+#include "compiler.h"
+
+// The public API of include/brutus.h. Everything here only forwards to
+// the Compiler so the classes behind it can change freely.
+
+namespace brutus {
+static CompilationUnit* unitAt(Compiler* compiler, int index) {
+  CompilationUnit* result = nullptr;
+  int i = 0;
+
+  compiler->units()->foreach([&](CompilationUnit* unit) {
+    if(i++ == index) {
+      result = unit;
+    }
+  });
+
+  return result;
+}
+
+static int indexOf(Compiler* compiler, CompilationUnit* unit) {
+  return compiler->units()->indexOf(unit);
+}
+
+static internal::DumpFormat dumpFormatOf(Format format) {
+  return Format::kJson == format
+    ? internal::DumpFormat::kJson
+    : internal::DumpFormat::kText;
+}
+
+static internal::MetricPhase phaseOf(Stage stage) {
+  switch(stage) {
+    case Stage::kParse: return internal::MetricPhase::kParse;
+    case Stage::kSymbols: return internal::MetricPhase::kSymbols;
+    default: return internal::MetricPhase::kLink;
+  }
+}
+
+Session::Session()
+    : m_compiler(new Compiler()) {}
+
+Session::Session(int numWorkers)
+    : m_compiler(new Compiler(numWorkers)) {}
+
+Session::~Session() {
+  delete m_compiler;
+}
+
+bool Session::loadImage(const char* path) {
+  return m_compiler->loadImage(path);
+}
+
+int Session::addFile(const char* path) {
+  auto unit = m_compiler->addFile(path);
+
+  return nullptr == unit ? -1 : indexOf(m_compiler, unit);
+}
+
+int Session::addSource(const char* text, size_t length) {
+  return indexOf(m_compiler, m_compiler->addSource(text, length));
+}
+
+int Session::addDependency(const char* path) {
+  const auto index = addFile(path);
+
+  if(-1 != index) {
+    unitAt(m_compiler, index)->isDependency(YES);
+  }
+
+  return index;
+}
+
+bool Session::compile() {
+  m_compiler->compile();
+  return 0 == numErrors();
+}
+
+bool Session::useBuildCache(const char* directory) {
+  return m_compiler->useBuildCache(directory);
+}
+
+bool Session::useModulePath(const char* directory) {
+  return m_compiler->useModulePath(directory);
+}
+
+void Session::stopAfter(Stage stage) {
+  m_compiler->stopAfter(phaseOf(stage));
+}
+
+bool Session::update(int unit, const char* text, size_t length) {
+  auto compilationUnit = unitAt(m_compiler, unit);
+
+  if(nullptr == compilationUnit || !compilationUnit->isCompiled()) {
+    return NO;
+  }
+
+  const auto result = m_compiler->edit(
+    compilationUnit, 0, compilationUnit->text()->size(), text, length);
+
+  return internal::EditResult::kInvalid != result;
+}
+
+void Session::clear() {
+  auto units = m_compiler->units();
+  auto removed = internal::NewArray<CompilationUnit*>(units->size());
+  int numRemoved = 0;
+
+  units->foreach([&](CompilationUnit* unit) {
+    if(!unit->isDependency()) {
+      removed[numRemoved++] = unit;
+    }
+  });
+
+  for(int i = 0; i < numRemoved; ++i) {
+    m_compiler->remove(removed[i]);
+  }
+
+  internal::DeleteArray(removed);
+}
+
+int Session::numUnits() const {
+  return m_compiler->units()->size();
+}
+
+int Session::numErrors() const {
+  return m_compiler->info()->totalErrors();
+}
+
+int Session::numWarnings() const {
+  return m_compiler->info()->totalWarnings();
+}
+
+void Session::forEachMessage(std::function<void(const Message&)> f) const { //NOLINT
+  auto names = m_compiler->names();
+  int index = 0;
+
+  m_compiler->units()->foreach([&](CompilationUnit* unit) {
+    auto diagnostics = unit->diagnostics();
+
+    for(int i = 0; i < diagnostics->size(); ++i) {
+      auto& diagnostic = diagnostics->at(i);
+      std::ostringstream text;
+      Message message;
+
+      internal::Diagnostics::format(text, diagnostic, names);
+      unit->lines()->position(diagnostic.m_offset, &message.m_line, &message.m_column);
+
+      const auto value = text.str();
+
+      message.m_severity =
+        internal::Severity::kError == internal::Diagnostics::severityOf(diagnostic.m_code)
+          ? Severity::kError
+          : Severity::kWarning;
+      message.m_unit = index;
+      message.m_line += 1;
+      message.m_column += 1;
+      message.m_text = value.c_str();
+
+      f(message);
+    }
+
+    ++index;
+  });
+}
+
+void Session::printMessages(std::ostream& output) const {
+  m_compiler->printDiagnostics(output);
+}
+
+uint64_t Session::wallNS() const {
+  return m_compiler->metrics()->compile().m_wallNS;
+}
+
+uint64_t Session::cpuNS() const {
+  return m_compiler->metrics()->compile().m_cpuNS;
+}
+
+void Session::writeMetrics(std::ostream& output, Format format) const {
+  if(Format::kJson == format) {
+    m_compiler->metrics()->writeJson(output);
+  } else {
+    m_compiler->metrics()->print(output);
+  }
+}
+
+void Session::writeMemoryReport(std::ostream& output) const {
+  m_compiler->metrics()->printMemory(output);
+}
+
+bool Session::dumpAst(const char* path, Format format) {
+  return m_compiler->dumpAst(path, dumpFormatOf(format));
+}
+
+void Session::startTrace() {
+  m_compiler->startTrace();
+}
+
+bool Session::writeTrace(const char* path) {
+  return m_compiler->writeTrace(path);
+}
+} //namespace brutus
@@ -31,6 +31,11 @@ namespace brutus {
 
         void deleteAll();
 
+        // Bytes of all blocks the arena holds, used or not.
+        ALWAYS_INLINE int totalBytes() const {
+          return m_totalBytes;
+        }
+
       private:
         class ArenaBlock {
           public:
@@ -1,17 +1,20 @@
+#include <sstream>
+
 #include "ast.h"
 
 namespace brutus {
 namespace internal {
 namespace ast {
-Error::Error() : 
-  m_value(nullptr), 
-  m_line(0), 
-  m_column(0) {}
+Error::Error()
+    : m_code(DiagnosticCode::kInternalError) {
+  m_args[0] = 0;
+  m_args[1] = 0;
+}
 
-void Error::init(const char* value, unsigned int line, unsigned int column) {
-  m_value = value;
-  m_line = line;
-  m_column = column;
+void Error::init(DiagnosticCode code, uint32_t arg0, uint32_t arg1) {
+  m_code = code;
+  m_args[0] = arg0;
+  m_args[1] = arg1;
 }
 
 void Error::accept(ASTVisitor* visitor) {
@@ -22,23 +25,29 @@ NodeKind Error::kind() const {
   return NodeKind::kError;
 }
 
-const char* Error::value() const {
-  return m_value;
+DiagnosticCode Error::code() const {
+  return m_code;
 }
 
-unsigned int Error::line() const {
-  return m_line;
+uint32_t Error::arg(int index) const {
+  return m_args[index];
 }
 
-unsigned int Error::column() const {
-  return m_column;
+Diagnostic Error::diagnostic() const {
+  Diagnostic result;
+
+  result.m_code = m_code;
+  result.m_offset = offset();
+  result.m_args[0] = m_args[0];
+  result.m_args[1] = m_args[1];
+
+  return result;
 }
 
 //
 
 Identifier::Identifier()
-    : m_name(nullptr),
-      m_symbol(nullptr) {}
+    : m_name(kInvalidName) {}
 
 void Identifier::accept(ASTVisitor* visitor) {
   visitor->visit(this);
@@ -48,26 +57,18 @@ NodeKind Identifier::kind() const {
   return NodeKind::kIdentifier;
 }
 
-void Identifier::init(Name* name) {
+void Identifier::init(NameId name) {
   m_name = name;
 }
 
-Name* Identifier::name() const {
+NameId Identifier::name() const {
   return m_name;
 }
 
-syms::Symbol* Identifier::symbol() const {
-  return m_symbol;
-}
-
-void Identifier::symbol(syms::Symbol* value) {
-  m_symbol = value;
-}
-
 //
 
 Number::Number() : 
-  m_name(nullptr) {}
+  m_name(kInvalidName) {}
 
 void Number::accept(ASTVisitor* visitor) {
   visitor->visit(this);
@@ -77,18 +78,18 @@ NodeKind Number::kind() const {
   return NodeKind::kNumber;
 }
 
-void Number::init(Name* name) {
+void Number::init(NameId name) {
   m_name = name;
 }
 
-Name* Number::name() const {
+NameId Number::name() const {
   return m_name;
 }
 
 //
 
 String::String() : 
-  m_name(nullptr) {}
+  m_name(kInvalidName) {}
 
 void String::accept(ASTVisitor* visitor) {
   visitor->visit(this);
@@ -98,11 +99,11 @@ NodeKind String::kind() const {
   return NodeKind::kString;
 }
 
-void String::init(Name* name) {
+void String::init(NameId name) {
   m_name = name;
 }
 
-Name* String::name() const {
+NameId String::name() const {
   return m_name;
 }
 
@@ -130,10 +131,6 @@ NodeKind Block::kind() const {
   return NodeKind::kBlock;
 }
 
-NodeList* Block::expressions() {
-  return &m_expressions;
-}
-
 syms::Scope* Block::scope() const {
   return m_scope;
 }
@@ -184,14 +181,6 @@ void Select::init(Node* object, Node* qualifier) {
   m_qualifier = qualifier;
 }
 
-Node* Select::object() const {
-  return m_object;
-}
-
-Node* Select::qualifier() const {
-  return m_qualifier;
-}
-
 //
 
 If::If() {}
@@ -204,10 +193,6 @@ NodeKind If::kind() const {
   return NodeKind::kIf;
 }
 
-NodeList* If::cases() {
-  return &m_cases;
-}
-
 
 //
 
@@ -228,14 +213,6 @@ void IfCase::init(Node* condition, Node* expr) {
   m_expr = expr;
 }
 
-Node* IfCase::condition() const {
-  return m_condition;
-}
-
-Node* IfCase::expr() const {
-  return m_expr;
-}
-
 //
 
 Call::Call()
@@ -253,14 +230,6 @@ void Call::init(Node* callee) {
   m_callee = callee;
 }
 
-Node* Call::callee() const {
-  return m_callee;
-}
-
-NodeList* Call::arguments() {
-  return &m_arguments;
-}
-
 //
 
 Argument::Argument()
@@ -284,14 +253,6 @@ bool Argument::hasName() const {
   return m_name != nullptr;
 }
 
-Node* Argument::name() const {
-  return m_name;
-}
-
-Node* Argument::value() const {
-  return m_value;
-}
-
 //
 
 Assign::Assign()
@@ -313,14 +274,6 @@ void Assign::init(Node* target, Node* value, bool force) {
   m_force = force;
 }
 
-Node* Assign::target() const {
-  return m_target;
-}
-
-Node* Assign::value() const {
-  return m_value;
-}
-
 bool Assign::force() const {
   return m_force;
 }
@@ -366,16 +319,29 @@ bool Variable::hasType() const {
   return m_type != nullptr;
 }
 
-Node* Variable::name() const {
-  return m_name;
+//
+
+LazyBody::LazyBody()
+    : m_source(nullptr),
+      m_offset(0),
+      m_length(0) {}
+
+void LazyBody::init(const char* source, size_t offset, size_t length) {
+  m_source = source;
+  m_offset = offset;
+  m_length = length;
+}
+
+const char* LazyBody::source() const {
+  return m_source;
 }
 
-Node* Variable::type() const {
-  return m_type;
+size_t LazyBody::offset() const {
+  return m_offset;
 }
 
-Node* Variable::init() const {
-  return m_init;
+size_t LazyBody::length() const {
+  return m_length;
 }
 
 //
@@ -384,6 +350,7 @@ Function::Function()
     : m_name(nullptr), 
       m_type(nullptr), 
       m_expr(nullptr), 
+      m_lazyBody(nullptr),
       m_flags(0) {}
 
 void Function::accept(ASTVisitor* visitor) {
@@ -401,14 +368,6 @@ void Function::init(Node* name, Node* type, Node* expr, unsigned int flags) {
   m_flags = flags;
 }
 
-NodeList* Function::parameters() {
-  return &m_parameters;
-}
-
-NodeList* Function::typeParameters() {
-  return &m_typeParameters;
-}
-
 bool Function::isAnonymous() const {
   return m_name == nullptr;
 }
@@ -417,20 +376,28 @@ bool Function::hasType() const {
   return m_type != nullptr;
 }
 
-Node* Function::name() const {
-  return m_name;
+void Function::expr(Node* value) {
+  m_expr = value;
 }
 
-Node* Function::type() const {
-  return m_type;
+unsigned int Function::flags() const {
+  return m_flags;
 }
 
-Node* Function::expr() const {
-  return m_expr;
+bool Function::isAbstract() const {
+  return m_expr == nullptr && !hasLazyBody();
 }
 
-bool Function::isAbstract() const {
-  return m_expr == nullptr;
+LazyBody* Function::lazyBody() const {
+  return m_lazyBody.load(std::memory_order_acquire);
+}
+
+void Function::lazyBody(LazyBody* value) {
+  m_lazyBody.store(value, std::memory_order_release);
+}
+
+bool Function::hasLazyBody() const {
+  return nullptr != lazyBody();
 }
 
 //
@@ -452,14 +419,6 @@ void Parameter::init(Node* name, Node* type) {
   m_type = type;
 }
 
-Node* Parameter::name() const {
-  return m_name;
-}
-
-Node* Parameter::type() const {
-  return m_type;
-}
-
 bool Parameter::hasType() const {
   return m_type != nullptr;
 }
@@ -485,14 +444,6 @@ void TypeParameter::init(Node* name, Node* bound, unsigned int boundType) {
   m_boundType = boundType;
 }
 
-Node* TypeParameter::name() const {
-  return m_name;
-}
-
-Node* TypeParameter::bound() const {
-  return m_bound;
-}
-
 unsigned int TypeParameter::boundType() const {
   return m_boundType;
 }
@@ -516,22 +467,10 @@ void Class::init(Node* name, unsigned int flags) {
   m_flags = flags;
 }
 
-Node* Class::name() const {
-  return m_name;
-}
-
 unsigned int Class::flags() const {
   return m_flags;
 }
 
-NodeList* Class::typeParameters() {
-  return &m_typeParameters;
-}
-
-NodeList* Class::members() {
-  return &m_members;
-}
-
 //
 
 Module::Module()
@@ -549,18 +488,6 @@ void Module::init(Node* name) {
   m_name = name;
 }
 
-Node* Module::name() const {
-  return m_name;
-}
-
-NodeList* Module::declarations() {
-  return &m_declarations;
-}
-
-NodeList* Module::dependencies() {
-  return &m_dependencies;
-}
-
 //
 
 ModuleDependency::ModuleDependency() 
@@ -580,14 +507,6 @@ void ModuleDependency::init(Node* name, Node* version) {
   m_version = version;
 }
 
-Node* ModuleDependency::name() const {
-  return m_name;
-}
-
-Node* ModuleDependency::version() const {
-  return m_version;
-}
-
 bool ModuleDependency::hasVersion() const {
   return m_version != nullptr;
 }
@@ -604,10 +523,6 @@ NodeKind Program::kind() const {
   return NodeKind::kProgram;
 }
 
-NodeList* Program::modules() {
-  return &m_modules;
-}
-
 //
 
 ASTVisitor::ASTVisitor() {}
@@ -659,7 +574,10 @@ void ASTVisitor::visit(Function* node) {
 
   acceptAll(node->typeParameters());
   acceptAll(node->parameters());
-  node->expr()->accept(this);
+
+  if(nullptr != node->expr()) {
+    node->expr()->accept(this);
+  }
 }
 
 void ASTVisitor::visit(Identifier* node) {
@@ -725,7 +643,10 @@ void ASTVisitor::visit(True* node) {
 
 void ASTVisitor::visit(TypeParameter* node) {
   node->name()->accept(this);
-  node->bound()->accept(this);
+
+  if(nullptr != node->bound()) {
+    node->bound()->accept(this);
+  }
 }
 
 void ASTVisitor::visit(Variable* node) {
@@ -760,8 +681,17 @@ static const char* Indentation[] = {
 
 static const int MaxIndentation = NumberOfElements(Indentation);
 
-ASTPrinter::ASTPrinter(std::ostream& output)  //NOLINT
-    : m_output(output), 
+ASTPrinter::ASTPrinter(Writer* output, NameTable* names)
+    : m_output(output),
+      m_names(names),
+      m_lines(nullptr),
+      m_indentLevel(0),
+      m_wasNewLine(NO) {}
+
+ASTPrinter::ASTPrinter(Writer* output, NameTable* names, LineTable* lines)
+    : m_output(output),
+      m_names(names),
+      m_lines(lines),
       m_indentLevel(0),
       m_wasNewLine(NO) {}
 
@@ -788,7 +718,7 @@ void ASTPrinter::popIndent() {
 template<typename T>
 void ASTPrinter::print(T value) {
   maybeIndent();
-  m_output << value;
+  *m_output << value;
 }
 
 template<typename T>
@@ -798,13 +728,13 @@ void ASTPrinter::println(T value) {
 }
 
 void ASTPrinter::nl() {
-  m_output << std::endl;
+  *m_output << '\n';
   m_wasNewLine = YES;
 }
 
 void ASTPrinter::maybeIndent() {
   if(m_wasNewLine) {
-    m_output << Indentation[m_indentLevel];
+    *m_output << Indentation[m_indentLevel];
     m_wasNewLine = NO;
   }
 }
@@ -882,12 +812,26 @@ void ASTPrinter::visit(Class* node) {
 }
 
 void ASTPrinter::visit(Error* node) {
+  std::ostringstream message;
+
+  Diagnostics::format(message, node->diagnostic(), m_names);
   print("<<error(");
-  print(node->value());
+  print(message.str().c_str());
   print(", ");
-  print(node->line());
-  print(':');
-  print(node->column());
+
+  if(nullptr == m_lines) {
+    print('@');
+    print(node->offset());
+  } else {
+    uint32_t line;
+    uint32_t column;
+
+    m_lines->position(node->offset(), &line, &column);
+    print(line + 1);
+    print(':');
+    print(column + 1);
+  }
+
   print(")>>");
 }
 
@@ -928,7 +872,9 @@ void ASTPrinter::visit(Function* node) {
       print(')');
     }
     
-    if(!node->isAbstract()) {
+    if(node->hasLazyBody()) {
+      print(" { ... }");
+    } else if(!node->isAbstract()) {
       print(' ');
       node->expr()->accept(this);
     }
@@ -936,7 +882,7 @@ void ASTPrinter::visit(Function* node) {
 }
 
 void ASTPrinter::visit(Identifier* node) {
-  print(node->name()->value());
+  print(m_names->value(node->name()));
 }
 
 void ASTPrinter::visit(If* node) {
@@ -970,7 +916,7 @@ void ASTPrinter::visit(Module* node) {
   if(node->name()->kind() == NodeKind::kIdentifier) {
     ast::Identifier* name = static_cast<ast::Identifier*>(node->name());
 
-    if(name->name()->length() > 0) {
+    if(m_names->length(name->name()) > 0) {
       print(" {");
     } else {
       print('{');
@@ -1018,7 +964,7 @@ void ASTPrinter::visit(ModuleDependency* node) {
 }
 
 void ASTPrinter::visit(Number* node) {
-  print(node->name()->value());
+  print(m_names->value(node->name()));
 }
 
 void ASTPrinter::visit(Parameter* node) {
@@ -1046,7 +992,7 @@ void ASTPrinter::visit(Select* node) {
 void ASTPrinter::visit(String* node) {
   print('"');
   //TODO(joa): escape
-  print(node->name()->value());
+  print(m_names->value(node->name()));
   print('"');
 }
 
@@ -1121,10 +1067,6 @@ void NodeList::add(Node* node, Arena* arena) {
   ++m_nodesIndex;
 }
 
-int NodeList::size() const { 
-  return m_nodesIndex;
-}
-
 Node* NodeList::get(const int& index) {
   if(index >= m_nodesIndex || index < 0) {
 #ifdef DEBUG
@@ -1137,8 +1079,16 @@ Node* NodeList::get(const int& index) {
   return m_nodes[index];
 }
 
-Node** NodeList::nodes() const {
-  return m_nodes;
+void NodeList::set(const int& index, Node* node) {
+  if(index >= m_nodesIndex || index < 0) {
+#ifdef DEBUG
+    std::cerr << "Warning: Array element " << 
+        index << " is out of bounds." << std::endl;
+#endif
+    return;
+  }
+
+  m_nodes[index] = node;
 }
 
 Node* NodeList::last() const {
@@ -1,10 +1,43 @@
 #ifndef BRUTUS_AST_H_
 #define BRUTUS_AST_H_
 
+#include <atomic>
+
 #include "brutus.h"
 #include "arena.h"
+#include "diagnostics.h"
 #include "lexer.h"
+#include "lines.h"
 #include "name.h"
+#include "writer.h"
+
+// All kinds of nodes. Every kind has a class of the same name.
+//
+// Code that has to handle every kind of node should be generated from
+// this list so a new kind cannot be forgotten.
+#define AST_NODE_KINDS(V) \
+  V(Argument) \
+  V(Assign) \
+  V(Block) \
+  V(Call) \
+  V(Class) \
+  V(Error) \
+  V(False) \
+  V(Function) \
+  V(Identifier) \
+  V(If) \
+  V(IfCase) \
+  V(Module) \
+  V(ModuleDependency) \
+  V(Number) \
+  V(Parameter) \
+  V(Program) \
+  V(Select) \
+  V(String) \
+  V(This) \
+  V(True) \
+  V(TypeParameter) \
+  V(Variable)
 
 #define NODE_OVERRIDES() \
   void accept(ASTVisitor* visitor) override final; \
@@ -23,30 +56,15 @@ namespace brutus {
 
     namespace ast {
       enum class NodeKind {
-        kArgument,
-        kAssign,
-        kBlock,
-        kCall,
-        kClass,
-        kError,
-        kFalse,
-        kFunction,
-        kIdentifier,
-        kIf,
-        kIfCase,
-        kModule,
-        kModuleDependency,
-        kNumber,
-        kParameter,
-        kProgram,
-        kSelect,
-        kString,
-        kThis,
-        kTrue,
-        kTypeParameter,
-        kVariable
+#define DECLARE_NODE_KIND(x) k##x,
+        AST_NODE_KINDS(DECLARE_NODE_KIND)
+#undef DECLARE_NODE_KIND
       }; //enum Kind
 
+#define DECLARE_NODE_CLASS(x) class x;
+      AST_NODE_KINDS(DECLARE_NODE_CLASS)
+#undef DECLARE_NODE_CLASS
+
       class ASTVisitor;
       
       class Node : public ArenaMember {
@@ -55,7 +73,7 @@ namespace brutus {
             return arena->alloc(size);
           }
 
-          explicit Node() : m_symbol(nullptr) {}
+          explicit Node() : m_symbol(nullptr), m_type(nullptr), m_offset(0) {}
           virtual ~Node() {}
           
           virtual void accept(ASTVisitor* visitor) = 0;
@@ -77,9 +95,21 @@ namespace brutus {
             m_type = value;
           }
 
+          // Offset of the first character of the node in the source of
+          // its unit. Lines and columns are only computed when they are
+          // needed, see LineTable.
+          ALWAYS_INLINE uint32_t offset() const {
+            return m_offset;
+          }
+
+          ALWAYS_INLINE void offset(uint32_t value) {
+            m_offset = value;
+          }
+
         private:
           syms::Symbol* m_symbol;
           types::Type* m_type;
+          uint32_t m_offset;
 
           void* operator new(size_t size);
           
@@ -90,9 +120,10 @@ namespace brutus {
         public:
           explicit NodeList();
           void add(Node* node, Arena* arena);
-          int size() const;
+          ALWAYS_INLINE int size() const { return m_nodesIndex; }
           Node* get(const int& index);
-          Node** nodes() const;
+          void set(const int& index, Node* node);
+          ALWAYS_INLINE Node** nodes() const { return m_nodes; }
           Node* last() const;
           bool nonEmpty() const;
           void foreach(std::function<void(Node*)> f); //NOLINT
@@ -133,25 +164,41 @@ namespace brutus {
 
       class Declaration : public Node {
         public:
-          explicit Declaration() {}
+          explicit Declaration()
+              : m_sourceLength(0) {}
+
+          // The characters of a declaration in the source of its unit
+          // from its first token up to the newline that ends it. Only
+          // known for modules and their declarations, zero otherwise.
+          ALWAYS_INLINE uint32_t sourceOffset() const { return offset(); }
+          ALWAYS_INLINE uint32_t sourceLength() const { return m_sourceLength; }
+
+          ALWAYS_INLINE void sourceRange(uint32_t offset, uint32_t length) {
+            this->offset(offset);
+            m_sourceLength = length;
+          }
 
         private:
+          uint32_t m_sourceLength;
+
           DISALLOW_COPY_AND_ASSIGN(Declaration);
       };
 
       class Error : public Node {
         public:
           explicit Error();
-          void init(const char* value, unsigned int line, unsigned int column);
-          const char* value() const;
-          unsigned int line() const;
-          unsigned int column() const;
+          void init(DiagnosticCode code, uint32_t arg0, uint32_t arg1);
+          DiagnosticCode code() const;
+          uint32_t arg(int index) const;
+
+          // The error as it has been reported by the parser.
+          Diagnostic diagnostic() const;
+
           NODE_OVERRIDES();
 
         private:
-          const char* m_value;
-          unsigned int m_line;
-          unsigned int m_column;
+          DiagnosticCode m_code;
+          uint32_t m_args[2];
 
           DISALLOW_COPY_AND_ASSIGN(Error);
       };
@@ -159,7 +206,7 @@ namespace brutus {
       class Program : public Node {
         public:
           explicit Program();
-          NodeList* modules();
+          ALWAYS_INLINE NodeList* modules() { return &m_modules; }
           NODE_OVERRIDES();
 
         private:
@@ -172,9 +219,9 @@ namespace brutus {
         public:
           explicit Module();
           void init(Node* name);
-          Node* name() const;
-          NodeList* declarations();
-          NodeList* dependencies();
+          ALWAYS_INLINE Node* name() const { return m_name; }
+          ALWAYS_INLINE NodeList* declarations() { return &m_declarations; }
+          ALWAYS_INLINE NodeList* dependencies() { return &m_dependencies; }
           NODE_OVERRIDES();
 
         private:
@@ -188,8 +235,8 @@ namespace brutus {
         public:
           explicit ModuleDependency();
           void init(Node* name, Node* version);
-          Node* name() const;
-          Node* version() const;
+          ALWAYS_INLINE Node* name() const { return m_name; }
+          ALWAYS_INLINE Node* version() const { return m_version; }
           bool hasVersion() const;
           NODE_OVERRIDES();
 
@@ -202,15 +249,12 @@ namespace brutus {
       class Identifier : public Expr {
         public:
           explicit Identifier();
-          void init(Name* name);
-          Name* name() const;
-          syms::Symbol* symbol() const;
-          void symbol(syms::Symbol* value);
+          void init(NameId name);
+          NameId name() const;
           NODE_OVERRIDES();
 
         private:
-          Name* m_name;
-          syms::Symbol* m_symbol;
+          NameId m_name;
 
           DISALLOW_COPY_AND_ASSIGN(Identifier);
       };
@@ -219,12 +263,12 @@ namespace brutus {
       class Number : public Expr {
         public:
           explicit Number();
-          void init(Name* name);
-          Name* name() const;
+          void init(NameId name);
+          NameId name() const;
           NODE_OVERRIDES();
 
         private:
-          Name* m_name;
+          NameId m_name;
 
           DISALLOW_COPY_AND_ASSIGN(Number);
       };
@@ -232,12 +276,12 @@ namespace brutus {
       class String : public Expr {
         public:
           explicit String();
-          void init(Name* name);
-          Name* name() const;
+          void init(NameId name);
+          NameId name() const;
           NODE_OVERRIDES();
 
         private:
-          Name* m_name;
+          NameId m_name;
 
           DISALLOW_COPY_AND_ASSIGN(String);
       };
@@ -254,7 +298,7 @@ namespace brutus {
       class Block : public Expr {
         public:
           explicit Block();
-          NodeList* expressions();
+          ALWAYS_INLINE NodeList* expressions() { return &m_expressions; }
           syms::Scope* scope() const;
           void scope(syms::Scope* value);
           NODE_OVERRIDES();
@@ -288,8 +332,8 @@ namespace brutus {
         public: 
           explicit Select();
           void init(Node* object, Node* qualifier);
-          Node* object() const;
-          Node* qualifier() const;
+          ALWAYS_INLINE Node* object() const { return m_object; }
+          ALWAYS_INLINE Node* qualifier() const { return m_qualifier; }
           NODE_OVERRIDES();
 
         private:
@@ -301,7 +345,7 @@ namespace brutus {
       class If : public Expr {
         public:
           explicit If();
-          NodeList* cases();
+          ALWAYS_INLINE NodeList* cases() { return &m_cases; }
           NODE_OVERRIDES();
 
         private:
@@ -314,8 +358,8 @@ namespace brutus {
         public:
           explicit IfCase();
           void init(Node* condition, Node* expr);
-          Node* condition() const;
-          Node* expr() const;
+          ALWAYS_INLINE Node* condition() const { return m_condition; }
+          ALWAYS_INLINE Node* expr() const { return m_expr; }
           NODE_OVERRIDES();
 
         private:
@@ -329,8 +373,8 @@ namespace brutus {
         public: 
           explicit Call();
           void init(Node* callee);
-          Node* callee() const;
-          NodeList* arguments();
+          ALWAYS_INLINE Node* callee() const { return m_callee; }
+          ALWAYS_INLINE NodeList* arguments() { return &m_arguments; }
           NODE_OVERRIDES();
 
         private:
@@ -345,8 +389,8 @@ namespace brutus {
           explicit Argument();
           void init(Node* name, Node* value);
           bool hasName() const;
-          Node* name() const;
-          Node* value() const;
+          ALWAYS_INLINE Node* name() const { return m_name; }
+          ALWAYS_INLINE Node* value() const { return m_value; }
           NODE_OVERRIDES();
 
         private:
@@ -360,8 +404,8 @@ namespace brutus {
         public:
           explicit Assign();
           void init(Node* target, Node* value, bool force);
-          Node* target() const;
-          Node* value() const;
+          ALWAYS_INLINE Node* target() const { return m_target; }
+          ALWAYS_INLINE Node* value() const { return m_value; }
           bool force() const;
           NODE_OVERRIDES();
 
@@ -380,9 +424,9 @@ namespace brutus {
           bool isModifiable() const;
           bool hasInit() const;
           bool hasType() const;
-          Node* name() const;
-          Node* type() const;
-          Node* init() const;
+          ALWAYS_INLINE Node* name() const { return m_name; }
+          ALWAYS_INLINE Node* type() const { return m_type; }
+          ALWAYS_INLINE Node* init() const { return m_init; }
           bool force() const;
           NODE_OVERRIDES();
 
@@ -396,25 +440,58 @@ namespace brutus {
           DISALLOW_COPY_AND_ASSIGN(Variable);
       };
 
+      // The source range of a function body that has been skipped by
+      // the parser in outline mode. The characters are owned by the
+      // compilation unit.
+      class LazyBody : public ArenaMember {
+        public:
+          void* operator new(size_t size, Arena* arena) {
+            return arena->alloc(size);
+          }
+
+          explicit LazyBody();
+          void init(const char* source, size_t offset, size_t length);
+          const char* source() const;
+          size_t offset() const;
+          size_t length() const;
+
+        private:
+          const char* m_source;
+          size_t m_offset;
+          size_t m_length;
+
+          void* operator new(size_t size);
+
+          DISALLOW_COPY_AND_ASSIGN(LazyBody);
+      };
+
       class Function : public Declaration {
         public:
           explicit Function();
           void init(Node* name, Node* type, Node* expr, unsigned int flags);
-          Node* name() const;
-          Node* type() const;
-          Node* expr() const;
+          ALWAYS_INLINE Node* name() const { return m_name; }
+          ALWAYS_INLINE Node* type() const { return m_type; }
+          ALWAYS_INLINE Node* expr() const { return m_expr; }
+          void expr(Node* value);
           unsigned int flags() const;
-          NodeList* parameters();
-          NodeList* typeParameters();
+          ALWAYS_INLINE NodeList* parameters() { return &m_parameters; }
+          ALWAYS_INLINE NodeList* typeParameters() { return &m_typeParameters; }
           bool isAnonymous() const;
           bool hasType() const;
           bool isAbstract() const;
+          LazyBody* lazyBody() const;
+          void lazyBody(LazyBody* value);
+          bool hasLazyBody() const;
           NODE_OVERRIDES();
 
         private:
           Node* m_name;
           Node* m_type;
           Node* m_expr;
+
+          // Cleared once the body has been parsed, which another thread
+          // may be doing while this one links a call of the function.
+          std::atomic<LazyBody*> m_lazyBody;
           unsigned int m_flags;
           NodeList m_typeParameters;
           NodeList m_parameters;
@@ -426,8 +503,8 @@ namespace brutus {
         public:
           explicit Parameter();
           void init(Node* name, Node* type);
-          Node* name() const;
-          Node* type() const;
+          ALWAYS_INLINE Node* name() const { return m_name; }
+          ALWAYS_INLINE Node* type() const { return m_type; }
           bool hasType() const;
           NODE_OVERRIDES();
 
@@ -442,8 +519,8 @@ namespace brutus {
         public:
           explicit TypeParameter();
           void init(Node* name, Node* bound, unsigned int boundType);
-          Node* name() const;
-          Node* bound() const;
+          ALWAYS_INLINE Node* name() const { return m_name; }
+          ALWAYS_INLINE Node* bound() const { return m_bound; }
           unsigned int boundType() const;
           NODE_OVERRIDES();
 
@@ -459,10 +536,10 @@ namespace brutus {
         public:
           explicit Class();
           void init(Node* name, unsigned int flags);
-          Node* name() const;
+          ALWAYS_INLINE Node* name() const { return m_name; }
           unsigned int flags() const;
-          NodeList* typeParameters();
-          NodeList* members();
+          ALWAYS_INLINE NodeList* typeParameters() { return &m_typeParameters; }
+          ALWAYS_INLINE NodeList* members() { return &m_members; }
           NODE_OVERRIDES();
 
         private:
@@ -478,28 +555,9 @@ namespace brutus {
         public:
           explicit ASTVisitor();
           virtual ~ASTVisitor() {}
-          virtual void visit(Argument* node);
-          virtual void visit(Assign* node);
-          virtual void visit(Block* node);
-          virtual void visit(Call* node);
-          virtual void visit(Class* node);
-          virtual void visit(Error* node);
-          virtual void visit(False* node);
-          virtual void visit(Function* node);
-          virtual void visit(Identifier* node);
-          virtual void visit(If* node);
-          virtual void visit(IfCase* node);
-          virtual void visit(Module* node);
-          virtual void visit(ModuleDependency* node);
-          virtual void visit(Number* node);
-          virtual void visit(Parameter* node);
-          virtual void visit(Program* node);
-          virtual void visit(Select* node);
-          virtual void visit(String* node);
-          virtual void visit(This* node);
-          virtual void visit(True* node);
-          virtual void visit(TypeParameter* node);
-          virtual void visit(Variable* node);
+#define DECLARE_VISIT(x) virtual void visit(x* node);
+          AST_NODE_KINDS(DECLARE_VISIT)
+#undef DECLARE_VISIT
 
         protected:
           virtual void acceptAll(NodeList* list);
@@ -510,30 +568,15 @@ namespace brutus {
 
       class ASTPrinter : public ASTVisitor {
         public:
-          explicit ASTPrinter(std::ostream &output); //NOLINT
+          explicit ASTPrinter(Writer* output, NameTable* names);
+
+          // Positions of errors are printed as line and column of the
+          // given table instead of offsets.
+          explicit ASTPrinter(Writer* output, NameTable* names, LineTable* lines);
           void print(Node* node);
-          virtual void visit(Argument* node) override;
-          virtual void visit(Assign* node) override;
-          virtual void visit(Block* node) override;
-          virtual void visit(Call* node) override;
-          virtual void visit(Class* node) override;
-          virtual void visit(Error* node) override;
-          virtual void visit(False* node) override;
-          virtual void visit(Function* node) override;
-          virtual void visit(Identifier* node) override;
-          virtual void visit(If* node) override;
-          virtual void visit(IfCase* node) override;
-          virtual void visit(Module* node) override;
-          virtual void visit(ModuleDependency* node) override;
-          virtual void visit(Number* node) override;
-          virtual void visit(Parameter* node) override;
-          virtual void visit(Program* node) override;
-          virtual void visit(Select* node) override;
-          virtual void visit(String* node) override;
-          virtual void visit(This* node) override;
-          virtual void visit(True* node) override;
-          virtual void visit(TypeParameter* node) override;
-          virtual void visit(Variable* node) override;
+#define DECLARE_VISIT(x) virtual void visit(x* node) override;
+          AST_NODE_KINDS(DECLARE_VISIT)
+#undef DECLARE_VISIT
 
         private:
           void pushIndent();
@@ -549,7 +592,9 @@ namespace brutus {
           void maybeIndent();
           void printAll(NodeList* nodes, const char* separatorChars);
 
-          std::ostream& m_output;
+          Writer* const m_output;
+          NameTable* const m_names;
+          LineTable* const m_lines;
           int m_indentLevel;
           bool m_wasNewLine;
 
@@ -1,102 +1,411 @@
-#include "brutus.h"
-
-#include "arena.h"
-#include "ast.h"
-#include "name.h"
-#include "lexer.h"
-#include "parser.h"
-#include "stopwatch.h"
-#include "streams.h"
-#include "phases.h"
-#include "symbols.h"
-#include "compiler.h"
-
-//#define PERF_TEST
-const auto numTrials = 10000;
-
-void perf_test(std::function<int()> f) {
-  brutus::Stopwatch stopwatch;
-
-  for(auto trail = 0; trail < numTrials; ++trail) {
-    stopwatch.time([&]() {
-      std::cout << "Result: " << f() << std::endl;
-    });
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef OS_WINDOWS
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#include "../include/brutus.h"
+
+// The command line interface only uses the public API so it works the
+// same with a static and a shared libbrutus.
+//
+// Usage: brutus [options] <file|directory|@file>...
+//
+// A directory stands for all .b files below it in sorted order and an
+// argument @file for the arguments in the given file, which may be
+// separated by any whitespace and quoted with double quotes.
+
+static const char* const kUsage =
+  "Usage: brutus [options] <file|directory|@file>...\n"
+  "\n"
+  "Options:\n"
+  "  -j N, --jobs=N          compile with N workers, one per core by default\n"
+  "  --stop-after=STAGE      stop after parse, symbols or link\n"
+  "  --time-report           print the time of every phase\n"
+  "  --mem-report            print the memory that has been used\n"
+  "  --cache=DIR             restore unchanged units from a build cache\n"
+  "  --module-path=DIR       read and write the interfaces of modules in DIR\n"
+  "  --prelude=PATH          use an image or a .b file as the prelude\n"
+  "  --no-prelude            compile without a prelude\n"
+  "  --dump-ast=PATH         write the ASTs, as JSON if PATH ends with .json\n"
+  "  --trace=PATH            write a trace that about://tracing opens\n"
+  "  --help                  print this message\n";
+
+// Response files may refer to other response files but not endlessly.
+static const int kMaxResponseDepth = 16;
+
+class Options {
+  public:
+    Options()
+        : m_numWorkers(0),
+          m_stage(brutus::Stage::kLink),
+          m_isTimeReport(false),
+          m_isMemReport(false),
+          m_isPrelude(true) {}
+
+    int m_numWorkers;
+    brutus::Stage m_stage;
+    bool m_isTimeReport;
+    bool m_isMemReport;
+    bool m_isPrelude;
+    std::string m_prelude;
+    std::string m_cache;
+    std::string m_modulePath;
+    std::string m_dumpPath;
+    std::string m_tracePath;
+    std::vector<std::string> m_inputs;
+};
+
+static bool endsWith(const std::string& value, const char* suffix) {
+  const auto length = strlen(suffix);
+
+  return value.size() >= length &&
+    0 == value.compare(value.size() - length, length, suffix);
+}
+
+static bool parseNumWorkers(const char* value, int* result) {
+  char* end;
+  const auto number = strtol(value, &end, 10);
+
+  if('\0' == *value || '\0' != *end || number < 1 || number > 1024) {
+    std::cerr << "Invalid number of jobs \"" << value << "\"." << std::endl;
+    return false;
   }
+
+  *result = static_cast<int>(number);
+  return true;
 }
 
-void withFile(const char* path, std::function<void(FILE*)> f) {
-  auto fp = fopen(path, "r");
+static bool parseStage(const char* value, brutus::Stage* result) {
+  if(0 == strcmp(value, "parse")) {
+    *result = brutus::Stage::kParse;
+  } else if(0 == strcmp(value, "symbols")) {
+    *result = brutus::Stage::kSymbols;
+  } else if(0 == strcmp(value, "link")) {
+    *result = brutus::Stage::kLink;
+  } else {
+    std::cerr << "Unknown stage \"" << value << "\"." << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+static bool readResponseFile(const char* path, std::vector<std::string>* result) {
+  auto fp = fopen(path, "rb");
 
   if(!fp) {
-    std::cout << "Could not read \"" << path << "\"." << std::endl;
-    return;
+    std::cerr << "Could not read \"" << path << "\"." << std::endl;
+    return false;
   }
 
-  f(fp);
+  std::string argument;
+  bool isArgument = false;
+  bool isQuoted = false;
+  int c;
 
-  fclose(fp);
+  while(EOF != (c = fgetc(fp))) {
+    if('"' == c) {
+      isQuoted = !isQuoted;
+      isArgument = true;
+    } else if(!isQuoted && (' ' == c || '\t' == c || '\r' == c || '\n' == c)) {
+      if(isArgument) {
+        result->push_back(argument);
+        argument.clear();
+        isArgument = false;
+      }
+    } else {
+      argument.push_back(static_cast<char>(c));
+      isArgument = true;
+    }
+  }
 
+  if(isArgument) {
+    result->push_back(argument);
+  }
+
+  fclose(fp);
+  return true;
 }
 
-void withTokenFile(std::function<void(FILE*)> f) {
-  withFile("tokens.txt", f);
+// Adds the arguments in order, expanding response files in place.
+static bool parseArguments(const std::vector<std::string>& arguments, int depth, Options* options) {
+  for(size_t i = 0; i < arguments.size(); ++i) {
+    const auto& argument = arguments[i];
+    const auto value = argument.c_str();
+
+    if('@' == value[0]) {
+      std::vector<std::string> nested;
+
+      if(depth == kMaxResponseDepth) {
+        std::cerr << "Response files are nested too deep at \"" << value + 1 << "\"." << std::endl;
+        return false;
+      }
+
+      if(!readResponseFile(value + 1, &nested) ||
+         !parseArguments(nested, depth + 1, options)) {
+        return false;
+      }
+    } else if(0 == strcmp(value, "-j")) {
+      if(i + 1 == arguments.size()) {
+        std::cerr << "Missing number of jobs." << std::endl;
+        return false;
+      }
+
+      if(!parseNumWorkers(arguments[++i].c_str(), &options->m_numWorkers)) {
+        return false;
+      }
+    } else if(0 == argument.compare(0, 2, "-j")) {
+      if(!parseNumWorkers(value + 2, &options->m_numWorkers)) {
+        return false;
+      }
+    } else if(0 == argument.compare(0, 7, "--jobs=")) {
+      if(!parseNumWorkers(value + 7, &options->m_numWorkers)) {
+        return false;
+      }
+    } else if(0 == argument.compare(0, 13, "--stop-after=")) {
+      if(!parseStage(value + 13, &options->m_stage)) {
+        return false;
+      }
+    } else if(argument == "--time-report") {
+      options->m_isTimeReport = true;
+    } else if(argument == "--mem-report") {
+      options->m_isMemReport = true;
+    } else if(argument == "--no-prelude") {
+      options->m_isPrelude = false;
+    } else if(0 == argument.compare(0, 10, "--prelude=")) {
+      options->m_isPrelude = true;
+      options->m_prelude = argument.substr(10);
+    } else if(0 == argument.compare(0, 8, "--cache=")) {
+      options->m_cache = argument.substr(8);
+    } else if(0 == argument.compare(0, 14, "--module-path=")) {
+      options->m_modulePath = argument.substr(14);
+    } else if(0 == argument.compare(0, 11, "--dump-ast=")) {
+      options->m_dumpPath = argument.substr(11);
+    } else if(0 == argument.compare(0, 8, "--trace=")) {
+      options->m_tracePath = argument.substr(8);
+    } else if('-' == value[0] && '\0' != value[1]) {
+      std::cerr << "Unknown option \"" << value << "\"." << std::endl;
+      return false;
+    } else {
+      options->m_inputs.push_back(argument);
+    }
+  }
+
+  return true;
 }
 
-int main(int argc, char** argv) {
-  (void)argc;
-  (void)argv;
+// Appends the .b files below a directory. Returns false if the path
+// is not a directory.
+static bool listDirectory(const std::string& path, std::vector<std::string>* result) {
+  std::vector<std::string> entries;
 
+#ifdef OS_WINDOWS
+  WIN32_FIND_DATAA data;
+  const auto handle = FindFirstFileA((path + "\\*").c_str(), &data);
 
-#if 1
-#ifdef PERF_TEST
-  perf_test([&]() {
-#endif
-    withFile("lang.b", [&](FILE* lang) {
-      withTokenFile([&](FILE* tokens) {
-        brutus::Stopwatch stopwatch;
-    
-        auto compiler = new brutus::Compiler();
-        compiler->addSource(lang);
-        compiler->addSource(tokens);
-    
-        stopwatch.time([&]() {
-          compiler->compile();
-        });
-
-        delete compiler;
-      });    
-    });
-#ifdef PERF_TEST
-  return 123;
-  });
+  if(INVALID_HANDLE_VALUE == handle) {
+    return false;
+  }
+
+  do {
+    const std::string name = data.cFileName;
+
+    if("." == name || ".." == name) {
+      continue;
+    }
+
+    const auto isDirectory = 0 != (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY);
+
+    if(isDirectory || endsWith(name, ".b")) {
+      entries.push_back(path + "\\" + name);
+    }
+  } while(FindNextFileA(handle, &data));
+
+  FindClose(handle);
+#else
+  auto directory = opendir(path.c_str());
+
+  if(nullptr == directory) {
+    return false;
+  }
+
+  while(auto entry = readdir(directory)) {
+    const std::string name = entry->d_name;
+
+    if("." == name || ".." == name) {
+      continue;
+    }
+
+    entries.push_back(path + "/" + name);
+  }
+
+  closedir(directory);
 #endif
+
+  // The order of the entries depends on the file system so they are
+  // sorted to get the same units on every machine.
+  std::sort(entries.begin(), entries.end());
+
+  for(const auto& entry : entries) {
+    if(!listDirectory(entry, result) && endsWith(entry, ".b")) {
+      result->push_back(entry);
+    }
+  }
+
+  return true;
+}
+
+static bool isDirectory(const std::string& path) {
+#ifdef OS_WINDOWS
+  const auto attributes = GetFileAttributesA(path.c_str());
+
+  return INVALID_FILE_ATTRIBUTES != attributes &&
+    0 != (attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+  struct stat status;
+
+  return 0 == stat(path.c_str(), &status) && S_ISDIR(status.st_mode);
 #endif
+}
 
-#if 0
-  withFile("lang.b", [&](FILE* fp) {
-    auto stream = new brutus::internal::FileCharStream(fp);
-    auto lexer = new brutus::internal::Lexer();
-    
-    lexer->init(stream);
+static bool loadPrelude(brutus::Session* session, const Options& options) {
+  if(!options.m_isPrelude) {
+    return true;
+  }
 
-    brutus::internal::Token t;
-    auto numT = 0;
+  // The prelude image is written by brutus_mkimage. If there is
+  // none we fall back to compiling the prelude from source.
+  if(options.m_prelude.empty()) {
+    if(session->loadImage("prelude.img") || -1 != session->addDependency("lang.b")) {
+      return true;
+    }
 
-    while((t = lexer->nextToken()) != brutus::internal::Token::kEof) {
-      ++numT;
-      std::cout << '(' << lexer->posLine() << ':' << lexer->posColumn() << ')' << ' ' << brutus::internal::tok::toString(t) << std::endl;
+    std::cerr << "Could not read \"lang.b\"." << std::endl;
+    return false;
+  }
 
-      if(brutus::internal::tok::hasValue(t)) {
-        std::cout << lexer->value() << std::endl;
-      }
+  const auto& path = options.m_prelude;
+
+  if(endsWith(path, ".b") ? -1 != session->addDependency(path.c_str()) : session->loadImage(path.c_str())) {
+    return true;
+  }
+
+  std::cerr << "Could not read \"" << path << "\"." << std::endl;
+  return false;
+}
+
+int main(int argc, char** argv) {
+  std::vector<std::string> arguments(argv + 1, argv + argc);
+  Options options;
+
+  for(const auto& argument : arguments) {
+    if(argument == "--help") {
+      std::cout << kUsage;
+      return 0;
+    }
+  }
+
+  if(!parseArguments(arguments, 0, &options)) {
+    std::cerr << kUsage;
+    return 2;
+  }
+
+  if(options.m_inputs.empty()) {
+    std::cerr << "No input files." << std::endl << kUsage;
+    return 2;
+  }
+
+  brutus::Session session(options.m_numWorkers);
+
+  session.stopAfter(options.m_stage);
+
+  if(!options.m_cache.empty() && !session.useBuildCache(options.m_cache.c_str())) {
+    std::cerr << "Could not use \"" << options.m_cache << "\" as a cache." << std::endl;
+    return 1;
+  }
+
+  if(!options.m_modulePath.empty() && !session.useModulePath(options.m_modulePath.c_str())) {
+    std::cerr << "Could not use \"" << options.m_modulePath << "\" as a module path." << std::endl;
+    return 1;
+  }
+
+  if(!options.m_tracePath.empty()) {
+    session.startTrace();
+  }
+
+  if(!options.m_dumpPath.empty()) {
+    const auto format = endsWith(options.m_dumpPath, ".json")
+      ? brutus::Format::kJson
+      : brutus::Format::kText;
+
+    if(!session.dumpAst(options.m_dumpPath.c_str(), format)) {
+      std::cerr << "Could not write \"" << options.m_dumpPath << "\"." << std::endl;
+      return 1;
     }
+  }
+
+  if(!loadPrelude(&session, options)) {
+    return 1;
+  }
+
+  std::vector<std::string> files;
+
+  for(const auto& input : options.m_inputs) {
+    if(!isDirectory(input)) {
+      files.push_back(input);
+    } else if(!listDirectory(input, &files)) {
+      std::cerr << "Could not read \"" << input << "\"." << std::endl;
+      return 1;
+    }
+  }
 
-    std::cout << "Tokens: " << numT << std::endl;
+  // Diagnostics refer to units by index, which is mapped back to the
+  // path they have been read from. The only unit so far is a prelude
+  // that is compiled from source.
+  std::vector<std::string> paths;
 
-    delete lexer;
-    delete stream;
+  if(session.numUnits() > 0) {
+    paths.push_back(options.m_prelude.empty() ? "lang.b" : options.m_prelude);
+  }
+
+  for(const auto& file : files) {
+    if(-1 == session.addFile(file.c_str())) {
+      std::cerr << "Could not read \"" << file << "\"." << std::endl;
+      return 1;
+    }
+
+    paths.push_back(file);
+  }
+
+  const auto isSuccess = session.compile();
+
+  session.forEachMessage([&](const brutus::Message& message) {
+    std::cerr
+      << paths[static_cast<size_t>(message.m_unit)] << ':' << message.m_line << ':' << message.m_column
+      << (brutus::Severity::kError == message.m_severity ? ": error: " : ": warning: ")
+      << message.m_text << '\n';
   });
-#endif
 
-  return 0;
+  if(options.m_isTimeReport) {
+    session.writeMetrics(std::cout, brutus::Format::kText);
+  }
+
+  if(options.m_isMemReport) {
+    session.writeMemoryReport(std::cout);
+  }
+
+  if(!options.m_tracePath.empty() && !session.writeTrace(options.m_tracePath.c_str())) {
+    std::cerr << "Could not write \"" << options.m_tracePath << "\"." << std::endl;
+  }
+
+  return isSuccess ? 0 : 1;
 }
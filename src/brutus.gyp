@@ -1,45 +1,217 @@
 {
   'includes': ['../build/common.gypi'],
+  'variables': {
+    # Build libbrutus as a static_library or a shared_library.
+    'library%': 'static_library',
+    'brutus_sources': [
+      'alloc.cc',
+      'arena.cc',
+      'ast.cc',
+      'buffer.cc',
+      'build.cc',
+      'cache.cc',
+      'compiler.cc',
+      'diagnostics.cc',
+      'dump.cc',
+      'image.cc',
+      'incremental.cc',
+      'lexer.cc',
+      'lines.cc',
+      'list.cc',
+      'mapped.cc',
+      'metrics.cc',
+      'modules.cc',
+      'name.cc',
+      'parser.cc',
+      'phases.cc',
+      'scheduler.cc',
+      'scopes.cc',
+      'stopwatch.cc',
+      'streams.cc',
+      'symbols.cc',
+      'trace.cc',
+      'types.cc',
+      'writer.cc'
+    ],
+  },
+  'target_defaults': {
+    'conditions': [
+      ['OS=="linux"', {
+        'defines': [
+          'OS_LINUX',
+        ],
+        'include_dirs': [
+          'include/linux',
+        ],
+      }],
+      ['OS=="win"', {
+        'defines': [
+          'OS_WINDOWS',
+        ],
+      }, { # OS != "win",
+        'defines': [],
+      }]
+    ],
+  },
   'targets': [
     {
-      'target_name': 'brutus',
-      'type': 'executable',
+      # The compiler as a library. Embedders only include
+      # include/brutus.h, see api.cc.
+      'target_name': 'libbrutus',
+      'type': '<(library)',
       'dependencies': [],
-      'defines': [],
+      'defines': [
+        'BRUTUS_IMPLEMENTATION',
+      ],
       'include_dirs': [],
       'sources': [
-        'alloc.cc',
-        'arena.cc',
-        'ast.cc',
-        'brutus.cc',
-        'compiler.cc',
-        'lexer.cc',
-        'list.cc',
-        'name.cc',
-        'parser.cc',
-        'phases.cc',
-        'scopes.cc',
-        'stopwatch.cc',
-        'streams.cc',
-        'symbols.cc',
-        'types.cc'
+        '<@(brutus_sources)',
+        'api.cc'
       ],
+      'direct_dependent_settings': {
+        'include_dirs': [
+          '../include',
+        ],
+      },
       'conditions': [
-        ['OS=="linux"', {
+        ['library=="shared_library"', {
           'defines': [
-            'OS_LINUX',
+            'BRUTUS_SHARED',
           ],
-          'include_dirs': [
-            'include/linux',
+          'cflags': [
+            '-fPIC',
+            '-fvisibility=hidden',
           ],
+          'direct_dependent_settings': {
+            'defines': [
+              'BRUTUS_SHARED',
+            ],
+          },
         }],
-        ['OS=="win"', {
-          'defines': [
-            'OS_WINDOWS',
+      ],
+    },
+    {
+      'target_name': 'brutus',
+      'type': 'executable',
+      'dependencies': [
+        'libbrutus',
+      ],
+      'defines': [],
+      'include_dirs': [],
+      'sources': [
+        'brutus.cc'
+      ],
+    },
+    {
+      # Compiles requests from a Unix domain socket on top of a
+      # resident prelude, see server.cc.
+      'target_name': 'brutus_server',
+      'type': 'executable',
+      'dependencies': [
+        'libbrutus',
+      ],
+      'defines': [],
+      'include_dirs': [],
+      'sources': [
+        'server.cc'
+      ],
+    },
+    {
+      'target_name': 'brutus_mkimage',
+      'type': 'executable',
+      'dependencies': [],
+      'defines': [],
+      'include_dirs': [],
+      'sources': [
+        '<@(brutus_sources)',
+        'mkimage.cc'
+      ],
+    },
+    {
+      # Compares ASTVisitor with forEachChild on a generated AST, see
+      # bench/visitor.cc.
+      'target_name': 'brutus_visitorbench',
+      'type': 'executable',
+      'dependencies': [],
+      'defines': [],
+      'include_dirs': [
+        '.',
+      ],
+      'sources': [
+        '<@(brutus_sources)',
+        '../bench/corpus.cc',
+        '../bench/visitor.cc'
+      ],
+    },
+    {
+      # Writes a generated program of a given size, see bench/gencorpus.cc.
+      'target_name': 'brutus_corpus',
+      'type': 'executable',
+      'dependencies': [],
+      'defines': [],
+      'include_dirs': [
+        '.',
+      ],
+      'sources': [
+        '../bench/corpus.cc',
+        '../bench/gencorpus.cc'
+      ],
+    },
+    {
+      # Times each stage of the compiler, see bench/stages.cc.
+      'target_name': 'brutus_bench',
+      'type': 'executable',
+      'dependencies': [],
+      'defines': [],
+      'include_dirs': [
+        '.',
+      ],
+      'sources': [
+        '<@(brutus_sources)',
+        '../bench/corpus.cc',
+        '../bench/stages.cc',
+        '../bench/stats.cc'
+      ],
+    },
+    {
+      # Times the core data structures, see bench/micro.cc.
+      'target_name': 'brutus_microbench',
+      'type': 'executable',
+      'dependencies': [],
+      'defines': [],
+      'include_dirs': [
+        '.',
+      ],
+      'sources': [
+        '<@(brutus_sources)',
+        '../bench/micro.cc',
+        '../bench/stats.cc'
+      ],
+    },
+    {
+      # Precompiles the prelude so that brutus does not have to
+      # compile lang.b on every start.
+      'target_name': 'prelude_image',
+      'type': 'none',
+      'dependencies': [
+        'brutus_mkimage',
+      ],
+      'actions': [
+        {
+          'action_name': 'mkimage',
+          'inputs': [
+            'lang.b',
+            '<(PRODUCT_DIR)/brutus_mkimage',
+          ],
+          'outputs': [
+            '<(PRODUCT_DIR)/prelude.img',
+          ],
+          'action': [
+            '<(PRODUCT_DIR)/brutus_mkimage',
+            'lang.b',
+            '<(PRODUCT_DIR)/prelude.img',
           ],
-        }, { # OS != "win",
-          'defines': [],
-        }]
+        },
       ],
     }],
   }
@@ -0,0 +1,67 @@
+#include "buffer.h"
+
+#include <cstring>
+
+namespace brutus {
+namespace internal {
+void ByteBuffer::append(const void* data, size_t size) {
+  // Nothing to copy, data may be null.
+  if(0 == size) {
+    return;
+  }
+
+  if(m_size + size > m_capacity) {
+    reserve(m_size + size);
+  }
+
+  ArrayCopy(m_data + m_size, reinterpret_cast<const char*>(data), size);
+  m_size += size;
+}
+
+void ByteBuffer::align(size_t alignment) {
+  static const char kZero[consts::Alignment] = { 0 };
+
+  while(0 != (m_size % alignment)) {
+    auto padding = alignment - (m_size % alignment);
+    append(kZero, padding > sizeof(kZero) ? sizeof(kZero) : padding);
+  }
+}
+
+void ByteBuffer::replace(size_t offset, size_t length, const void* data, size_t size) {
+  const auto newSize = m_size - length + size;
+
+  if(newSize > m_capacity) {
+    reserve(newSize);
+  }
+
+  std::memmove(
+    m_data + offset + size,
+    m_data + offset + length,
+    m_size - offset - length);
+  ArrayCopy(m_data + offset, reinterpret_cast<const char*>(data), size);
+  m_size = newSize;
+}
+
+void ByteBuffer::reserve(size_t capacity) {
+  auto newCapacity = m_capacity == 0 ? consts::KiloByte : m_capacity;
+
+  while(newCapacity < capacity) {
+    newCapacity <<= 1;
+  }
+
+  auto newData = reinterpret_cast<char*>(Malloc::New(newCapacity));
+
+  if(nullptr != m_data) {
+    ArrayCopy(newData, m_data, m_size);
+    Malloc::Delete(m_data);
+  }
+
+  m_data = newData;
+  m_capacity = newCapacity;
+}
+
+bool ByteBuffer::writeTo(FILE* fp) const {
+  return m_size == 0 || fwrite(m_data, kCharSize, m_size, fp) == m_size;
+}
+} //namespace internal
+} //namespace brutus
@@ -0,0 +1,77 @@
+#ifndef BRUTUS_BUFFER_H_
+#define BRUTUS_BUFFER_H_
+
+#include <cstdio>
+
+#include "brutus.h"
+#include "alloc.h"
+
+namespace brutus {
+  namespace internal {
+    // A growable, heap allocated sequence of bytes.
+    //
+    // Used to assemble binary files like the prelude image before
+    // they are written in one go.
+    class ByteBuffer {
+      public:
+        explicit ByteBuffer()
+            : m_data(nullptr),
+              m_size(0),
+              m_capacity(0) {}
+
+        ~ByteBuffer() {
+          Malloc::Delete(m_data);
+        }
+
+        void append(const void* data, size_t size);
+
+        template<typename T>
+        ALWAYS_INLINE void append(const T& value) {
+          append(&value, sizeof(T)); //NOLINT
+        }
+
+        // Appends zero bytes until the size is a multiple of alignment.
+        void align(size_t alignment);
+
+        // Replaces length bytes at the given offset with size bytes of
+        // data. The bytes that follow are moved.
+        void replace(size_t offset, size_t length, const void* data, size_t size);
+
+        template<typename T>
+        ALWAYS_INLINE T* at(size_t offset) const {
+          return reinterpret_cast<T*>(m_data + offset);
+        }
+
+        ALWAYS_INLINE char* data() const {
+          return m_data;
+        }
+
+        ALWAYS_INLINE size_t size() const {
+          return m_size;
+        }
+
+        ALWAYS_INLINE void clear() {
+          m_size = 0;
+        }
+
+        // Drops all bytes after the first size bytes.
+        ALWAYS_INLINE void truncate(size_t size) {
+          if(size < m_size) {
+            m_size = size;
+          }
+        }
+
+        bool writeTo(FILE* fp) const;
+
+      private:
+        char* m_data;
+        size_t m_size;
+        size_t m_capacity;
+
+        void reserve(size_t capacity);
+
+        DISALLOW_COPY_AND_ASSIGN(ByteBuffer);
+    }; //class ByteBuffer
+  } //namespace internal
+} //namespace brutus
+#endif
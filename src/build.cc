@@ -0,0 +1,326 @@
+#include "build.h"
+#include "image.h"
+
+#ifndef OS_WINDOWS
+#include <sys/stat.h>
+#include <sys/types.h>
+#else
+#include <direct.h>
+#endif
+
+#include <cinttypes>
+#include <cstring>
+
+namespace brutus {
+namespace internal {
+void Artifact::restore(Diagnostics* diagnostics, NameTable* names) const {
+  auto data = m_file.data();
+  auto records = reinterpret_cast<const CacheDiagnostic*>(data + m_header->m_diagnosticsOffset);
+  auto cacheNames = reinterpret_cast<const CacheName*>(data + m_header->m_namesOffset);
+  auto pool = data + m_header->m_poolOffset;
+
+  for(uint32_t i = 0; i < m_header->m_numDiagnostics; ++i) {
+    auto& record = records[i];
+    const auto code = static_cast<DiagnosticCode>(record.m_code);
+    uint32_t args[2];
+
+    // Names are stored as indices into the names of the artifact.
+    for(int j = 0; j < 2; ++j) {
+      const auto value = record.m_args[j];
+
+      if(Diagnostics::isName(code, j) && kInvalidName != value) {
+        auto& name = cacheNames[value];
+        args[j] = names->get(pool + name.m_offset, static_cast<int>(name.m_length));
+      } else {
+        args[j] = value;
+      }
+    }
+
+    diagnostics->report(code, record.m_offset, args[0], args[1]);
+  }
+}
+
+void Artifact::uses(NameTable* names, List<NameId>* target) const {
+  auto data = m_file.data();
+  auto indices = reinterpret_cast<const uint32_t*>(data + m_header->m_usesOffset);
+  auto cacheNames = reinterpret_cast<const CacheName*>(data + m_header->m_namesOffset);
+  auto pool = data + m_header->m_poolOffset;
+
+  for(uint32_t i = 0; i < m_header->m_numUses; ++i) {
+    auto& name = cacheNames[indices[i]];
+    target->addLast(names->get(pool + name.m_offset, static_cast<int>(name.m_length)));
+  }
+}
+
+//
+
+BuildCache::BuildCache(NameTable* names)
+    : m_names(names),
+      m_parseCache(names),
+      m_directory(nullptr) {}
+
+BuildCache::~BuildCache() {
+  if(nullptr != m_directory) {
+    DeleteArray(m_directory);
+  }
+}
+
+bool BuildCache::open(const char* directory) {
+  if(nullptr != m_directory) {
+    DeleteArray(m_directory);
+    m_directory = nullptr;
+  }
+
+  if(!m_parseCache.open(directory)) {
+    return NO;
+  }
+
+  const auto length = std::strlen(directory) + 1;
+
+  m_directory = NewArray<char>(length);
+  ArrayCopy(m_directory, directory, length);
+
+  return YES;
+}
+
+uint64_t BuildCache::combine(uint64_t hash, uint64_t value) {
+  // FNV-1a over the bytes of the value, like ParseCache::hashOf.
+  for(int i = 0; i < 8; ++i) {
+    hash ^= (value >> (i * 8)) & 0xff;
+    hash *= 0x100000001b3ULL;
+  }
+
+  return hash;
+}
+
+uint64_t BuildCache::compilerHash() {
+  static const uint64_t kHash = combine(combine(
+    ParseCache::hashOf(BRUTUS_VERSION, sizeof(BRUTUS_VERSION) - 1), //NOLINT
+    (static_cast<uint64_t>(PhasesVersion) << 32) | ArtifactHeader::Version),
+    (static_cast<uint64_t>(ImageHeader::Version) << 32) | CacheHeader::Version);
+
+  return kHash;
+}
+
+uint64_t BuildCache::keyOf(const char* text, size_t length) {
+  return combine(compilerHash(), ParseCache::hashOf(text, length));
+}
+
+void BuildCache::pathOf(uint64_t key, char* path, size_t size) {
+  snprintf(path, size, "%s/%016" PRIx64 ".unit", m_directory, key);
+}
+
+bool BuildCache::isValid(const ArtifactHeader* header, size_t size) {
+  if(size < sizeof(ArtifactHeader)) { //NOLINT
+    return NO;
+  }
+
+  if(header->m_magic != ArtifactHeader::Magic ||
+     header->m_version != ArtifactHeader::Version) {
+    return NO;
+  }
+
+  const uint64_t diagnosticsEnd =
+    header->m_diagnosticsOffset +
+    static_cast<uint64_t>(header->m_numDiagnostics) * sizeof(CacheDiagnostic); //NOLINT
+  const uint64_t namesEnd =
+    header->m_namesOffset +
+    static_cast<uint64_t>(header->m_numNames) * sizeof(CacheName); //NOLINT
+  const uint64_t usesEnd =
+    header->m_usesOffset +
+    static_cast<uint64_t>(header->m_numUses) * sizeof(uint32_t); //NOLINT
+  const uint64_t interfaceEnd = static_cast<uint64_t>(header->m_interfaceOffset) + header->m_interfaceSize;
+  const uint64_t poolEnd = static_cast<uint64_t>(header->m_poolOffset) + header->m_poolSize;
+
+  // The records and the image are read in place.
+  const uint32_t alignment = sizeof(uint32_t) - 1; //NOLINT
+
+  if(0 != (header->m_diagnosticsOffset & alignment) ||
+     0 != (header->m_namesOffset & alignment) ||
+     0 != (header->m_usesOffset & alignment) ||
+     0 != (header->m_interfaceOffset & alignment)) {
+    return NO;
+  }
+
+  if(diagnosticsEnd > size || namesEnd > size || usesEnd > size || interfaceEnd > size || poolEnd > size) {
+    return NO;
+  }
+
+  auto data = reinterpret_cast<const char*>(header);
+  auto records = reinterpret_cast<const CacheDiagnostic*>(data + header->m_diagnosticsOffset);
+  auto names = reinterpret_cast<const CacheName*>(data + header->m_namesOffset);
+  auto uses = reinterpret_cast<const uint32_t*>(data + header->m_usesOffset);
+
+  for(uint32_t i = 0; i < header->m_numUses; ++i) {
+    if(uses[i] >= header->m_numNames) {
+      return NO;
+    }
+  }
+
+  for(uint32_t i = 0; i < header->m_numNames; ++i) {
+    if(static_cast<uint64_t>(names[i].m_offset) + names[i].m_length >= header->m_poolSize) {
+      return NO;
+    }
+  }
+
+  for(uint32_t i = 0; i < header->m_numDiagnostics; ++i) {
+    auto& record = records[i];
+
+    if(record.m_code >= static_cast<uint32_t>(DiagnosticCode::kNumCodes)) {
+      return NO;
+    }
+
+    for(int j = 0; j < 2; ++j) {
+      if(Diagnostics::isName(static_cast<DiagnosticCode>(record.m_code), j) &&
+         kInvalidName != record.m_args[j] &&
+         record.m_args[j] >= header->m_numNames) {
+        return NO;
+      }
+    }
+  }
+
+  return YES;
+}
+
+Artifact* BuildCache::find(const char* text, size_t length) {
+  if(!isOpen()) {
+    return nullptr;
+  }
+
+  const auto key = keyOf(text, length);
+  char path[0x400];
+
+  pathOf(key, path, sizeof(path)); //NOLINT
+
+  auto result = new Artifact();
+
+  if(!result->m_file.open(path)) {
+    delete result;
+    return nullptr;
+  }
+
+  auto header = reinterpret_cast<const ArtifactHeader*>(result->m_file.data());
+
+  if(!isValid(header, result->m_file.size()) ||
+     header->m_key != key ||
+     header->m_sourceSize != length) {
+    delete result;
+    return nullptr;
+  }
+
+  result->m_header = header;
+
+  return result;
+}
+
+bool BuildCache::store(
+    const char* text, size_t length, const ByteBuffer* interface,
+    List<NameId>* uses, uint64_t dependencyHash,
+    const Diagnostics* diagnostics) {
+  if(!isOpen()) {
+    return NO;
+  }
+
+  // Arguments that are names and uses are replaced with indices into
+  // the names of the artifact. The index is stored off by one since
+  // zero means "not present".
+  NameMap<uint32_t> nameIndex;
+  ByteBuffer records;
+  ByteBuffer names;
+  ByteBuffer usesBuffer;
+  ByteBuffer pool;
+  uint32_t numNames = 0;
+
+  auto indexOf = [&](NameId value) -> uint32_t {
+    auto index = nameIndex.get(value);
+
+    if(0 == index) {
+      CacheName name;
+
+      name.m_offset = pool.size();
+      name.m_length = m_names->length(value);
+
+      pool.append(m_names->value(value), name.m_length + 1);
+      names.append(name);
+      nameIndex.put(value, index = ++numNames);
+    }
+
+    return index - 1;
+  };
+
+  for(int i = 0; i < diagnostics->size(); ++i) {
+    auto& diagnostic = diagnostics->at(i);
+    CacheDiagnostic record;
+
+    record.m_code = static_cast<uint32_t>(diagnostic.m_code);
+    record.m_offset = diagnostic.m_offset;
+
+    for(int j = 0; j < 2; ++j) {
+      const auto value = diagnostic.m_args[j];
+
+      if(!Diagnostics::isName(diagnostic.m_code, j) || kInvalidName == value) {
+        record.m_args[j] = value;
+      } else {
+        record.m_args[j] = indexOf(value);
+      }
+    }
+
+    records.append(record);
+  }
+
+  uses->foreach([&](NameId value) {
+    usesBuffer.append(indexOf(value));
+  });
+
+  ArtifactHeader header;
+
+  header.m_magic = ArtifactHeader::Magic;
+  header.m_version = ArtifactHeader::Version;
+  header.m_key = keyOf(text, length);
+  header.m_numUses = static_cast<uint32_t>(uses->size());
+  header.m_dependencyHash = dependencyHash;
+  header.m_sourceSize = static_cast<uint32_t>(length);
+  header.m_numDiagnostics = static_cast<uint32_t>(diagnostics->size());
+  header.m_numNames = numNames;
+  header.m_interfaceSize = interface->size();
+  header.m_poolSize = pool.size();
+  header.m_diagnosticsOffset = sizeof(ArtifactHeader); //NOLINT
+  header.m_namesOffset = header.m_diagnosticsOffset + records.size();
+  header.m_usesOffset = header.m_namesOffset + names.size();
+  header.m_interfaceOffset = header.m_usesOffset + usesBuffer.size();
+  header.m_poolOffset = header.m_interfaceOffset + header.m_interfaceSize;
+  header.m_padding = 0;
+
+  char path[0x400];
+  char tempPath[sizeof(path) + 4]; //NOLINT
+
+  pathOf(header.m_key, path, sizeof(path)); //NOLINT
+  snprintf(tempPath, sizeof(tempPath), "%s.tmp", path); //NOLINT
+
+  // The artifact is written to a temporary file first so a reader
+  // never sees a partial artifact.
+  auto fp = fopen(tempPath, "wb");
+
+  if(!fp) {
+    return NO;
+  }
+
+  const bool result =
+    fwrite(&header, sizeof(header), 1, fp) == 1 && //NOLINT
+    records.writeTo(fp) &&
+    names.writeTo(fp) &&
+    usesBuffer.writeTo(fp) &&
+    interface->writeTo(fp) &&
+    pool.writeTo(fp);
+
+  fclose(fp);
+
+  if(!result || 0 != rename(tempPath, path)) {
+    remove(tempPath);
+    return NO;
+  }
+
+  return YES;
+}
+} //namespace internal
+} //namespace brutus
@@ -0,0 +1,148 @@
+#ifndef BRUTUS_BUILD_H_
+#define BRUTUS_BUILD_H_
+
+#include "brutus.h"
+#include "buffer.h"
+#include "cache.h"
+#include "diagnostics.h"
+#include "list.h"
+#include "mapped.h"
+#include "name.h"
+
+namespace brutus {
+  namespace internal {
+    // The artifacts of a unit in the build cache.
+    //
+    // An artifact is named after a hash of the version of the compiler
+    // and the text of its unit. It holds everything a compile of the
+    // unit produces that other units or the user see: the interface of
+    // the unit, which is an image of the modules it declares, and its
+    // diagnostics. The AST of the unit is kept by the parse cache in
+    // the same directory.
+    //
+    // The diagnostics of the link phase depend on the interfaces of
+    // the modules the unit uses as well. An artifact is only up to date
+    // if the hash of those interfaces is the one it has been linked
+    // against.
+    //
+    // Layout:
+    //
+    //   ArtifactHeader
+    //   CacheDiagnostic[numDiagnostics]
+    //   CacheName[numNames]      names of diagnostic arguments and uses
+    //   uint32_t[numUses]        names of the modules the unit uses
+    //   char[interfaceSize]      the image of the declared modules
+    //   char[poolSize]           zero-terminated characters of all names
+    class ArtifactHeader {
+      public:
+        static const uint32_t Magic = 0x55415242; // "BRAU"
+        static const uint32_t Version = 2;
+
+        uint32_t m_magic;
+        uint32_t m_version;
+        uint64_t m_key;
+        uint32_t m_numUses;
+        uint32_t m_usesOffset;
+        uint64_t m_dependencyHash;
+        uint32_t m_sourceSize;
+        uint32_t m_numDiagnostics;
+        uint32_t m_numNames;
+        uint32_t m_interfaceSize;
+        uint32_t m_poolSize;
+        uint32_t m_diagnosticsOffset;
+        uint32_t m_namesOffset;
+        uint32_t m_interfaceOffset;
+        uint32_t m_poolOffset;
+        uint32_t m_padding;
+    };
+
+    // An artifact that has been found in the build cache. It is read
+    // straight from the mapped file.
+    class Artifact {
+      public:
+        explicit Artifact() : m_header(nullptr) {}
+
+        ALWAYS_INLINE uint64_t dependencyHash() const {
+          return m_header->m_dependencyHash;
+        }
+
+        ALWAYS_INLINE const char* interface() const {
+          return m_file.data() + m_header->m_interfaceOffset;
+        }
+
+        ALWAYS_INLINE size_t interfaceSize() const {
+          return m_header->m_interfaceSize;
+        }
+
+        // Reports the diagnostics of the artifact again.
+        void restore(Diagnostics* diagnostics, NameTable* names) const;
+
+        // Appends the modules the unit has been linked against.
+        void uses(NameTable* names, List<NameId>* target) const;
+
+      private:
+        MappedFile m_file;
+        const ArtifactHeader* m_header;
+
+        friend class BuildCache;
+
+        DISALLOW_COPY_AND_ASSIGN(Artifact);
+    }; //class Artifact
+
+    class BuildCache {
+      public:
+        // The version of the phases whose results end up in artifacts.
+        // Bump it with every change to parsing, symbols or linking that
+        // changes the diagnostics or the interface of any unit.
+        static const uint32_t PhasesVersion = 4;
+
+        explicit BuildCache(NameTable* names);
+        ~BuildCache();
+
+        // Uses the given directory for all artifacts and creates it if
+        // it does not exist yet. ASTs are cached there as well.
+        bool open(const char* directory);
+
+        ALWAYS_INLINE bool isOpen() const {
+          return m_parseCache.isOpen();
+        }
+
+        ALWAYS_INLINE ParseCache* parseCache() {
+          return &m_parseCache;
+        }
+
+        // Returns the artifact of the given source text or nullptr if
+        // there is none. The caller deletes it.
+        Artifact* find(const char* text, size_t length);
+
+        // Stores the artifact of the given source text. The interface
+        // is an image of the modules the unit declares.
+        bool store(
+          const char* text, size_t length, const ByteBuffer* interface,
+          List<NameId>* uses, uint64_t dependencyHash,
+          const Diagnostics* diagnostics);
+
+        // Mixes a value into a hash.
+        static uint64_t combine(uint64_t hash, uint64_t value);
+
+        // A hash of the versions of the phases and of all formats an
+        // artifact depends on. Artifacts of another version are never
+        // used. The same sources of the compiler always give the same
+        // hash.
+        static uint64_t compilerHash();
+
+      private:
+        NameTable* const m_names;
+        ParseCache m_parseCache;
+        char* m_directory;
+
+        void pathOf(uint64_t key, char* path, size_t size);
+        bool isValid(const ArtifactHeader* header, size_t size);
+
+        static uint64_t keyOf(const char* text, size_t length);
+
+        DISALLOW_COPY_AND_ASSIGN(BuildCache);
+    }; //class BuildCache
+  } //namespace internal
+} //namespace brutus
+#endif
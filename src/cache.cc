@@ -0,0 +1,1007 @@
+#include "cache.h"
+
+#ifndef OS_WINDOWS
+#include <sys/stat.h>
+#include <sys/types.h>
+#else
+#include <direct.h>
+#endif
+
+#include <cinttypes>
+#include <cstring>
+
+namespace brutus {
+namespace internal {
+namespace ast {
+// The AST of a cache entry. It is the format of the entry itself and
+// nothing but the parse cache uses it.
+//
+// Nodes are addressed by 32-bit indices and their data is kept in
+// parallel arrays instead of one object per node:
+//
+//   kinds[i]       the NodeKind of node i or ListKind
+//   payloads[i]    a NameId, flags or a count, depending on the kind
+//   offsets[i]     source offset of node i
+//   firstChild[i]  index of the first child slot of node i
+//   children[j]    node index of child slot j or None
+//
+// Every kind has a fixed number of child slots (see numSlots()).
+// Missing children are None. A NodeList is stored as a list node
+// whose payload is its length and whose slots are its elements.
+// The body of a function that has been skipped in outline mode is a
+// lazy node in the slot of the body. Its offset is the start of the
+// body and its payload the length.
+//
+// Nodes are stored in preorder so a linear scan over the arrays
+// visits them in the same order as a depth-first traversal. A
+// node costs 13 bytes plus 4 bytes per child slot.
+//
+// The arrays are either owned by the tree or borrowed from memory
+// the tree has been attached to, for instance a mapped file. The
+// names of a borrowed tree may be local to the file it comes from
+// in which case mapNames() translates them to ids of this process.
+class CacheTree {
+  public:
+    typedef uint32_t Index;
+
+    static const Index None = 0xffffffff;
+    static const uint8_t ListKind = 0xff;
+    static const uint8_t LazyKind = 0xfe;
+
+    // Error nodes keep their diagnostic in a side table.
+    class ErrorRecord {
+      public:
+        uint32_t m_code;
+        uint32_t m_args[2];
+    };
+
+    explicit CacheTree();
+
+    // Flattens the given AST and returns the index of its root.
+    Index add(Node* node);
+
+    // Creates the pointer based AST of the given node.
+    Node* expand(Index index, Arena* arena);
+
+    // Makes the tree a view of externally owned arrays.
+    void attach(
+      uint32_t numNodes,
+      const uint8_t* kinds,
+      const uint32_t* payloads,
+      const uint32_t* offsets,
+      const uint32_t* firstChild,
+      uint32_t numChildren,
+      const Index* children,
+      uint32_t numErrors,
+      const ErrorRecord* errors);
+
+    // Payloads of names are indices into the given array instead
+    // of NameIds. The array must outlive the tree.
+    void mapNames(const NameId* names);
+
+    // Skipped bodies of an expanded tree refer to the given text.
+    void source(const char* text);
+
+    static int numSlots(uint8_t kind);
+
+    // Whether the payload of the given kind is a name.
+    static bool hasName(uint8_t kind);
+
+    ALWAYS_INLINE uint32_t size() const {
+      return m_numNodes;
+    }
+
+    ALWAYS_INLINE bool isList(Index index) const {
+      return m_kinds[index] == ListKind;
+    }
+
+    ALWAYS_INLINE bool isLazy(Index index) const {
+      return m_kinds[index] == LazyKind;
+    }
+
+    ALWAYS_INLINE NodeKind kind(Index index) const {
+      return static_cast<NodeKind>(m_kinds[index]);
+    }
+
+    ALWAYS_INLINE uint32_t payload(Index index) const {
+      return m_payloads[index];
+    }
+
+    ALWAYS_INLINE uint32_t offset(Index index) const {
+      return m_offsets[index];
+    }
+
+    ALWAYS_INLINE NameId name(Index index) const {
+      return nullptr == m_names
+        ? static_cast<NameId>(m_payloads[index])
+        : m_names[m_payloads[index]];
+    }
+
+    ALWAYS_INLINE int numChildren(Index index) const {
+      return isList(index)
+        ? static_cast<int>(m_payloads[index])
+        : numSlots(m_kinds[index]);
+    }
+
+    ALWAYS_INLINE Index child(Index index, int slot) const {
+      return m_children[m_firstChild[index] + slot];
+    }
+
+    ALWAYS_INLINE const ErrorRecord& error(Index index) const {
+      return m_errors[m_payloads[index]];
+    }
+
+    ALWAYS_INLINE uint32_t numChildSlots() const { return m_numChildren; }
+    ALWAYS_INLINE uint32_t numErrors() const { return m_numErrors; }
+    ALWAYS_INLINE const uint8_t* kinds() const { return m_kinds; }
+    ALWAYS_INLINE const uint32_t* payloads() const { return m_payloads; }
+    ALWAYS_INLINE const uint32_t* offsets() const { return m_offsets; }
+    ALWAYS_INLINE const uint32_t* firstChild() const { return m_firstChild; }
+    ALWAYS_INLINE const Index* children() const { return m_children; }
+    ALWAYS_INLINE const ErrorRecord* errors() const { return m_errors; }
+
+  private:
+    ByteBuffer m_kindsBuffer;
+    ByteBuffer m_payloadsBuffer;
+    ByteBuffer m_offsetsBuffer;
+    ByteBuffer m_firstChildBuffer;
+    ByteBuffer m_childrenBuffer;
+    ByteBuffer m_errorsBuffer;
+
+    uint32_t m_numNodes;
+    uint32_t m_numChildren;
+    uint32_t m_numErrors;
+    const uint8_t* m_kinds;
+    const uint32_t* m_payloads;
+    const uint32_t* m_offsets;
+    const uint32_t* m_firstChild;
+    const Index* m_children;
+    const ErrorRecord* m_errors;
+    const NameId* m_names;
+    const char* m_source;
+
+    Index newNode(uint8_t kind, uint32_t payload, uint32_t offset, int numSlots);
+    Index addNode(Node* node);
+    void setChild(Index index, int slot, Index child);
+    Index addList(NodeList* list);
+    Index addLazyBody(LazyBody* body);
+    uint32_t payloadOf(Node* node);
+    void update();
+    Node* expandNode(Index index, Arena* arena);
+    void expandList(Index index, NodeList* list, Arena* arena);
+
+    DISALLOW_COPY_AND_ASSIGN(CacheTree);
+}; //class CacheTree
+
+static const uint32_t kVariableModifiable = 1;
+static const uint32_t kVariableForce = 2;
+
+CacheTree::CacheTree()
+    : m_numNodes(0),
+      m_numChildren(0),
+      m_numErrors(0),
+      m_kinds(nullptr),
+      m_payloads(nullptr),
+      m_offsets(nullptr),
+      m_firstChild(nullptr),
+      m_children(nullptr),
+      m_errors(nullptr),
+      m_names(nullptr),
+      m_source(nullptr) {}
+
+int CacheTree::numSlots(uint8_t kind) {
+  if(kind == ListKind || kind == LazyKind) {
+    return 0;
+  }
+
+  switch(static_cast<NodeKind>(kind)) {
+    case NodeKind::kArgument: return 2;
+    case NodeKind::kAssign: return 2;
+    case NodeKind::kBlock: return 1;
+    case NodeKind::kCall: return 2;
+    case NodeKind::kClass: return 3;
+    case NodeKind::kFunction: return 5;
+    case NodeKind::kIf: return 1;
+    case NodeKind::kIfCase: return 2;
+    case NodeKind::kModule: return 3;
+    case NodeKind::kModuleDependency: return 2;
+    case NodeKind::kParameter: return 2;
+    case NodeKind::kProgram: return 1;
+    case NodeKind::kSelect: return 2;
+    case NodeKind::kTypeParameter: return 2;
+    case NodeKind::kVariable: return 3;
+    default: return 0;
+  }
+}
+
+bool CacheTree::hasName(uint8_t kind) {
+  switch(static_cast<NodeKind>(kind)) {
+    case NodeKind::kIdentifier:
+    case NodeKind::kNumber:
+    case NodeKind::kString:
+      return YES;
+    default:
+      return NO;
+  }
+}
+
+CacheTree::Index CacheTree::newNode(uint8_t kind, uint32_t payload, uint32_t offset, int numSlots) {
+  static const Index kNone = None;
+  const Index index = m_numNodes++;
+  const uint32_t firstChild = m_numChildren;
+
+  m_kindsBuffer.append(kind);
+  m_payloadsBuffer.append(payload);
+  m_offsetsBuffer.append(offset);
+  m_firstChildBuffer.append(firstChild);
+
+  // Slots are reserved up front and patched once the children have
+  // been added since children follow their parent in preorder.
+  for(int i = 0; i < numSlots; ++i) {
+    m_childrenBuffer.append(kNone);
+  }
+
+  m_numChildren += numSlots;
+
+  return index;
+}
+
+void CacheTree::setChild(Index index, int slot, Index child) {
+  auto firstChild = *m_firstChildBuffer.at<uint32_t>(index * sizeof(uint32_t)); //NOLINT
+  *m_childrenBuffer.at<Index>((firstChild + slot) * sizeof(Index)) = child; //NOLINT
+}
+
+uint32_t CacheTree::payloadOf(Node* node) {
+  switch(node->kind()) {
+    case NodeKind::kIdentifier:
+      return static_cast<Identifier*>(node)->name();
+    case NodeKind::kNumber:
+      return static_cast<Number*>(node)->name();
+    case NodeKind::kString:
+      return static_cast<String*>(node)->name();
+    case NodeKind::kFunction:
+      return static_cast<Function*>(node)->flags();
+    case NodeKind::kClass:
+      return static_cast<Class*>(node)->flags();
+    case NodeKind::kTypeParameter:
+      return static_cast<TypeParameter*>(node)->boundType();
+    case NodeKind::kAssign:
+      return static_cast<Assign*>(node)->force() ? 1 : 0;
+    case NodeKind::kVariable: {
+        auto variable = static_cast<Variable*>(node);
+        return (variable->isModifiable() ? kVariableModifiable : 0) |
+               (variable->force() ? kVariableForce : 0);
+      }
+    case NodeKind::kError: {
+        auto error = static_cast<Error*>(node);
+        ErrorRecord record;
+
+        record.m_code = static_cast<uint32_t>(error->code());
+        record.m_args[0] = error->arg(0);
+        record.m_args[1] = error->arg(1);
+
+        m_errorsBuffer.append(record);
+
+        return m_numErrors++;
+      }
+    default:
+      return 0;
+  }
+}
+
+CacheTree::Index CacheTree::addList(NodeList* list) {
+  const int n = list->size();
+  auto index = newNode(ListKind, static_cast<uint32_t>(n), 0, n);
+  auto nodes = list->nodes();
+
+  for(int i = 0; i < n; ++i) {
+    setChild(index, i, addNode(nodes[i]));
+  }
+
+  return index;
+}
+
+CacheTree::Index CacheTree::addLazyBody(LazyBody* body) {
+  return newNode(
+    LazyKind,
+    static_cast<uint32_t>(body->length()),
+    static_cast<uint32_t>(body->offset()),
+    0);
+}
+
+CacheTree::Index CacheTree::addNode(Node* node) {
+  if(nullptr == node) {
+    return None;
+  }
+
+  const auto kind = static_cast<uint8_t>(node->kind());
+  auto index = newNode(kind, payloadOf(node), node->offset(), numSlots(kind));
+
+  switch(node->kind()) {
+    case NodeKind::kArgument: {
+        auto argument = static_cast<Argument*>(node);
+        setChild(index, 0, addNode(argument->name()));
+        setChild(index, 1, addNode(argument->value()));
+      }
+      break;
+    case NodeKind::kAssign: {
+        auto assign = static_cast<Assign*>(node);
+        setChild(index, 0, addNode(assign->target()));
+        setChild(index, 1, addNode(assign->value()));
+      }
+      break;
+    case NodeKind::kBlock:
+      setChild(index, 0, addList(static_cast<Block*>(node)->expressions()));
+      break;
+    case NodeKind::kCall: {
+        auto call = static_cast<Call*>(node);
+        setChild(index, 0, addNode(call->callee()));
+        setChild(index, 1, addList(call->arguments()));
+      }
+      break;
+    case NodeKind::kClass: {
+        auto klass = static_cast<Class*>(node);
+        setChild(index, 0, addNode(klass->name()));
+        setChild(index, 1, addList(klass->typeParameters()));
+        setChild(index, 2, addList(klass->members()));
+      }
+      break;
+    case NodeKind::kFunction: {
+        auto function = static_cast<Function*>(node);
+        setChild(index, 0, addNode(function->name()));
+        setChild(index, 1, addNode(function->type()));
+        setChild(index, 2,
+          function->hasLazyBody()
+            ? addLazyBody(function->lazyBody())
+            : addNode(function->expr()));
+        setChild(index, 3, addList(function->typeParameters()));
+        setChild(index, 4, addList(function->parameters()));
+      }
+      break;
+    case NodeKind::kIf:
+      setChild(index, 0, addList(static_cast<If*>(node)->cases()));
+      break;
+    case NodeKind::kIfCase: {
+        auto ifCase = static_cast<IfCase*>(node);
+        setChild(index, 0, addNode(ifCase->condition()));
+        setChild(index, 1, addNode(ifCase->expr()));
+      }
+      break;
+    case NodeKind::kModule: {
+        auto module = static_cast<Module*>(node);
+        setChild(index, 0, addNode(module->name()));
+        setChild(index, 1, addList(module->declarations()));
+        setChild(index, 2, addList(module->dependencies()));
+      }
+      break;
+    case NodeKind::kModuleDependency: {
+        auto dependency = static_cast<ModuleDependency*>(node);
+        setChild(index, 0, addNode(dependency->name()));
+        setChild(index, 1, addNode(dependency->version()));
+      }
+      break;
+    case NodeKind::kParameter: {
+        auto parameter = static_cast<Parameter*>(node);
+        setChild(index, 0, addNode(parameter->name()));
+        setChild(index, 1, addNode(parameter->type()));
+      }
+      break;
+    case NodeKind::kProgram:
+      setChild(index, 0, addList(static_cast<Program*>(node)->modules()));
+      break;
+    case NodeKind::kSelect: {
+        auto select = static_cast<Select*>(node);
+        setChild(index, 0, addNode(select->object()));
+        setChild(index, 1, addNode(select->qualifier()));
+      }
+      break;
+    case NodeKind::kTypeParameter: {
+        auto typeParameter = static_cast<TypeParameter*>(node);
+        setChild(index, 0, addNode(typeParameter->name()));
+        setChild(index, 1, addNode(typeParameter->bound()));
+      }
+      break;
+    case NodeKind::kVariable: {
+        auto variable = static_cast<Variable*>(node);
+        setChild(index, 0, addNode(variable->name()));
+        setChild(index, 1, addNode(variable->type()));
+        setChild(index, 2, addNode(variable->init()));
+      }
+      break;
+    default:
+      break;
+  }
+
+  return index;
+}
+
+CacheTree::Index CacheTree::add(Node* node) {
+  auto result = addNode(node);
+  update();
+  return result;
+}
+
+void CacheTree::update() {
+  // The buffers may move while nodes are added so the views are
+  // refreshed once the tree is complete.
+  m_kinds = reinterpret_cast<const uint8_t*>(m_kindsBuffer.data());
+  m_payloads = m_payloadsBuffer.at<uint32_t>(0);
+  m_offsets = m_offsetsBuffer.at<uint32_t>(0);
+  m_firstChild = m_firstChildBuffer.at<uint32_t>(0);
+  m_children = m_childrenBuffer.at<Index>(0);
+  m_errors = m_errorsBuffer.at<ErrorRecord>(0);
+  m_names = nullptr;
+}
+
+void CacheTree::attach(
+    uint32_t numNodes,
+    const uint8_t* kinds,
+    const uint32_t* payloads,
+    const uint32_t* offsets,
+    const uint32_t* firstChild,
+    uint32_t numChildren,
+    const Index* children,
+    uint32_t numErrors,
+    const ErrorRecord* errors) {
+  m_kindsBuffer.clear();
+  m_payloadsBuffer.clear();
+  m_offsetsBuffer.clear();
+  m_firstChildBuffer.clear();
+  m_childrenBuffer.clear();
+  m_errorsBuffer.clear();
+
+  m_numNodes = numNodes;
+  m_numChildren = numChildren;
+  m_numErrors = numErrors;
+  m_kinds = kinds;
+  m_payloads = payloads;
+  m_offsets = offsets;
+  m_firstChild = firstChild;
+  m_children = children;
+  m_errors = errors;
+  m_names = nullptr;
+}
+
+void CacheTree::mapNames(const NameId* names) {
+  m_names = names;
+}
+
+void CacheTree::source(const char* text) {
+  m_source = text;
+}
+
+void CacheTree::expandList(Index index, NodeList* list, Arena* arena) {
+  if(None == index) {
+    return;
+  }
+
+  const int n = numChildren(index);
+
+  for(int i = 0; i < n; ++i) {
+    list->add(expand(child(index, i), arena), arena);
+  }
+}
+
+Node* CacheTree::expand(Index index, Arena* arena) {
+  if(None == index) {
+    return nullptr;
+  }
+
+  auto result = expandNode(index, arena);
+  result->offset(m_offsets[index]);
+
+  return result;
+}
+
+Node* CacheTree::expandNode(Index index, Arena* arena) {
+  const auto value = payload(index);
+
+  switch(kind(index)) {
+    case NodeKind::kArgument: {
+        auto node = new (arena) Argument();
+        node->init(expand(child(index, 0), arena), expand(child(index, 1), arena));
+        return node;
+      }
+    case NodeKind::kAssign: {
+        auto node = new (arena) Assign();
+        node->init(expand(child(index, 0), arena), expand(child(index, 1), arena), 0 != value);
+        return node;
+      }
+    case NodeKind::kBlock: {
+        auto node = new (arena) Block();
+        expandList(child(index, 0), node->expressions(), arena);
+        return node;
+      }
+    case NodeKind::kCall: {
+        auto node = new (arena) Call();
+        node->init(expand(child(index, 0), arena));
+        expandList(child(index, 1), node->arguments(), arena);
+        return node;
+      }
+    case NodeKind::kClass: {
+        auto node = new (arena) Class();
+        node->init(expand(child(index, 0), arena), value);
+        expandList(child(index, 1), node->typeParameters(), arena);
+        expandList(child(index, 2), node->members(), arena);
+        return node;
+      }
+    case NodeKind::kError: {
+        auto& record = error(index);
+        auto node = new (arena) Error();
+
+        node->init(
+          static_cast<DiagnosticCode>(record.m_code),
+          record.m_args[0],
+          record.m_args[1]);
+        return node;
+      }
+    case NodeKind::kFalse:
+      return new (arena) False();
+    case NodeKind::kFunction: {
+        auto node = new (arena) Function();
+        auto body = child(index, 2);
+        const bool isSkipped = None != body && isLazy(body);
+
+        node->init(
+          expand(child(index, 0), arena),
+          expand(child(index, 1), arena),
+          isSkipped ? nullptr : expand(body, arena),
+          value);
+
+        if(isSkipped) {
+          auto lazyBody = new (arena) LazyBody();
+          lazyBody->init(m_source, offset(body), payload(body));
+          node->lazyBody(lazyBody);
+        }
+
+        expandList(child(index, 3), node->typeParameters(), arena);
+        expandList(child(index, 4), node->parameters(), arena);
+        return node;
+      }
+    case NodeKind::kIdentifier: {
+        auto node = new (arena) Identifier();
+        node->init(name(index));
+        return node;
+      }
+    case NodeKind::kIf: {
+        auto node = new (arena) If();
+        expandList(child(index, 0), node->cases(), arena);
+        return node;
+      }
+    case NodeKind::kIfCase: {
+        auto node = new (arena) IfCase();
+        node->init(expand(child(index, 0), arena), expand(child(index, 1), arena));
+        return node;
+      }
+    case NodeKind::kModule: {
+        auto node = new (arena) Module();
+        node->init(expand(child(index, 0), arena));
+        expandList(child(index, 1), node->declarations(), arena);
+        expandList(child(index, 2), node->dependencies(), arena);
+        return node;
+      }
+    case NodeKind::kModuleDependency: {
+        auto node = new (arena) ModuleDependency();
+        node->init(expand(child(index, 0), arena), expand(child(index, 1), arena));
+        return node;
+      }
+    case NodeKind::kNumber: {
+        auto node = new (arena) Number();
+        node->init(name(index));
+        return node;
+      }
+    case NodeKind::kParameter: {
+        auto node = new (arena) Parameter();
+        node->init(expand(child(index, 0), arena), expand(child(index, 1), arena));
+        return node;
+      }
+    case NodeKind::kProgram: {
+        auto node = new (arena) Program();
+        expandList(child(index, 0), node->modules(), arena);
+        return node;
+      }
+    case NodeKind::kSelect: {
+        auto node = new (arena) Select();
+        node->init(expand(child(index, 0), arena), expand(child(index, 1), arena));
+        return node;
+      }
+    case NodeKind::kString: {
+        auto node = new (arena) String();
+        node->init(name(index));
+        return node;
+      }
+    case NodeKind::kThis:
+      return new (arena) This();
+    case NodeKind::kTrue:
+      return new (arena) True();
+    case NodeKind::kTypeParameter: {
+        auto node = new (arena) TypeParameter();
+        node->init(expand(child(index, 0), arena), expand(child(index, 1), arena), value);
+        return node;
+      }
+    case NodeKind::kVariable: {
+        auto node = new (arena) Variable();
+        node->init(
+          0 != (value & kVariableModifiable),
+          expand(child(index, 0), arena),
+          expand(child(index, 1), arena),
+          expand(child(index, 2), arena),
+          0 != (value & kVariableForce));
+        return node;
+      }
+  }
+
+#ifdef DEBUG
+  std::cerr << "Error: Unknown node kind " << static_cast<int>(m_kinds[index]) << "." << std::endl;
+#endif
+  return nullptr;
+}
+} //namespace ast
+
+#define COUNT_NODE_KIND(x) + 1
+static const uint8_t kNumNodeKinds = 0 AST_NODE_KINDS(COUNT_NODE_KIND);
+#undef COUNT_NODE_KIND
+
+ParseCache::ParseCache(NameTable* names)
+    : m_names(names),
+      m_directory(nullptr) {}
+
+ParseCache::~ParseCache() {
+  if(nullptr != m_directory) {
+    DeleteArray(m_directory);
+  }
+}
+
+bool ParseCache::open(const char* directory) {
+  if(nullptr != m_directory) {
+    DeleteArray(m_directory);
+    m_directory = nullptr;
+  }
+
+#ifndef OS_WINDOWS
+  mkdir(directory, 0755);
+#else
+  _mkdir(directory);
+#endif
+
+  const auto length = std::strlen(directory) + 1;
+
+  m_directory = NewArray<char>(length);
+  ArrayCopy(m_directory, directory, length);
+
+  return YES;
+}
+
+uint64_t ParseCache::hashOf(const char* text, size_t length) {
+  // 64-bit FNV-1a. The size of the text is part of the header of an
+  // entry as well so a collision would also need the same length.
+  uint64_t result = 0xcbf29ce484222325ULL;
+
+  for(size_t i = 0; i < length; ++i) {
+    result ^= static_cast<uint8_t>(text[i]);
+    result *= 0x100000001b3ULL;
+  }
+
+  return result;
+}
+
+uint64_t ParseCache::keyOf(const char* text, size_t length, bool isOutline) {
+  // The outline of a text is another entry than its complete tree.
+  const auto hash = hashOf(text, length);
+  return isOutline ? (hash ^ 0xff) * 0x100000001b3ULL : hash;
+}
+
+void ParseCache::pathOf(uint64_t hash, char* path, size_t size) {
+  snprintf(path, size, "%s/%016" PRIx64 ".ast", m_directory, hash);
+}
+
+bool ParseCache::store(const char* text, size_t length, bool isOutline, ast::Node* node, const Diagnostics* diagnostics) {
+  if(!isOpen() || nullptr == node) {
+    return NO;
+  }
+
+  ast::CacheTree tree;
+  const auto root = tree.add(node);
+  const auto numNodes = tree.size();
+
+  // Payloads of names are replaced with indices into the names of the
+  // entry. The index is stored off by one since zero means "not
+  // present".
+  NameMap<uint32_t> nameIndex;
+  ByteBuffer payloads;
+  ByteBuffer names;
+  ByteBuffer pool;
+  uint32_t numNames = 0;
+
+  for(ast::CacheTree::Index i = 0; i < numNodes; ++i) {
+    auto payload = tree.payload(i);
+
+    if(ast::CacheTree::hasName(tree.kinds()[i])) {
+      const auto name = static_cast<NameId>(payload);
+      auto index = nameIndex.get(name);
+
+      if(0 == index) {
+        CacheName record;
+
+        record.m_offset = pool.size();
+        record.m_length = m_names->length(name);
+
+        pool.append(m_names->value(name), record.m_length + 1);
+        names.append(record);
+        nameIndex.put(name, index = ++numNames);
+      }
+
+      payload = index - 1;
+    }
+
+    payloads.append(payload);
+  }
+
+  ByteBuffer records;
+
+  for(int i = 0; i < diagnostics->size(); ++i) {
+    auto& diagnostic = diagnostics->at(i);
+    CacheDiagnostic record;
+
+    record.m_code = static_cast<uint32_t>(diagnostic.m_code);
+    record.m_offset = diagnostic.m_offset;
+    record.m_args[0] = diagnostic.m_args[0];
+    record.m_args[1] = diagnostic.m_args[1];
+
+    records.append(record);
+  }
+
+  CacheHeader header;
+
+  header.m_magic = CacheHeader::Magic;
+  header.m_version = CacheHeader::Version;
+  header.m_sourceHash = keyOf(text, length, isOutline);
+  header.m_sourceSize = static_cast<uint32_t>(length);
+  header.m_root = root;
+  header.m_numNodes = numNodes;
+  header.m_numChildren = tree.numChildSlots();
+  header.m_numErrors = tree.numErrors();
+  header.m_numDiagnostics = static_cast<uint32_t>(diagnostics->size());
+  header.m_numNames = numNames;
+  header.m_poolSize = pool.size();
+  header.m_payloadsOffset = sizeof(CacheHeader); //NOLINT
+  header.m_offsetsOffset = header.m_payloadsOffset + numNodes * sizeof(uint32_t); //NOLINT
+  header.m_firstChildOffset = header.m_offsetsOffset + numNodes * sizeof(uint32_t); //NOLINT
+  header.m_childrenOffset = header.m_firstChildOffset + numNodes * sizeof(uint32_t); //NOLINT
+  header.m_errorsOffset = header.m_childrenOffset + header.m_numChildren * sizeof(ast::CacheTree::Index); //NOLINT
+  header.m_diagnosticsOffset = header.m_errorsOffset + header.m_numErrors * sizeof(ast::CacheTree::ErrorRecord); //NOLINT
+  header.m_namesOffset = header.m_diagnosticsOffset + records.size();
+  header.m_kindsOffset = header.m_namesOffset + names.size();
+  header.m_poolOffset = header.m_kindsOffset + numNodes;
+
+  char path[0x400];
+  char tempPath[sizeof(path) + 4]; //NOLINT
+
+  pathOf(header.m_sourceHash, path, sizeof(path)); //NOLINT
+  snprintf(tempPath, sizeof(tempPath), "%s.tmp", path); //NOLINT
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  // The entry is written to a temporary file first so a reader never
+  // sees a partial entry.
+  auto fp = fopen(tempPath, "wb");
+
+  if(!fp) {
+    return NO;
+  }
+
+  const bool result =
+    fwrite(&header, sizeof(header), 1, fp) == 1 && //NOLINT
+    payloads.writeTo(fp) &&
+    fwrite(tree.offsets(), sizeof(uint32_t), numNodes, fp) == numNodes && //NOLINT
+    fwrite(tree.firstChild(), sizeof(uint32_t), numNodes, fp) == numNodes && //NOLINT
+    fwrite(tree.children(), sizeof(ast::CacheTree::Index), header.m_numChildren, fp) == header.m_numChildren && //NOLINT
+    (0 == header.m_numErrors || fwrite(tree.errors(), sizeof(ast::CacheTree::ErrorRecord), header.m_numErrors, fp) == header.m_numErrors) && //NOLINT
+    records.writeTo(fp) &&
+    names.writeTo(fp) &&
+    fwrite(tree.kinds(), sizeof(uint8_t), numNodes, fp) == numNodes && //NOLINT
+    pool.writeTo(fp);
+
+  fclose(fp);
+
+  if(!result || 0 != rename(tempPath, path)) {
+    remove(tempPath);
+    return NO;
+  }
+
+  return YES;
+}
+
+bool ParseCache::isValid(const CacheHeader* header, size_t size) {
+  if(size < sizeof(CacheHeader)) { //NOLINT
+    return NO;
+  }
+
+  if(header->m_magic != CacheHeader::Magic ||
+     header->m_version != CacheHeader::Version) {
+    return NO;
+  }
+
+  const uint64_t numNodes = header->m_numNodes;
+  const uint64_t payloadsEnd = header->m_payloadsOffset + numNodes * sizeof(uint32_t); //NOLINT
+  const uint64_t offsetsEnd = header->m_offsetsOffset + numNodes * sizeof(uint32_t); //NOLINT
+  const uint64_t firstChildEnd = header->m_firstChildOffset + numNodes * sizeof(uint32_t); //NOLINT
+  const uint64_t childrenEnd =
+    header->m_childrenOffset +
+    static_cast<uint64_t>(header->m_numChildren) * sizeof(ast::CacheTree::Index); //NOLINT
+  const uint64_t errorsEnd =
+    header->m_errorsOffset +
+    static_cast<uint64_t>(header->m_numErrors) * sizeof(ast::CacheTree::ErrorRecord); //NOLINT
+  const uint64_t diagnosticsEnd =
+    header->m_diagnosticsOffset +
+    static_cast<uint64_t>(header->m_numDiagnostics) * sizeof(CacheDiagnostic); //NOLINT
+  const uint64_t namesEnd =
+    header->m_namesOffset +
+    static_cast<uint64_t>(header->m_numNames) * sizeof(CacheName); //NOLINT
+  const uint64_t kindsEnd = header->m_kindsOffset + numNodes;
+  const uint64_t poolEnd = static_cast<uint64_t>(header->m_poolOffset) + header->m_poolSize;
+
+  // The arrays of 32-bit values are read in place.
+  const uint32_t alignment = sizeof(uint32_t) - 1; //NOLINT
+
+  if(0 != (header->m_payloadsOffset & alignment) ||
+     0 != (header->m_offsetsOffset & alignment) ||
+     0 != (header->m_firstChildOffset & alignment) ||
+     0 != (header->m_childrenOffset & alignment) ||
+     0 != (header->m_errorsOffset & alignment) ||
+     0 != (header->m_diagnosticsOffset & alignment) ||
+     0 != (header->m_namesOffset & alignment)) {
+    return NO;
+  }
+
+  return header->m_root < header->m_numNodes &&
+         payloadsEnd <= size && offsetsEnd <= size && firstChildEnd <= size && childrenEnd <= size &&
+         errorsEnd <= size && diagnosticsEnd <= size && namesEnd <= size && kindsEnd <= size &&
+         poolEnd <= size;
+}
+
+static bool isValidTree(const ast::CacheTree& tree, uint32_t numNames, uint32_t sourceSize) {
+  // Children always follow their parent so expanding a valid tree
+  // terminates.
+  const auto numNodes = tree.size();
+
+  for(ast::CacheTree::Index i = 0; i < numNodes; ++i) {
+    const auto kind = tree.kinds()[i];
+
+    if(ast::CacheTree::ListKind != kind && ast::CacheTree::LazyKind != kind && kind >= kNumNodeKinds) {
+      return NO;
+    }
+
+    // A skipped body is only ever the body of a function and lies
+    // within the text of the entry.
+    if(ast::CacheTree::LazyKind == kind &&
+       static_cast<uint64_t>(tree.offset(i)) + tree.payload(i) > sourceSize) {
+      return NO;
+    }
+
+    const auto numChildren = static_cast<uint64_t>(tree.numChildren(i));
+
+    if(tree.firstChild()[i] + numChildren > tree.numChildSlots()) {
+      return NO;
+    }
+
+    for(int j = 0; j < static_cast<int>(numChildren); ++j) {
+      const auto child = tree.child(i, j);
+
+      if(ast::CacheTree::None != child && (child <= i || child >= numNodes)) {
+        return NO;
+      }
+
+      if(ast::CacheTree::None != child && tree.isLazy(child) &&
+         (static_cast<uint8_t>(ast::NodeKind::kFunction) != kind || 2 != j)) {
+        return NO;
+      }
+    }
+
+    if(ast::CacheTree::hasName(kind) && tree.payload(i) >= numNames) {
+      return NO;
+    }
+
+    if(static_cast<uint8_t>(ast::NodeKind::kError) == kind &&
+       (tree.payload(i) >= tree.numErrors() ||
+        tree.error(i).m_code >= static_cast<uint32_t>(DiagnosticCode::kNumCodes))) {
+      return NO;
+    }
+  }
+
+  return YES;
+}
+
+ast::Node* ParseCache::load(const char* text, size_t length, bool isOutline, Arena* arena, Diagnostics* diagnostics) {
+  if(!isOpen()) {
+    return nullptr;
+  }
+
+  const auto hash = keyOf(text, length, isOutline);
+  char path[0x400];
+
+  pathOf(hash, path, sizeof(path)); //NOLINT
+
+  MappedFile file;
+
+  if(!file.open(path)) {
+    return nullptr;
+  }
+
+  auto data = file.data();
+  auto header = reinterpret_cast<const CacheHeader*>(data);
+
+  if(!isValid(header, file.size()) ||
+     header->m_sourceHash != hash ||
+     header->m_sourceSize != length) {
+    return nullptr;
+  }
+
+  ast::CacheTree tree;
+
+  tree.attach(
+    header->m_numNodes,
+    reinterpret_cast<const uint8_t*>(data + header->m_kindsOffset),
+    reinterpret_cast<const uint32_t*>(data + header->m_payloadsOffset),
+    reinterpret_cast<const uint32_t*>(data + header->m_offsetsOffset),
+    reinterpret_cast<const uint32_t*>(data + header->m_firstChildOffset),
+    header->m_numChildren,
+    reinterpret_cast<const ast::CacheTree::Index*>(data + header->m_childrenOffset),
+    header->m_numErrors,
+    reinterpret_cast<const ast::CacheTree::ErrorRecord*>(data + header->m_errorsOffset));
+
+  if(tree.isLazy(header->m_root) || !isValidTree(tree, header->m_numNames, header->m_sourceSize)) {
+    std::cerr << "Warning: Ignoring corrupt cache entry \"" << path << "\"." << std::endl;
+    return nullptr;
+  }
+
+  // Names of the entry are entered into the name table first. Ids of
+  // the entry are local to it so we keep a mapping to our own ids.
+  const auto numNames = header->m_numNames;
+  auto cacheNames = reinterpret_cast<const CacheName*>(data + header->m_namesOffset);
+  auto pool = data + header->m_poolOffset;
+  auto nameIds = NewArray<NameId>(numNames > 0 ? numNames : 1);
+
+  for(uint32_t i = 0; i < numNames; ++i) {
+    const auto& name = cacheNames[i];
+
+    if(static_cast<uint64_t>(name.m_offset) + name.m_length >= header->m_poolSize) {
+      DeleteArray(nameIds);
+      return nullptr;
+    }
+
+    nameIds[i] = m_names->get(pool + name.m_offset, static_cast<int>(name.m_length));
+  }
+
+  tree.mapNames(nameIds);
+  tree.source(text);
+
+  auto records = reinterpret_cast<const CacheDiagnostic*>(data + header->m_diagnosticsOffset);
+
+  for(uint32_t i = 0; i < header->m_numDiagnostics; ++i) {
+    auto& record = records[i];
+
+    if(record.m_code >= static_cast<uint32_t>(DiagnosticCode::kNumCodes)) {
+      DeleteArray(nameIds);
+      return nullptr;
+    }
+  }
+
+  for(uint32_t i = 0; i < header->m_numDiagnostics; ++i) {
+    auto& record = records[i];
+
+    diagnostics->report(
+      static_cast<DiagnosticCode>(record.m_code), record.m_offset,
+      record.m_args[0], record.m_args[1]);
+  }
+
+  // The expanded nodes do not refer to the file so it is closed once
+  // this returns. Skipped bodies refer to the given text instead.
+  auto result = tree.expand(header->m_root, arena);
+
+  DeleteArray(nameIds);
+
+  return result;
+}
+} //namespace internal
+} //namespace brutus
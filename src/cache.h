@@ -0,0 +1,124 @@
+#ifndef BRUTUS_CACHE_H_
+#define BRUTUS_CACHE_H_
+
+#include <cstdio>
+#include <mutex>
+
+#include "brutus.h"
+#include "arena.h"
+#include "ast.h"
+#include "buffer.h"
+#include "diagnostics.h"
+#include "mapped.h"
+#include "name.h"
+
+namespace brutus {
+  namespace internal {
+    // A parse cache keeps the AST of every unit it has seen in a
+    // directory. Files are named after a hash of the source text so a
+    // unit whose text did not change is loaded instead of parsed. The
+    // outline of a dependency is named after a hash of its own.
+    //
+    // An entry is the flattened AST of the unit together with
+    // the names it uses. Names are stored as indices into the names
+    // of the entry since NameIds are only valid in one process.
+    //
+    // Layout:
+    //
+    //   CacheHeader
+    //   uint32_t[numNodes]      payloads
+    //   uint32_t[numNodes]      source offsets
+    //   uint32_t[numNodes]      first child slot of each node
+    //   uint32_t[numChildren]   child slots
+    //   ErrorRecord[numErrors]  diagnostics of error nodes
+    //   CacheDiagnostic[numDiagnostics]  parse errors of the unit
+    //   CacheName[numNames]
+    //   uint8_t[numNodes]       kinds
+    //   char[poolSize]          zero-terminated characters of all names
+    //
+    // An entry is read straight from the mapped file. The tree is a
+    // view of the file and only the nodes are allocated when it is
+    // expanded.
+    class CacheHeader {
+      public:
+        static const uint32_t Magic = 0x43415242; // "BRAC"
+        static const uint32_t Version = 4;
+
+        uint32_t m_magic;
+        uint32_t m_version;
+        uint64_t m_sourceHash;
+        uint32_t m_sourceSize;
+        uint32_t m_root;
+        uint32_t m_numNodes;
+        uint32_t m_numChildren;
+        uint32_t m_numErrors;
+        uint32_t m_numDiagnostics;
+        uint32_t m_numNames;
+        uint32_t m_poolSize;
+        uint32_t m_payloadsOffset;
+        uint32_t m_offsetsOffset;
+        uint32_t m_firstChildOffset;
+        uint32_t m_childrenOffset;
+        uint32_t m_errorsOffset;
+        uint32_t m_diagnosticsOffset;
+        uint32_t m_namesOffset;
+        uint32_t m_kindsOffset;
+        uint32_t m_poolOffset;
+    };
+
+    class CacheName {
+      public:
+        uint32_t m_offset;
+        uint32_t m_length;
+    };
+
+    class CacheDiagnostic {
+      public:
+        uint32_t m_code;
+        uint32_t m_offset;
+        uint32_t m_args[2];
+    };
+
+    class ParseCache {
+      public:
+        explicit ParseCache(NameTable* names);
+        ~ParseCache();
+
+        // Uses the given directory for all entries and creates it if
+        // it does not exist yet.
+        bool open(const char* directory);
+
+        // Returns the AST of the given source text if it is cached and
+        // nullptr otherwise. The nodes are allocated in the arena and
+        // the parse errors of the entry are reported again. Outlines,
+        // whose function bodies have been skipped, are kept apart from
+        // complete trees. Skipped bodies refer to the given text.
+        ast::Node* load(const char* text, size_t length, bool isOutline, Arena* arena, Diagnostics* diagnostics);
+
+        // Stores the AST of the given source text and the errors that
+        // have been reported while it was parsed. The arguments of
+        // parse errors are tokens so they are valid in any process.
+        bool store(const char* text, size_t length, bool isOutline, ast::Node* node, const Diagnostics* diagnostics);
+
+        ALWAYS_INLINE bool isOpen() const {
+          return nullptr != m_directory;
+        }
+
+        static uint64_t hashOf(const char* text, size_t length);
+
+      private:
+        NameTable* const m_names;
+        char* m_directory;
+
+        // Entries for the same text are written by one worker at a time.
+        std::mutex m_mutex;
+
+        static uint64_t keyOf(const char* text, size_t length, bool isOutline);
+        void pathOf(uint64_t hash, char* path, size_t size);
+        bool isValid(const CacheHeader* header, size_t size);
+
+        DISALLOW_COPY_AND_ASSIGN(ParseCache);
+    }; //class ParseCache
+  } //namespace internal
+} //namespace brutus
+#endif
@@ -1,21 +1,58 @@
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
 #include "compiler.h"
+#include "build.h"
+#include "cache.h"
+#include "image.h"
+#include "modules.h"
+#include "scheduler.h"
+#include "trace.h"
+#include "visitor.h"
 
 namespace brutus {
-Compiler::Compiler() {
+Compiler::Compiler()
+    : Compiler(internal::Scheduler::defaultNumWorkers()) {}
+
+Compiler::Compiler(int numWorkers) {
   m_arena = new internal::Arena(
     /*initialCapacity = */512 * consts::KiloByte,
     /*blockSize = */consts::PageSize * 4,
     /*alignment = */consts::Alignment);
   m_arena->init();
   m_arenaAlloc = new internal::ArenaAllocator(m_arena);
-  m_names = new internal::NameTable(m_arena);
-  m_symbolTable = new (m_arena) internal::syms::SymbolTable(m_names, m_arena);
+  m_names = new internal::NameTable();
+  m_symbolTable = new internal::syms::SymbolTable(m_names, m_arena);
   m_phases = new List<internal::Phase*>(m_arenaAlloc);
-  m_units = new List<CompilationUnit*>(m_arenaAlloc);
-  m_phases->addLast(new internal::ParsePhase(this));
-  m_phases->addLast(new internal::SymbolsPhase(this));
-  m_phases->addLast(new internal::LinkPhase(this));
-  m_phase = 0;
+  // Units may be removed again, see remove, so their entries are not
+  // allocated in the arena which never frees anything.
+  m_units = new List<CompilationUnit*>();
+  m_numWorkers = numWorkers > 0 ? numWorkers : internal::Scheduler::defaultNumWorkers();
+  m_lastPhase = internal::MetricPhase::kLink;
+  m_parsePhase = new internal::ParsePhase(this, m_numWorkers);
+  m_symbolsPhase = new internal::SymbolsPhase(this);
+  m_linkPhases = internal::NewArray<internal::LinkPhase*>(m_numWorkers);
+
+  for(int i = 0; i < m_numWorkers; ++i) {
+    m_linkPhases[i] = new internal::LinkPhase(this, &m_dependencies);
+    m_linkPhases[i]->units(m_units);
+  }
+
+  m_linkPhase = m_linkPhases[0];
+  m_parseCache = nullptr;
+  m_buildCache = nullptr;
+  m_imageHash = 0;
+  m_modulePath = nullptr;
+  m_incremental = new internal::IncrementalParser(this, m_units, m_symbolsPhase, m_linkPhase);
+  m_info = new CompilationInfo(m_units);
+  m_metrics = new internal::Metrics(m_units, m_names, m_arena, m_numWorkers);
+  m_dumpFile = nullptr;
+  m_dumpWriter = nullptr;
+  m_dump = nullptr;
+  m_phases->addLast(m_parsePhase);
+  m_phases->addLast(m_symbolsPhase);
+  m_phases->addLast(m_linkPhase);
 }
 
 Compiler::~Compiler() {
@@ -27,37 +64,819 @@ Compiler::~Compiler() {
     delete phase;
   });
 
+  // The first link phase is one of the phases.
+  for(int i = 1; i < m_numWorkers; ++i) {
+    delete m_linkPhases[i];
+  }
+
+  internal::DeleteArray(m_linkPhases);
+
   delete m_units;
   delete m_phases;
+  delete m_parseCache;
+  delete m_buildCache;
+  delete m_modulePath;
+  delete m_incremental;
+  delete m_info;
+  delete m_metrics;
+  closeDump();
+  delete m_symbolTable;
   delete m_names;
   delete m_arenaAlloc;
   m_arena->deleteAll();
   delete m_arena;
 }
 
-void Compiler::addSource(FILE* fp) {
+CompilationUnit* Compiler::addSource(FILE* fp) {
   auto unit = new CompilationUnit();
   unit->source(new FileSource(fp));
 
   m_units->addLast(unit);
+
+  return unit;
+}
+
+CompilationUnit* Compiler::addSource(const char* text, size_t length) {
+  auto unit = new CompilationUnit();
+  unit->source(new MemorySource(text, length));
+
+  m_units->addLast(unit);
+
+  return unit;
+}
+
+CompilationUnit* Compiler::addFile(const char* path) {
+  auto fp = fopen(path, "rb");
+
+  if(!fp) {
+    return nullptr;
+  }
+
+  Source* source = nullptr;
+
+  if(0 == fseek(fp, 0, SEEK_END)) {
+    const auto length = ftell(fp);
+
+    if(length >= static_cast<long>(MappedFileThreshold)) { //NOLINT
+      auto mapped = new MappedSource();
+
+      if(mapped->open(path)) {
+        source = mapped;
+      } else {
+        delete mapped;
+      }
+    } else if(length >= 0) {
+      rewind(fp);
+      source = MemorySource::read(fp, static_cast<size_t>(length));
+    }
+  }
+
+  fclose(fp);
+
+  if(nullptr == source) {
+    return nullptr;
+  }
+
+  auto unit = new CompilationUnit();
+  unit->source(source);
+
+  m_units->addLast(unit);
+
+  return unit;
+}
+
+CompilationUnit* Compiler::addDependency(FILE* fp) {
+  auto unit = new CompilationUnit();
+  unit->source(new FileSource(fp));
+  unit->isDependency(YES);
+
+  m_units->addLast(unit);
+
+  return unit;
 }
 
 void Compiler::compile() {
-  m_phase = 0;
+  int numUnits = 0;
+
+  m_units->foreach([&](CompilationUnit* unit) {
+    if(!unit->isCompiled()) {
+      ++numUnits;
+    }
+  });
+
+  if(0 == numUnits) {
+    return;
+  }
+
+  TRACE_SCOPE("compiler", "compile");
+  auto units = internal::NewArray<CompilationUnit*>(numUnits);
+  auto indices = internal::NewArray<int>(numUnits);
+  int numPending = 0;
+  int index = 0;
+
+  m_units->foreach([&](CompilationUnit* unit) {
+    const int i = index++;
+
+    if(!unit->isCompiled()) {
+      unit->isCompiled(YES);
+      units[numPending] = unit;
+      indices[numPending++] = i;
+    }
+  });
+
+  if(nullptr != m_dump) {
+    m_dump->begin();
+  }
+
+  m_metrics->begin();
+
+  const auto isLinked = internal::MetricPhase::kLink == m_lastPhase;
+
+  if(nullptr != m_buildCache && m_buildCache->isOpen() && isLinked) {
+    compileCached(units, indices, numUnits);
+  } else {
+    run(units, indices, numUnits, 0, isLinked);
+  }
+
+  if(nullptr != m_modulePath && isLinked) {
+    TRACE_SCOPE("modules", "store");
+
+    for(int i = 0; i < numUnits; ++i) {
+      storeInterfaces(units[i]);
+    }
+  }
+
+  m_metrics->end();
+
+  if(nullptr != m_dump && !m_dump->end()) {
+    std::cerr << "Error: Could not write the AST dump." << std::endl;
+  }
+
+  internal::DeleteArray(indices);
+  internal::DeleteArray(units);
+}
+
+// Calls f with the name of every identifier of the given tree.
+template<typename F>
+static void foreachName(internal::ast::Node* node, F f) {
+  if(internal::ast::NodeKind::kIdentifier == node->kind()) {
+    f(static_cast<internal::ast::Identifier*>(node)->name());
+  }
+
+  internal::ast::forEachChild(node, [&](internal::ast::Node* child) {
+    foreachName(child, f);
+  });
+}
+
+void Compiler::run(CompilationUnit** units, const int* indices, int numUnits, int numEntered, bool isLinked) {
+  internal::Scheduler scheduler(m_numWorkers);
+  internal::Task* symbols = nullptr;
+  auto symbolsTasks = internal::NewArray<internal::Task*>(numUnits);
+  auto links = internal::NewArray<internal::Task*>(numUnits);
+
+  // The index of the last unit of this run that declares a module of
+  // the given name, plus one.
+  internal::NameMap<int> declarers;
+  internal::Task* declared = nullptr;
+
+  // The global scope is shared by all units so it is complete before
+  // the first unit is linked. The modules of all units are entered
+  // once they have been parsed, and required modules that no unit
+  // declares are loaded from the module path.
+  if(isLinked) {
+    declared = scheduler.newTask([=, &declarers](int) {
+      for(int j = numEntered; j < numUnits; ++j) {
+        auto unit = units[j];
+        auto ast = unit->ast();
+
+        if(nullptr == ast || internal::ast::NodeKind::kProgram != ast->kind()) {
+          continue;
+        }
+
+        unit->metrics()->time(internal::MetricPhase::kSymbols, [=]() {
+          m_symbolsPhase->enterModules(unit);
+        });
+
+        static_cast<internal::ast::Program*>(ast)->modules()->foreach([&](internal::ast::Node* node) {
+          if(internal::ast::NodeKind::kModule == node->kind()) {
+            auto name = static_cast<internal::ast::Module*>(node)->name();
+
+            if(internal::ast::NodeKind::kIdentifier == name->kind()) {
+              declarers.put(static_cast<internal::ast::Identifier*>(name)->name(), j + 1);
+            }
+          }
+        });
+      }
+
+      if(nullptr != m_modulePath) {
+        for(int j = 0; j < numUnits; ++j) {
+          loadRequired(units[j]);
+        }
+      }
+    });
+  }
+
+  for(int j = 0; j < numUnits; ++j) {
+    auto unit = units[j];
+    const int i = indices[j];
+
+    symbolsTasks[j] = nullptr;
+    links[j] = nullptr;
+
+    if(isLinked) {
+      links[j] = scheduler.newTask([=](int worker) {
+        internal::TraceScope trace("phase", "link", "unit", i);
+        unit->metrics()->time(internal::MetricPhase::kLink, [=]() {
+          m_linkPhases[worker]->apply(unit);
+        });
+      });
+
+      // A unit is linked once the symbols of every unit that declares
+      // a module it may refer to have been entered. Those are only
+      // known once all units have been parsed. The bodies of a
+      // dependency are linked on demand so a unit that refers to one
+      // waits for all units.
+      auto plan = scheduler.newTask([=, &scheduler, &declarers](int) {
+        const int lastUnit = numUnits - 1;
+        int last = -1;
+
+        if(unit->isDependency()) {
+          last = lastUnit;
+        } else if(nullptr != unit->ast()) {
+          foreachName(unit->ast(), [&](internal::NameId name) {
+            const int declarer = declarers.get(name) - 1;
+
+            if(declarer >= 0) {
+              last = std::max(last, units[declarer]->isDependency() ? lastUnit : declarer);
+            }
+          });
+        }
 
-  m_phases->foreach([&](internal::Phase* phase) {
-    phase->stopwatch()->start();
+        if(last >= numEntered) {
+          scheduler.precede(symbolsTasks[last], links[j]);
+        }
+      });
 
-    m_units->foreach([&](CompilationUnit* unit) {
-      phase->apply(unit);
+      declared->precede(plan);
+      plan->precede(links[j]);
+    }
+
+    if(j < numEntered) {
+      continue;
+    }
+
+    auto parse = scheduler.newTask([=](int worker) {
+      internal::TraceScope trace("phase", "parse", "unit", i);
+      unit->metrics()->time(internal::MetricPhase::kParse, [=]() {
+        m_parsePhase->parse(unit, worker);
+      });
+    });
+
+    auto nextSymbols = scheduler.newTask([=](int) {
+      // Units are dumped one at a time in order since symbols are
+      // built that way.
+      if(nullptr != m_dump) {
+        m_dump->dump(unit->ast(), unit->lines(), i);
+      }
+
+      if(internal::MetricPhase::kParse == m_lastPhase) {
+        return;
+      }
+
+      // The modules of a unit that is linked have been entered by
+      // the declared task already.
+      internal::TraceScope trace("phase", "symbols", "unit", i);
+      unit->metrics()->time(internal::MetricPhase::kSymbols, [=]() {
+        if(isLinked) {
+          m_symbolsPhase->enterDeclarations(unit);
+        } else {
+          m_symbolsPhase->apply(unit);
+        }
+      });
+    });
+
+    parse->precede(nextSymbols);
+
+    if(nullptr != symbols) {
+      symbols->precede(nextSymbols);
+    }
+
+    if(nullptr != declared) {
+      parse->precede(declared);
+      declared->precede(nextSymbols);
+      nextSymbols->precede(links[j]);
+    }
+
+    symbols = symbolsTasks[j] = nextSymbols;
+  }
+
+  scheduler.run();
+
+  internal::DeleteArray(links);
+  internal::DeleteArray(symbolsTasks);
+}
+
+void Compiler::loadRequired(CompilationUnit* unit) {
+  auto ast = unit->ast();
+
+  if(nullptr == ast || internal::ast::NodeKind::kProgram != ast->kind()) {
+    return;
+  }
+
+  // Same as the link of a required module but done before any unit is
+  // linked, since loading a module changes the scopes of the module
+  // path. The links then find the loaded modules there.
+  static_cast<internal::ast::Program*>(ast)->modules()->foreach([&](internal::ast::Node* node) {
+    if(internal::ast::NodeKind::kModule != node->kind()) {
+      return;
+    }
+
+    static_cast<internal::ast::Module*>(node)->dependencies()->foreach([&](internal::ast::Node* dependency) {
+      auto name = static_cast<internal::ast::ModuleDependency*>(dependency)->name();
+
+      if(internal::ast::NodeKind::kIdentifier != name->kind()) {
+        return;
+      }
+
+      const auto moduleName = static_cast<internal::ast::Identifier*>(name)->name();
+      auto module = m_symbolTable->global()->getLocal(moduleName);
+
+      if(nullptr == module || module->kind() != internal::syms::SymbolKind::kModule) {
+        m_modulePath->get(moduleName);
+      }
+    });
+  });
+}
+
+void Compiler::compileCached(CompilationUnit** units, const int* indices, int numUnits) {
+  auto artifacts = internal::NewArray<internal::Artifact*>(numUnits);
+  auto compiled = internal::NewArray<CompilationUnit*>(numUnits);
+  auto compiledIndices = internal::NewArray<int>(numUnits);
+  int numCompiled = 0;
+  List<internal::ImageType> unresolved;
+
+  // The declarations of unchanged units are restored first so the
+  // units that changed are entered and linked among them.
+  {
+    TRACE_SCOPE("cache", "restore");
+
+    for(int i = 0; i < numUnits; ++i) {
+      artifacts[i] = restore(units[i], &unresolved);
+
+      if(nullptr == artifacts[i]) {
+        compiled[numCompiled] = units[i];
+        compiledIndices[numCompiled++] = indices[i];
+      }
+    }
+  }
+
+  run(compiled, compiledIndices, numCompiled, 0, NO);
+
+  // A restored unit may refer to the classes of a unit that has only
+  // been entered now. Its interface is hashed with them below.
+  unresolved.foreach([&](internal::ImageType type) {
+    auto module = m_symbolTable->global()->getLocal(type.m_path[0]);
+
+    if((nullptr == module || module->kind() != internal::syms::SymbolKind::kModule) && nullptr != m_modulePath) {
+      module = m_modulePath->get(type.m_path[0]);
+    }
+
+    internal::ImageReader::resolve(type, module);
+  });
+
+  // The links of a restored unit are only valid if the declarations
+  // of the modules it uses did not change. Otherwise it is compiled
+  // like the others. Its own declarations are the same either way so
+  // the hashes of its modules do not change.
+  m_moduleHashes.clear();
+
+  const auto globalHash = this->globalHash();
+  const auto numEntered = numCompiled;
+
+  for(int i = 0; i < numUnits; ++i) {
+    auto artifact = artifacts[i];
+
+    if(nullptr == artifact) {
+      continue;
+    }
+
+    auto unit = units[i];
+
+    if(artifact->dependencyHash() == dependencyHash(globalHash, unit)) {
+      artifact->restore(unit->diagnostics(), m_names);
+      unit->metrics()->add(internal::Counter::kRestored, 1);
+    } else {
+      compiled[numCompiled] = unit;
+      compiledIndices[numCompiled++] = indices[i];
+    }
+
+    delete artifact;
+  }
+
+  // Other units may use the modules of a unit that is compiled again
+  // so they are only discarded once all hashes are known.
+  for(int i = numEntered; i < numCompiled; ++i) {
+    m_incremental->discard(compiled[i]);
+  }
+
+  run(compiled, compiledIndices, numCompiled, numEntered, YES);
+
+  {
+    TRACE_SCOPE("cache", "store");
+    internal::ByteBuffer interface;
+
+    for(int i = 0; i < numCompiled; ++i) {
+      auto unit = compiled[i];
+
+      // Skipped bodies of a dependency are parsed on demand so it is
+      // never restored.
+      if(unit->isDependency()) {
+        continue;
+      }
+
+      interface.clear();
+      interfaceOf(unit, &interface);
+
+      m_buildCache->store(
+        unit->text()->data(), unit->text()->size(), &interface,
+        unit->uses(), dependencyHash(globalHash, unit), unit->diagnostics());
+    }
+  }
+
+  internal::DeleteArray(compiledIndices);
+  internal::DeleteArray(compiled);
+  internal::DeleteArray(artifacts);
+}
+
+internal::Artifact* Compiler::restore(CompilationUnit* unit, List<internal::ImageType>* unresolved) {
+  const char* data;
+  size_t size;
+
+  if(unit->isDependency() || !unit->source()->text(&data, &size)) {
+    return nullptr;
+  }
+
+  auto artifact = m_buildCache->find(data, size);
+
+  if(nullptr == artifact) {
+    return nullptr;
+  }
+
+  internal::ImageReader reader(this);
+  auto modules = unit->modules();
+
+  unit->isRestored(YES);
+
+  if(!reader.load(
+      artifact->interface(), artifact->interfaceSize(), unit->arena(), m_symbolTable->global(),
+      [=](internal::syms::Symbol* module) {
+        modules->addLast(module);
+      }, unresolved)) {
+    m_incremental->discard(unit);
+    delete artifact;
+    return nullptr;
+  }
+
+  // The text is kept for the positions of diagnostics and in case
+  // the unit is edited.
+  unit->text()->clear();
+  unit->text()->append(data, size);
+  unit->diagnostics()->clear();
+  artifact->uses(m_names, unit->uses());
+
+  return artifact;
+}
+
+void Compiler::foreachModule(CompilationUnit* unit, std::function<void(internal::syms::Symbol*)> f) { //NOLINT
+  if(unit->isRestored()) {
+    unit->modules()->foreach(f);
+  } else if(nullptr != unit->ast() && internal::ast::NodeKind::kProgram == unit->ast()->kind()) {
+    static_cast<internal::ast::Program*>(unit->ast())->modules()->foreach([&](internal::ast::Node* node) {
+      if(internal::ast::NodeKind::kModule == node->kind() && nullptr != node->symbol()) {
+        f(node->symbol());
+      }
     });
+  }
+}
+
+void Compiler::interfaceOf(CompilationUnit* unit, internal::ByteBuffer* target) {
+  internal::ImageWriter writer(this);
+
+  foreachModule(unit, [&](internal::syms::Symbol* module) {
+    writer.add(module);
+  });
+
+  writer.write(target);
+}
+
+void Compiler::storeInterfaces(CompilationUnit* unit) {
+  // Skipped bodies of a dependency are parsed on demand so there is
+  // no need for its interface, it is compiled from source anyway.
+  if(unit->isDependency() || !m_modulePath->isOpen()) {
+    return;
+  }
+
+  foreachModule(unit, [&](internal::syms::Symbol* module) {
+    if(!m_modulePath->store(module)) {
+      std::cerr << "Error: Could not write the interface of module '"
+        << m_names->value(module->name()) << "'." << std::endl;
+    }
+  });
+}
 
-    phase->stopwatch()->pause();
-    phase->log(); //TODO(joa): of course not here
-    ++m_phase;
+uint64_t Compiler::globalHash() {
+  TRACE_SCOPE("cache", "globalHash");
+  auto result = internal::BuildCache::combine(internal::BuildCache::compilerHash(), m_imageHash);
+  int numModules = 0;
+
+  // A name that cannot be found in a unit may be the name of a module
+  // that has been added since. The names are hashed in order since the
+  // order of the global scope depends on the ids of the names.
+  m_symbolTable->global()->foreach([&](internal::syms::Symbol* symbol) {
+    UNUSED(symbol);
+    ++numModules;
+  });
+
+  auto modules = internal::NewArray<const char*>(numModules);
+  int index = 0;
+
+  m_symbolTable->global()->foreach([&](internal::syms::Symbol* symbol) {
+    modules[index++] = m_names->value(symbol->name());
+  });
+
+  std::sort(modules, modules + numModules, [](const char* a, const char* b) {
+    return std::strcmp(a, b) < 0;
+  });
+
+  for(int i = 0; i < numModules; ++i) {
+    result = internal::BuildCache::combine(
+      result, internal::ParseCache::hashOf(modules[i], std::strlen(modules[i])));
+  }
+
+  internal::DeleteArray(modules);
+
+  // Every unit is linked against the prelude, like the type of a number
+  // literal, so the declarations of dependencies are always part of it.
+  m_units->foreach([&](CompilationUnit* unit) {
+    if(unit->isDependency()) {
+      foreachModule(unit, [&](internal::syms::Symbol* module) {
+        result = internal::BuildCache::combine(result, moduleHash(module->name()));
+      });
+    }
+  });
+
+  return result;
+}
+
+uint64_t Compiler::moduleHash(internal::NameId name) {
+  // A module that does not exist has a hash of its own.
+  static const uint64_t kMissing = 1;
+  auto result = m_moduleHashes.get(name);
+
+  if(0 != result) {
+    return result;
+  }
+
+  auto module = m_symbolTable->global()->getLocal(name);
+
+  if((nullptr == module || module->kind() != internal::syms::SymbolKind::kModule) && nullptr != m_modulePath) {
+    module = m_modulePath->get(name);
+  }
+
+  if(nullptr == module || module->kind() != internal::syms::SymbolKind::kModule) {
+    result = kMissing;
+  } else {
+    internal::ByteBuffer interface;
+
+    internal::ModulePath::interfaceOf(this, module, &interface);
+    result = internal::ParseCache::hashOf(interface.data(), interface.size());
+  }
+
+  m_moduleHashes.put(name, result);
+
+  return result;
+}
+
+uint64_t Compiler::dependencyHash(uint64_t globalHash, CompilationUnit* unit) {
+  auto uses = unit->uses();
+  auto names = internal::NewArray<internal::NameId>(uses->size());
+  int numNames = 0;
+  auto result = globalHash;
+
+  uses->foreach([&](internal::NameId name) {
+    names[numNames++] = name;
+  });
+
+  // Only the modules a unit uses are part of its hash, so a change to
+  // the declarations of any other module does not link it again.
+  std::sort(names, names + numNames, [&](internal::NameId a, internal::NameId b) {
+    return std::strcmp(m_names->value(a), m_names->value(b)) < 0;
+  });
+
+  for(int i = 0; i < numNames; ++i) {
+    const auto name = names[i];
+
+    result = internal::BuildCache::combine(
+      result, internal::ParseCache::hashOf(m_names->value(name), static_cast<size_t>(m_names->length(name))));
+    result = internal::BuildCache::combine(result, moduleHash(name));
+  }
+
+  internal::DeleteArray(names);
+
+  return result;
+}
+
+bool Compiler::loadImage(const char* path) {
+  TRACE_SCOPE("compiler", "loadImage");
+  internal::MappedFile file;
+  internal::ImageReader reader(this);
+
+  if(!file.open(path) || !reader.load(file.data(), file.size())) {
+    return NO;
+  }
+
+  // Units are linked against the declarations of the image as well.
+  m_imageHash = internal::BuildCache::combine(
+    m_imageHash, internal::ParseCache::hashOf(file.data(), file.size()));
+
+  return YES;
+}
+
+bool Compiler::writeImage(const char* path) {
+  auto fp = fopen(path, "wb");
+
+  if(!fp) {
+    return NO;
+  }
+
+  internal::ImageWriter writer(this);
+  auto result = writer.write(fp);
+
+  fclose(fp);
+
+  return result;
+}
+
+bool Compiler::useParseCache(const char* directory) {
+  if(nullptr == m_parseCache) {
+    m_parseCache = new internal::ParseCache(m_names);
+  }
+
+  if(!m_parseCache->open(directory)) {
+    return NO;
+  }
+
+  m_parsePhase->cache(m_parseCache);
+  return YES;
+}
+
+bool Compiler::useBuildCache(const char* directory) {
+  if(nullptr == m_buildCache) {
+    m_buildCache = new internal::BuildCache(m_names);
+  }
+
+  if(!m_buildCache->open(directory)) {
+    return NO;
+  }
+
+  m_parsePhase->cache(m_buildCache->parseCache());
+  return YES;
+}
+
+bool Compiler::useModulePath(const char* directory) {
+  if(nullptr == m_modulePath) {
+    m_modulePath = new internal::ModulePath(this);
+  }
+
+  if(!m_modulePath->open(directory)) {
+    return NO;
+  }
+
+  for(int i = 0; i < m_numWorkers; ++i) {
+    m_linkPhases[i]->modulePath(m_modulePath);
+  }
+
+  return YES;
+}
+
+internal::EditResult Compiler::edit(
+    CompilationUnit* unit, size_t offset, size_t length,
+    const char* text, size_t textLength) {
+  const auto result = m_incremental->edit(unit, offset, length, text, textLength);
+
+  if(internal::EditResult::kInvalid != result && nullptr != m_modulePath) {
+    storeInterfaces(unit);
+  }
+
+  return result;
+}
+
+void Compiler::recompile(CompilationUnit* unit) {
+  m_incremental->rebuild(unit);
+
+  if(nullptr != m_modulePath) {
+    storeInterfaces(unit);
+  }
+}
+
+void Compiler::remove(CompilationUnit* unit) {
+  m_incremental->discard(unit);
+  m_units->remove(unit);
+  delete unit;
+}
+
+CompilationInfo* Compiler::info() {
+  return m_info;
+}
+
+List<CompilationUnit*>* Compiler::units() {
+  return m_units;
+}
+
+void Compiler::startTrace() {
+  internal::Tracer::start();
+}
+
+bool Compiler::writeTrace(const char* path) {
+  internal::Tracer::stop();
+  return internal::Tracer::write(path);
+}
+
+internal::Metrics* Compiler::metrics() {
+  return m_metrics;
+}
+
+void Compiler::stopAfter(internal::MetricPhase phase) {
+  m_lastPhase = phase;
+}
+
+bool Compiler::dumpAst(const char* path, internal::DumpFormat format) {
+  auto fp = fopen(path, "wb");
+
+  if(!fp) {
+    return NO;
+  }
+
+  closeDump();
+  m_dumpFile = fp;
+  m_dumpWriter = new internal::Writer(fp);
+  m_dump = new internal::AstDump(m_dumpWriter, format, m_names);
+
+  return YES;
+}
+
+void Compiler::dumpAst(internal::ByteBuffer* buffer, internal::DumpFormat format) {
+  closeDump();
+  m_dumpWriter = new internal::Writer(buffer);
+  m_dump = new internal::AstDump(m_dumpWriter, format, m_names);
+}
+
+void Compiler::closeDump() {
+  delete m_dump;
+  delete m_dumpWriter;
+
+  if(nullptr != m_dumpFile) {
+    fclose(m_dumpFile);
+  }
+
+  m_dump = nullptr;
+  m_dumpWriter = nullptr;
+  m_dumpFile = nullptr;
+}
+
+void Compiler::printDiagnostics(std::ostream& output) {
+  m_units->foreach([&](CompilationUnit* unit) {
+    unit->diagnostics()->print(output, m_names, unit->lines());
   });
 }
 
+//
+
+CompilationInfo::CompilationInfo(List<CompilationUnit*>* units)
+    : m_units(units) {}
+
+int CompilationInfo::totalErrors() {
+  int result = 0;
+
+  m_units->foreach([&](CompilationUnit* unit) {
+    result += unit->diagnostics()->numErrors();
+  });
+
+  return result;
+}
+
+int CompilationInfo::totalWarnings() {
+  int result = 0;
+
+  m_units->foreach([&](CompilationUnit* unit) {
+    result += unit->diagnostics()->numWarnings();
+  });
+
+  return result;
+}
+
+//
+
 internal::ast::Node* CompilationUnit::ast() const {
   return m_ast;
 }
@@ -73,4 +892,92 @@ Source* CompilationUnit::source() const {
 void CompilationUnit::source(Source* value) {
   m_source = value;
 }
+
+bool CompilationUnit::isDependency() const {
+  return m_isDependency;
+}
+
+void CompilationUnit::isDependency(bool value) {
+  m_isDependency = value;
+}
+
+bool CompilationUnit::isCompiled() const {
+  return m_isCompiled;
+}
+
+void CompilationUnit::isCompiled(bool value) {
+  m_isCompiled = value;
+}
+
+bool CompilationUnit::isRestored() const {
+  return m_isRestored;
+}
+
+void CompilationUnit::isRestored(bool value) {
+  m_isRestored = value;
+}
+
+List<internal::syms::Symbol*>* CompilationUnit::modules() {
+  return &m_modules;
+}
+
+List<internal::NameId>* CompilationUnit::uses() {
+  return &m_uses;
+}
+
+internal::ByteBuffer* CompilationUnit::text() {
+  return &m_text;
+}
+
+internal::LineTable* CompilationUnit::lines() {
+  return &m_lines;
+}
+
+internal::Diagnostics* CompilationUnit::diagnostics() {
+  return &m_diagnostics;
+}
+
+internal::UnitMetrics* CompilationUnit::metrics() {
+  return &m_metrics;
+}
+
+internal::Arena* CompilationUnit::arena() {
+  return &m_arena;
+}
+
+void CompilationUnit::discard() {
+  m_ast = nullptr;
+  m_isRestored = NO;
+  m_uses.clear();
+  m_modules.clear();
+  m_arena.deleteAll();
+  m_arena.init();
+}
+
+//
+
+MemorySource::MemorySource(const char* text, size_t length)
+    : m_text(internal::NewArray<char>(length)),
+      m_length(length) {
+  internal::ArrayCopy(m_text, text, length);
+}
+
+MemorySource::MemorySource(size_t length)
+    : m_text(internal::NewArray<char>(length)),
+      m_length(length) {}
+
+MemorySource::~MemorySource() {
+  internal::DeleteArray(m_text);
+}
+
+MemorySource* MemorySource::read(FILE* fp, size_t length) {
+  auto result = new MemorySource(length);
+
+  if(length != fread(result->m_text, 1, length, fp)) {
+    delete result;
+    return nullptr;
+  }
+
+  return result;
+}
 }
@@ -1,20 +1,40 @@
 #ifndef _BRUTUS_COMPILER_H
 #define _BRUTUS_COMPILER_H
 
+#include <mutex>
+
 #include "brutus.h"
 #include "arena.h"
+#include "buffer.h"
+#include "diagnostics.h"
+#include "dump.h"
 #include "name.h"
 #include "lexer.h"
+#include "lines.h"
+#include "mapped.h"
 #include "parser.h"
 #include "list.h"
+#include "metrics.h"
 #include "phases.h"
+#include "incremental.h"
 #include "streams.h"
 #include "ast.h"
 
+namespace brutus {
+  namespace internal {
+    class Artifact;
+    class BuildCache;
+    class ImageType;
+    class ModulePath;
+  }
+}
+
 namespace brutus {
   enum class SourceKind {
     kError,
-    kFile
+    kFile,
+    kMemory,
+    kMapped
   }; //enum SourceKind
 
   class Source {
@@ -25,6 +45,14 @@ namespace brutus {
       virtual CharStream* newStream() const = 0;
       virtual bool isError() const { return NO; }
 
+      // Sources that hold all of their characters in memory return
+      // them here so they are copied at once instead of streamed.
+      virtual bool text(const char** data, size_t* size) const {
+        UNUSED(data);
+        UNUSED(size);
+        return NO;
+      }
+
     private:
       DISALLOW_COPY_AND_ASSIGN(Source);
   }; //class Source
@@ -65,13 +93,82 @@ namespace brutus {
       DISALLOW_COPY_AND_ASSIGN(FileSource);
   }; //class FileSource
 
+  // Text that has been handed to the compiler in memory. The source
+  // keeps a copy of it.
+  class MemorySource : public Source {
+    public:
+      explicit MemorySource(const char* text, size_t length);
+      ~MemorySource();
+
+      SourceKind kind() const override final {
+        return SourceKind::kMemory;
+      }
+
+      CharStream* newStream() const override final {
+        return new brutus::internal::MemoryCharStream(m_text, m_length);
+      }
+
+      bool text(const char** data, size_t* size) const override final {
+        *data = m_text;
+        *size = m_length;
+        return YES;
+      }
+
+      // Reads length characters of a file. Returns nullptr if there
+      // are fewer.
+      static MemorySource* read(FILE* fp, size_t length);
+
+    private:
+      char* m_text;
+      const size_t m_length;
+
+      explicit MemorySource(size_t length);
+
+      DISALLOW_COPY_AND_ASSIGN(MemorySource);
+  }; //class MemorySource
+
+  // A file that is mapped into memory instead of read. Large files are
+  // added this way, see Compiler::addFile.
+  class MappedSource : public Source {
+    public:
+      explicit MappedSource() {}
+
+      bool open(const char* path) {
+        return m_file.open(path);
+      }
+
+      SourceKind kind() const override final {
+        return SourceKind::kMapped;
+      }
+
+      CharStream* newStream() const override final {
+        return new brutus::internal::MemoryCharStream(m_file.data(), m_file.size());
+      }
+
+      bool text(const char** data, size_t* size) const override final {
+        *data = m_file.data();
+        *size = m_file.size();
+        return YES;
+      }
+
+    private:
+      internal::MappedFile m_file;
+
+      DISALLOW_COPY_AND_ASSIGN(MappedSource);
+  }; //class MappedSource
+
+  class CompilationUnit;
+
+  // Sums up the diagnostics of all units of a compiler.
   class CompilationInfo {
     public:
-      explicit CompilationInfo();
+      explicit CompilationInfo(List<CompilationUnit*>* units);
       int totalErrors();
       int totalWarnings();
 
     private:
+      List<CompilationUnit*>* const m_units;
+
       DISALLOW_COPY_AND_ASSIGN(CompilationInfo);
   }; //class CompilationInfo
 
@@ -79,16 +176,25 @@ namespace brutus {
     public:
       explicit CompilationUnit()
           : m_ast(nullptr),
-            m_source(nullptr) {}
+            m_source(nullptr),
+            m_isDependency(NO),
+            m_isCompiled(NO),
+            m_isRestored(NO),
+            m_arena(
+              /*initialCapacity = */consts::PageSize * 4,
+              /*blockSize = */consts::PageSize * 4,
+              /*alignment = */consts::Alignment),
+            m_lines(&m_text) {
+        m_arena.init();
+      }
 
       ~CompilationUnit() {
         // A compilation unit is responsible for deleting
         // the source associated with it. It is a mere
         // container for the AST and the source.
         //
-        // However the AST does not have to be deleted
-        // since it is allocated within the arena of the
-        // compiler.
+        // The AST and the symbols of the unit are freed
+        // with its arena.
         //
         // If the compiler needs to compile the same unit
         // twice only the whole AST will be gone, not the
@@ -102,9 +208,62 @@ namespace brutus {
       Source* source() const;
       void source(Source* value);
 
+      // A dependency is parsed in outline mode. Only its declarations
+      // are entered and linked, function bodies are parsed on demand.
+      bool isDependency() const;
+      void isDependency(bool value);
+
+      // Whether the unit has been part of a compile.
+      bool isCompiled() const;
+      void isCompiled(bool value);
+
+      // A unit that is up to date in the build cache is restored from
+      // its artifact instead of compiled. It has no AST, only the
+      // modules it declares.
+      bool isRestored() const;
+      void isRestored(bool value);
+      List<internal::syms::Symbol*>* modules();
+
+      // The top-level modules the unit has been linked against, which
+      // are those it requires and those it refers to by name.
+      List<internal::NameId>* uses();
+
+      // The characters of the source if they are kept in memory.
+      internal::ByteBuffer* text();
+
+      // The AST of the unit and the symbols it declares are allocated
+      // here. Names and the global scope are shared by all units and
+      // live in the arena of the compiler.
+      internal::Arena* arena();
+
+      // Frees the AST and the symbols of the unit. The symbols must
+      // have been removed from the global scope and other units must
+      // be linked again before their symbols are used. A restored
+      // unit is no longer restored afterwards.
+      void discard();
+
+      // Lines of the text, used to print the offsets of nodes.
+      internal::LineTable* lines();
+
+      // Errors and warnings reported while the unit was compiled.
+      internal::Diagnostics* diagnostics();
+
+      // Time and counters of the last compile of the unit.
+      internal::UnitMetrics* metrics();
+
     private:
       internal::ast::Node* m_ast;
       Source* m_source;
+      bool m_isDependency;
+      bool m_isCompiled;
+      bool m_isRestored;
+      List<internal::syms::Symbol*> m_modules;
+      List<internal::NameId> m_uses;
+      internal::Arena m_arena;
+      internal::ByteBuffer m_text;
+      internal::LineTable m_lines;
+      internal::Diagnostics m_diagnostics;
+      internal::UnitMetrics m_metrics;
 
       DISALLOW_COPY_AND_ASSIGN(CompilationUnit);
   }; //class CompilationUnit
@@ -125,12 +284,120 @@ namespace brutus {
   class Compiler : Context {
     public:
       Compiler();
+
+      // Parses on the given number of workers, or one per core if it
+      // is zero.
+      explicit Compiler(int numWorkers);
       ~Compiler();
 
-      void addSource(FILE* fp);
+      CompilationUnit* addSource(FILE* fp);
       void addSource(Source* source);
+
+      // Adds a copy of the given text as a unit.
+      CompilationUnit* addSource(const char* text, size_t length);
+
+      // Files of at least this many bytes are mapped instead of read.
+      static const size_t MappedFileThreshold = 256 * consts::KiloByte;
+
+      // Adds the file at the given path as a unit. Returns nullptr if
+      // it cannot be read.
+      CompilationUnit* addFile(const char* path);
+
+      // Adds a source whose function bodies are only parsed when they
+      // are needed, like a module that is only required.
+      CompilationUnit* addDependency(FILE* fp);
+
+      // Compiles all units that have not been compiled yet. Units that
+      // have been compiled before are brought up to date with edit or
+      // recompile instead.
+      //
+      // Units are parsed concurrently. Once all of them have been
+      // parsed their modules are entered in the order the units were
+      // added. Then the declarations of each unit are entered, one
+      // unit at a time in the same order, and a unit is linked once
+      // the declarations of the units whose modules it refers to
+      // exist. Units are linked concurrently with each other and with
+      // entering the declarations of the units after them, except for
+      // dependencies which are linked one at a time.
       void compile();
 
+      // Enters the names and declarations of a precompiled image into
+      // this compiler instead of compiling their sources. This is how
+      // the prelude is loaded at startup.
+      bool loadImage(const char* path);
+
+      // Writes the declarations of all compiled modules as an image.
+      bool writeImage(const char* path);
+
+      // Keeps the ASTs of all parsed units in the given directory. A
+      // unit whose source did not change since it has been stored is
+      // loaded from there instead of parsed.
+      bool useParseCache(const char* directory);
+
+      // Keeps the artifacts of all compiled units in the given
+      // directory, which includes the parse cache. A unit whose text
+      // did not change and that has been linked against the same
+      // declarations of the other units is restored from there. It
+      // is neither parsed nor linked and its AST is not dumped.
+      //
+      // Only units that are compiled up to the link phase are cached.
+      bool useBuildCache(const char* directory);
+
+      // Writes the interface file of every module that is compiled up
+      // to the link phase into the given directory. A module that is
+      // required but declared by no unit and no image is loaded from
+      // its interface file there.
+      bool useModulePath(const char* directory);
+
+      // Replaces length characters at the given offset of a compiled
+      // unit with textLength characters of text. Only the declaration
+      // or module that contains the edit is parsed again if possible.
+      // The unit and those that use the module are linked again.
+      internal::EditResult edit(
+        CompilationUnit* unit, size_t offset, size_t length,
+        const char* text, size_t textLength);
+
+      // Frees the memory of a compiled unit and compiles it again from
+      // its text. The other units that use its modules are linked
+      // again.
+      void recompile(CompilationUnit* unit);
+
+      // Removes a unit and its modules and deletes it. The memory of
+      // its AST and symbols is freed with its arena. Names it has
+      // interned stay in the name table.
+      void remove(CompilationUnit* unit);
+
+      CompilationInfo* info();
+
+      // All units in the order they have been added.
+      List<CompilationUnit*>* units();
+
+      // Wall and CPU time of every phase and counters of the last
+      // compile.
+      internal::Metrics* metrics();
+
+      // Compiles units only up to and including the given phase. The
+      // later phases are skipped, like linking after the symbols.
+      void stopAfter(internal::MetricPhase phase);
+
+      // Records the phases of every unit and their hot steps from now
+      // on. Tracing is process wide and off by default.
+      void startTrace();
+
+      // Stops tracing and writes the events in the trace event format
+      // of Chrome.
+      bool writeTrace(const char* path);
+
+      // Writes the AST of every unit to the given file once it has
+      // been parsed. ASTs are not dumped unless this is called.
+      bool dumpAst(const char* path, internal::DumpFormat format);
+
+      // Writes the ASTs to a buffer in memory instead.
+      void dumpAst(internal::ByteBuffer* buffer, internal::DumpFormat format);
+
+      // Formats the diagnostics of all units.
+      void printDiagnostics(std::ostream& output);
+
       internal::Arena* arena() override final {
         return m_arena;
       }
@@ -153,7 +420,69 @@ namespace brutus {
       internal::syms::SymbolTable* m_symbolTable;
       List<internal::Phase*>* m_phases;
       List<CompilationUnit*>* m_units;
-      int m_phase;
+      internal::ParsePhase* m_parsePhase;
+      internal::SymbolsPhase* m_symbolsPhase;
+      internal::LinkPhase* m_linkPhase;
+
+      // A link phase per worker, the first one is m_linkPhase.
+      internal::LinkPhase** m_linkPhases;
+
+      // Held while a dependency is linked or one of its skipped bodies
+      // is parsed.
+      std::recursive_mutex m_dependencies;
+      internal::ParseCache* m_parseCache;
+      internal::BuildCache* m_buildCache;
+      internal::IncrementalParser* m_incremental;
+      CompilationInfo* m_info;
+      internal::Metrics* m_metrics;
+      FILE* m_dumpFile;
+      internal::Writer* m_dumpWriter;
+      internal::AstDump* m_dump;
+      int m_numWorkers;
+      internal::MetricPhase m_lastPhase;
+
+      // A hash of the images that have been loaded.
+      uint64_t m_imageHash;
+
+      internal::ModulePath* m_modulePath;
+
+      // Hashes of the interfaces of modules during a cached compile.
+      internal::NameMap<uint64_t> m_moduleHashes;
+
+      void closeDump();
+
+      // Runs the phases of the given units. The first numEntered units
+      // already have their symbols and are only linked.
+      void run(CompilationUnit** units, const int* indices, int numUnits, int numEntered, bool isLinked);
+
+      // Loads the modules a unit requires that no unit declares from
+      // the module path.
+      void loadRequired(CompilationUnit* unit);
+
+      void compileCached(CompilationUnit** units, const int* indices, int numUnits);
+      internal::Artifact* restore(CompilationUnit* unit, List<internal::ImageType>* unresolved);
+
+      // Calls f with every top-level module a unit declares.
+      void foreachModule(CompilationUnit* unit, std::function<void(internal::syms::Symbol*)> f); //NOLINT
+
+      // Writes an image of the modules of a unit.
+      void interfaceOf(CompilationUnit* unit, internal::ByteBuffer* target);
+
+      // Writes the interface files of the modules of a unit.
+      void storeInterfaces(CompilationUnit* unit);
+
+      // A hash of what every unit is linked against: the images, the
+      // names of all top-level modules and the declarations of the
+      // dependencies.
+      uint64_t globalHash();
+
+      // A hash of the interface of a top-level module, which may be
+      // declared by a unit or loaded from an interface file.
+      uint64_t moduleHash(internal::NameId name);
+
+      // A hash of the declarations a unit has been linked against.
+      uint64_t dependencyHash(uint64_t globalHash, CompilationUnit* unit);
+
       DISALLOW_COPY_AND_ASSIGN(Compiler);
   }; //class Compiler
 } //namespace brutus
@@ -0,0 +1,170 @@
+#include "diagnostics.h"
+#include "lexer.h"
+#include "lines.h"
+#include "name.h"
+
+namespace brutus {
+namespace internal {
+#define DIAGNOSTIC_SEVERITY(x, severity, format) Severity::k##severity,
+static const Severity kSeverities[] = {
+  DIAGNOSTICS(DIAGNOSTIC_SEVERITY)
+};
+#undef DIAGNOSTIC_SEVERITY
+
+#define DIAGNOSTIC_FORMAT(x, severity, format) format,
+static const char* const kFormats[] = {
+  DIAGNOSTICS(DIAGNOSTIC_FORMAT)
+};
+#undef DIAGNOSTIC_FORMAT
+
+bool Diagnostics::report(DiagnosticCode code, uint32_t offset, uint32_t arg0, uint32_t arg1) {
+  if(offset == m_lastOffset) {
+    return NO;
+  }
+
+  m_lastOffset = offset;
+  count(code, 1);
+
+  if(m_size >= m_limit) {
+    return YES;
+  }
+
+  Diagnostic diagnostic;
+
+  diagnostic.m_code = code;
+  diagnostic.m_offset = offset;
+  diagnostic.m_args[0] = arg0;
+  diagnostic.m_args[1] = arg1;
+
+  m_records.append(diagnostic);
+  ++m_size;
+
+  return YES;
+}
+
+void Diagnostics::replace(uint32_t start, uint32_t end, int64_t delta) {
+  retain([=](Diagnostic* diagnostic) -> bool {
+    if(diagnostic->m_offset < start) {
+      return YES;
+    }
+
+    if(diagnostic->m_offset < end) {
+      return NO;
+    }
+
+    diagnostic->m_offset = static_cast<uint32_t>(diagnostic->m_offset + delta);
+    return YES;
+  });
+}
+
+void Diagnostics::remove(DiagnosticCode code) {
+  retain([=](Diagnostic* diagnostic) -> bool {
+    return diagnostic->m_code != code;
+  });
+}
+
+void Diagnostics::retain(std::function<bool(Diagnostic*)> f) { //NOLINT
+  auto records = m_records.at<Diagnostic>(0);
+  int size = 0;
+
+  for(int i = 0; i < m_size; ++i) {
+    auto diagnostic = records[i];
+
+    if(!f(&diagnostic)) {
+      count(diagnostic.m_code, -1);
+      continue;
+    }
+
+    records[size++] = diagnostic;
+  }
+
+  m_lastOffset = NoOffset;
+
+  m_records.truncate(size * sizeof(Diagnostic)); //NOLINT
+  m_size = size;
+}
+
+void Diagnostics::clear() {
+  m_records.clear();
+  m_size = 0;
+  m_lastOffset = NoOffset;
+  m_numErrors = 0;
+  m_numWarnings = 0;
+}
+
+void Diagnostics::count(DiagnosticCode code, int delta) {
+  if(Severity::kError == severityOf(code)) {
+    m_numErrors += delta;
+  } else {
+    m_numWarnings += delta;
+  }
+}
+
+void Diagnostics::print(std::ostream& output, NameTable* names, LineTable* lines) const {
+  for(int i = 0; i < m_size; ++i) {
+    auto& diagnostic = at(i);
+
+    if(nullptr != lines) {
+      uint32_t line;
+      uint32_t column;
+
+      lines->position(diagnostic.m_offset, &line, &column);
+      output << (line + 1) << ':' << (column + 1) << ": ";
+    }
+
+    output << (Severity::kError == severityOf(diagnostic.m_code) ? "error: " : "warning: ");
+    format(output, diagnostic, names);
+    output << std::endl;
+  }
+
+  const auto numDropped = this->numDropped();
+
+  if(numDropped > 0) {
+    output << numDropped << " more diagnostics have been omitted." << std::endl;
+  }
+}
+
+Severity Diagnostics::severityOf(DiagnosticCode code) {
+  return kSeverities[static_cast<int>(code)];
+}
+
+void Diagnostics::format(std::ostream& output, const Diagnostic& diagnostic, NameTable* names) {
+  auto chars = kFormats[static_cast<int>(diagnostic.m_code)];
+  int arg = 0;
+
+  for(; '\0' != *chars; ++chars) {
+    if('%' != chars[0] || ('t' != chars[1] && 'n' != chars[1]) || arg > 1) {
+      output << *chars;
+      continue;
+    }
+
+    const auto value = diagnostic.m_args[arg++];
+
+    if('t' == *++chars) {
+      output << tok::toString(static_cast<Token>(value));
+    } else if(nullptr != names && kInvalidName != value) {
+      output << names->value(value);
+    } else {
+      output << '?';
+    }
+  }
+}
+
+bool Diagnostics::isName(DiagnosticCode code, int index) {
+  auto chars = kFormats[static_cast<int>(code)];
+  int arg = 0;
+
+  for(; '\0' != *chars; ++chars) {
+    if('%' == chars[0] && ('t' == chars[1] || 'n' == chars[1])) {
+      if(arg++ == index) {
+        return 'n' == chars[1];
+      }
+
+      ++chars;
+    }
+  }
+
+  return NO;
+}
+} //namespace internal
+} //namespace brutus
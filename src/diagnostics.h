@@ -0,0 +1,157 @@
+#ifndef BRUTUS_DIAGNOSTICS_H_
+#define BRUTUS_DIAGNOSTICS_H_
+
+#include <functional>
+#include <iostream>
+
+#include "brutus.h"
+#include "buffer.h"
+
+namespace brutus {
+  namespace internal {
+    class LineTable;
+    class NameTable;
+
+    // Every diagnostic the compiler reports with its severity and the
+    // format of its message. A %t in the format is replaced with the
+    // next argument as a token and a %n with the next argument as a
+    // name.
+#define DIAGNOSTICS(V) \
+  V(ExpectedToken, Error, "Invalid syntax. Expected %t, got %t.") \
+  V(UnexpectedToken, Error, "Unexpected token %t.") \
+  V(UnexpectedEndOfFile, Error, "Unexpected end of file.") \
+  V(InternalError, Error, "Internal error.") \
+  V(NumberLiteralNotImplemented, Error, "Number literals are not implemented yet.") \
+  V(IntervalNotImplemented, Error, "Intervals are not implemented yet.") \
+  V(HashSelectNotImplemented, Error, "Selecting with '#' is not implemented yet.") \
+  V(ExpectedIntervalEnd, Error, "Expected ']' or ')'.") \
+  V(ExpectedCommaOrBracket, Error, "Expected ',' or ']'.") \
+  V(ImmutableFunction, Error, "Function may not be marked immutable.") \
+  V(PureClass, Error, "Class may not be marked pure.") \
+  V(ImmutableVariable, Error, "Variable may not be marked immutable.") \
+  V(PureVariable, Error, "Variable may not be marked pure.") \
+  V(ExpectedDeclaration, Error, "Expected 'def', 'var', 'val' or 'class'.") \
+  V(ExpectedClass, Error, "Expected 'class'.") \
+  V(ExpectedDef, Error, "Expected 'def'.") \
+  V(TooManyParameters, Error, "Function exceeds max arity.") \
+  V(ExpectedFunctionBody, Error, "Expected '=' or a newline.") \
+  V(ExpectedReturnType, Error, "Expected ':', '{' or a newline.") \
+  V(TooManyTupleElements, Error, "Tuple exceeds max arity.") \
+  V(ExpectedPrimaryExpression, Error, "Expected primary expression.") \
+  V(ExpectedExpression, Error, "Expected expression.") \
+  V(ExpectedCall, Error, "Expected call.") \
+  V(ExpectedThis, Error, "Expected this.") \
+  V(ExpectedBooleanLiteral, Error, "Expected boolean literal.") \
+  V(ExpectedVarOrVal, Error, "Expected 'var' or 'val'.") \
+  V(MissingTypeOrInitializer, Error, "Either a type or initializer must be given.") \
+  V(NoSuchName, Error, "No such name '%n'.") \
+  V(UnresolvedExpression, Error, "Cannot resolve expression.") \
+  V(NoSuchModule, Error, "No such module '%n'.") \
+  V(NoSuchMember, Error, "No such member '%n'.")
+
+#define DECLARE_DIAGNOSTIC_CODE(x, severity, format) k##x,
+    enum class DiagnosticCode : uint16_t {
+      DIAGNOSTICS(DECLARE_DIAGNOSTIC_CODE)
+      kNumCodes
+    }; //enum DiagnosticCode
+#undef DECLARE_DIAGNOSTIC_CODE
+
+    enum class Severity {
+      kWarning,
+      kError
+    }; //enum Severity
+
+    // A diagnostic is only a code, the offset in the text of its unit
+    // and the ids of its arguments. The message is formatted when the
+    // diagnostic is printed.
+    class Diagnostic {
+      public:
+        DiagnosticCode m_code;
+        uint32_t m_offset;
+        uint32_t m_args[2];
+    };
+
+    // Collects the diagnostics of one unit.
+    //
+    // A diagnostic at the same offset as the previous one is dropped.
+    // That is usually a cascade, like the parser failing at the same
+    // token again in every production it returns from. Only the
+    // first limit diagnostics are kept, the others are only counted.
+    // Broken input therefore costs no more than appending a few bytes
+    // per error.
+    class Diagnostics {
+      public:
+        static const int DefaultLimit = 100;
+        static const uint32_t NoOffset = 0xffffffff;
+
+        explicit Diagnostics()
+            : m_size(0),
+              m_limit(DefaultLimit),
+              m_lastOffset(NoOffset),
+              m_numErrors(0),
+              m_numWarnings(0) {}
+
+        // Returns NO if the diagnostic has been dropped as a cascade.
+        bool report(DiagnosticCode code, uint32_t offset, uint32_t arg0, uint32_t arg1);
+
+        ALWAYS_INLINE bool report(DiagnosticCode code, uint32_t offset) {
+          return report(code, offset, 0, 0);
+        }
+
+        // Drops the diagnostics between start and end and moves all
+        // diagnostics after end by delta characters.
+        void replace(uint32_t start, uint32_t end, int64_t delta);
+
+        // Drops all diagnostics with the given code.
+        void remove(DiagnosticCode code);
+
+        void clear();
+
+        ALWAYS_INLINE int size() const { return m_size; }
+
+        ALWAYS_INLINE const Diagnostic& at(int index) const {
+          return *m_records.at<Diagnostic>(index * sizeof(Diagnostic)); //NOLINT
+        }
+
+        ALWAYS_INLINE int numErrors() const { return m_numErrors; }
+        ALWAYS_INLINE int numWarnings() const { return m_numWarnings; }
+
+        // The number of diagnostics that have been counted but not kept.
+        ALWAYS_INLINE int numDropped() const {
+          return m_numErrors + m_numWarnings - m_size;
+        }
+
+        ALWAYS_INLINE void limit(int value) { m_limit = value; }
+
+        // Prints every diagnostic on a line of its own, prefixed with
+        // its line and column if a line table is given.
+        void print(std::ostream& output, NameTable* names, LineTable* lines) const;
+
+        static Severity severityOf(DiagnosticCode code);
+
+        // Writes the message of the diagnostic.
+        static void format(std::ostream& output, const Diagnostic& diagnostic, NameTable* names);
+
+        // Whether the argument at the given index is a name. Other
+        // arguments are tokens.
+        static bool isName(DiagnosticCode code, int index);
+
+      private:
+        ByteBuffer m_records;
+        int m_size;
+        int m_limit;
+        uint32_t m_lastOffset;
+        int m_numErrors;
+        int m_numWarnings;
+
+        void count(DiagnosticCode code, int delta);
+
+        // Keeps only the diagnostics f returns YES for. f may change
+        // the diagnostic it is given.
+        void retain(std::function<bool(Diagnostic*)> f); //NOLINT
+
+        DISALLOW_COPY_AND_ASSIGN(Diagnostics);
+    }; //class Diagnostics
+  } //namespace internal
+} //namespace brutus
+#endif
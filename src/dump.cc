@@ -0,0 +1,114 @@
+#include <sstream>
+
+#include "dump.h"
+#include "visitor.h"
+
+namespace brutus {
+namespace internal {
+#define NODE_KIND_NAME(x) #x,
+static const char* const kNodeKindNames[] = {
+  AST_NODE_KINDS(NODE_KIND_NAME)
+};
+#undef NODE_KIND_NAME
+
+AstDump::AstDump(Writer* writer, DumpFormat format, NameTable* names)
+    : m_writer(writer),
+      m_format(format),
+      m_names(names),
+      m_numUnits(0) {}
+
+void AstDump::begin() {
+  m_numUnits = 0;
+
+  if(DumpFormat::kJson == m_format) {
+    *m_writer << '[';
+  }
+}
+
+bool AstDump::end() {
+  if(DumpFormat::kJson == m_format) {
+    *m_writer << (0 == m_numUnits ? "]\n" : "\n]\n");
+  }
+
+  return m_writer->flush();
+}
+
+void AstDump::dump(ast::Node* node, LineTable* lines, int index) {
+  if(nullptr == node) {
+    return;
+  }
+
+  if(DumpFormat::kText == m_format) {
+    ast::ASTPrinter printer(m_writer, m_names, lines);
+
+    printer.print(node);
+    *m_writer << '\n';
+  } else {
+    *m_writer << (0 == m_numUnits ? "\n" : ",\n") << "{\"unit\": " << index << ", \"ast\": ";
+    writeJson(node, lines);
+    *m_writer << '}';
+  }
+
+  ++m_numUnits;
+}
+
+void AstDump::writeJson(ast::Node* node, LineTable* lines) {
+  auto& writer = *m_writer;
+
+  writer << "{\"kind\": \"" << kNodeKindNames[static_cast<int>(node->kind())] << "\", \"offset\": " << node->offset();
+
+  if(nullptr != lines) {
+    uint32_t line;
+    uint32_t column;
+
+    lines->position(node->offset(), &line, &column);
+    writer << ", \"line\": " << line + 1 << ", \"column\": " << column + 1;
+  }
+
+  switch(node->kind()) {
+    case ast::NodeKind::kIdentifier:
+      writer << ", \"value\": ";
+      writer.writeJsonString(m_names->value(static_cast<ast::Identifier*>(node)->name()));
+      break;
+    case ast::NodeKind::kNumber:
+      writer << ", \"value\": ";
+      writer.writeJsonString(m_names->value(static_cast<ast::Number*>(node)->name()));
+      break;
+    case ast::NodeKind::kString:
+      writer << ", \"value\": ";
+      writer.writeJsonString(m_names->value(static_cast<ast::String*>(node)->name()));
+      break;
+    case ast::NodeKind::kError: {
+        std::ostringstream message;
+
+        Diagnostics::format(message, static_cast<ast::Error*>(node)->diagnostic(), m_names);
+        writer << ", \"message\": ";
+        writer.writeJsonString(message.str().c_str());
+      }
+      break;
+    case ast::NodeKind::kFunction:
+      if(static_cast<ast::Function*>(node)->hasLazyBody()) {
+        writer << ", \"lazy\": true";
+      }
+      break;
+    case ast::NodeKind::kAssign:
+      if(static_cast<ast::Assign*>(node)->force()) {
+        writer << ", \"force\": true";
+      }
+      break;
+    default:
+      break;
+  }
+
+  bool isFirst = YES;
+
+  ast::forEachChild(node, [&](ast::Node* child) {
+    writer << (isFirst ? ", \"children\": [" : ", ");
+    writeJson(child, lines);
+    isFirst = NO;
+  });
+
+  writer << (isFirst ? "}" : "]}");
+}
+} //namespace internal
+} //namespace brutus
@@ -0,0 +1,52 @@
+#ifndef BRUTUS_DUMP_H_
+#define BRUTUS_DUMP_H_
+
+#include "brutus.h"
+#include "ast.h"
+#include "lines.h"
+#include "name.h"
+#include "writer.h"
+
+namespace brutus {
+  namespace internal {
+    enum class DumpFormat {
+      // The source as the ASTPrinter formats it.
+      kText,
+
+      // One object per node with its kind, position and children.
+      kJson
+    }; //enum DumpFormat
+
+    // Writes the ASTs of units once they have been parsed.
+    //
+    // A JSON dump of all units of a compile is an array with one
+    // element per unit:
+    //
+    //   {"unit": 0, "ast": {"kind": "Program", "offset": 0,
+    //     "line": 1, "column": 1, "children": [...]}}
+    //
+    // Identifiers, numbers and strings have a "value", errors have a
+    // "message" and functions whose body has been skipped are "lazy".
+    class AstDump {
+      public:
+        explicit AstDump(Writer* writer, DumpFormat format, NameTable* names);
+
+        // Starts and ends the dump of a compile.
+        void begin();
+        bool end();
+
+        void dump(ast::Node* node, LineTable* lines, int index);
+
+      private:
+        Writer* const m_writer;
+        const DumpFormat m_format;
+        NameTable* const m_names;
+        int m_numUnits;
+
+        void writeJson(ast::Node* node, LineTable* lines);
+
+        DISALLOW_COPY_AND_ASSIGN(AstDump);
+    }; //class AstDump
+  } //namespace internal
+} //namespace brutus
+#endif
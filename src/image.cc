@@ -0,0 +1,551 @@
+#include <algorithm>
+#include <cstring>
+
+#include "image.h"
+#include "compiler.h"
+#include "types.h"
+
+namespace brutus {
+namespace internal {
+ImageWriter::ImageWriter(Context* context)
+    : m_context(context),
+      m_numNames(0),
+      m_numSymbols(0) {}
+
+bool ImageWriter::write(FILE* fp) {
+  m_context->symbols()->global()->foreach([&](syms::Symbol* symbol) {
+    if(symbol->kind() == syms::SymbolKind::kModule) {
+      add(symbol);
+    }
+  });
+
+  const auto header = this->header();
+
+  return fwrite(&header, sizeof(header), 1, fp) == 1 //NOLINT
+      && m_names.writeTo(fp)
+      && m_symbols.writeTo(fp)
+      && m_types.writeTo(fp)
+      && m_pool.writeTo(fp);
+}
+
+void ImageWriter::add(syms::Symbol* module) {
+  writeSymbol(module, ImageSymbol::NoContainer);
+}
+
+void ImageWriter::write(ByteBuffer* target) {
+  target->append(header());
+  target->append(m_names.data(), m_names.size());
+  target->append(m_symbols.data(), m_symbols.size());
+  target->append(m_types.data(), m_types.size());
+  target->append(m_pool.data(), m_pool.size());
+}
+
+ImageHeader ImageWriter::header() const {
+  ImageHeader header;
+
+  header.m_magic = ImageHeader::Magic;
+  header.m_version = ImageHeader::Version;
+  header.m_numNames = m_numNames;
+  header.m_numSymbols = m_numSymbols;
+  header.m_namesOffset = sizeof(ImageHeader); //NOLINT
+  header.m_symbolsOffset = header.m_namesOffset + m_names.size();
+  header.m_typesOffset = header.m_symbolsOffset + m_symbols.size();
+  header.m_typesSize = m_types.size();
+  header.m_poolOffset = header.m_typesOffset + m_types.size();
+  header.m_poolSize = m_pool.size();
+
+  return header;
+}
+
+uint32_t ImageWriter::nameOf(NameId name) {
+  if(kInvalidName == name) {
+    return kInvalidName;
+  }
+
+  // The index is stored off by one since zero means "not present".
+  auto index = m_nameIndex.get(name);
+
+  if(0 != index) {
+    return index - 1;
+  }
+
+  auto names = m_context->names();
+  ImageName record;
+
+  record.m_offset = m_pool.size();
+  record.m_length = names->length(name);
+
+  m_pool.append(names->value(name), record.m_length + 1);
+  m_names.append(record);
+  m_nameIndex.put(name, ++m_numNames);
+
+  return m_numNames - 1;
+}
+
+uint32_t ImageWriter::typeOf(types::Type* type) {
+  if(nullptr == type || type->kind() != types::TypeKind::kClass) {
+    return ImageSymbol::NoType;
+  }
+
+  // Only a class that is nested in modules and classes has a path.
+  uint32_t length = 0;
+
+  for(auto symbol = type->symbol(); nullptr != symbol; symbol = symbol->parent()) {
+    const auto kind = symbol->kind();
+
+    if(kind != syms::SymbolKind::kClass && kind != syms::SymbolKind::kModule) {
+      return ImageSymbol::NoType;
+    }
+
+    if(nullptr == symbol->parent() && kind != syms::SymbolKind::kModule) {
+      return ImageSymbol::NoType;
+    }
+
+    ++length;
+  }
+
+  auto path = NewArray<uint32_t>(length);
+  auto index = length;
+
+  for(auto symbol = type->symbol(); nullptr != symbol; symbol = symbol->parent()) {
+    path[--index] = nameOf(symbol->name());
+  }
+
+  const auto result = static_cast<uint32_t>(m_types.size() / sizeof(uint32_t)); //NOLINT
+
+  m_types.append(length);
+  m_types.append(path, length * sizeof(uint32_t)); //NOLINT
+
+  DeleteArray(path);
+
+  return result;
+}
+
+void ImageWriter::writeSymbol(syms::Symbol* symbol, int32_t container) {
+  switch(symbol->kind()) {
+    case syms::SymbolKind::kError:
+    case syms::SymbolKind::kEmpty:
+      // Neither are declarations.
+      return;
+    default:
+      break;
+  }
+
+  const int32_t index = static_cast<int32_t>(m_numSymbols++);
+  ImageSymbol record;
+
+  record.m_kind = static_cast<uint32_t>(symbol->kind());
+  record.m_name = nameOf(symbol->name());
+  record.m_container = container;
+  record.m_numParameters = 0;
+  record.m_type = ImageSymbol::NoType;
+
+  if(symbol->kind() == syms::SymbolKind::kFunction && nullptr != symbol->type()) {
+    auto type = static_cast<types::FunctionType*>(symbol->type());
+    auto parameters = type->parameters();
+
+    for(int i = 0; i < type->numParameters(); ++i) {
+      if(nullptr != parameters[i]) {
+        ++record.m_numParameters;
+      }
+    }
+
+    record.m_type = typeOf(type->returnType());
+  } else if(symbol->kind() == syms::SymbolKind::kVariable) {
+    record.m_type = typeOf(symbol->type());
+  }
+
+  m_symbols.append(record);
+
+  switch(symbol->kind()) {
+    case syms::SymbolKind::kModule:
+    case syms::SymbolKind::kClass:
+      writeScope(symbol->scope(), index);
+      break;
+    case syms::SymbolKind::kFunction:
+      // The scope of a function holds its locals as well. Only the
+      // parameters are part of the declaration.
+      writeParameters(symbol, index);
+      break;
+    case syms::SymbolKind::kOverload:
+      writeOverload(static_cast<syms::OverloadSymbol*>(symbol), index);
+      break;
+    default:
+      break;
+  }
+}
+
+void ImageWriter::writeScope(syms::Scope* scope, int32_t container) {
+  // Scopes are ordered by the ids of their names, which depend on the
+  // order names have been interned in. Symbols are written by name so
+  // the same declarations always give the same image.
+  int numSymbols = 0;
+
+  scope->foreach([&](syms::Symbol* symbol) {
+    UNUSED(symbol);
+    ++numSymbols;
+  });
+
+  auto symbols = NewArray<syms::Symbol*>(numSymbols);
+  auto names = m_context->names();
+  int index = 0;
+
+  scope->foreach([&](syms::Symbol* symbol) {
+    symbols[index++] = symbol;
+  });
+
+  std::sort(symbols, symbols + numSymbols, [=](syms::Symbol* a, syms::Symbol* b) {
+    return std::strcmp(names->value(a->name()), names->value(b->name())) < 0;
+  });
+
+  for(int i = 0; i < numSymbols; ++i) {
+    writeSymbol(symbols[i], container);
+  }
+
+  DeleteArray(symbols);
+}
+
+void ImageWriter::writeOverload(syms::OverloadSymbol* overload, int32_t container) {
+  // OverloadSymbol::add() prepends so the members are written in
+  // reverse order to get the same order back when they are loaded.
+  int numMembers = 0;
+
+  overload->foreach([&](syms::Symbol* member) {
+    UNUSED(member);
+    ++numMembers;
+  });
+
+  auto members = NewArray<syms::Symbol*>(numMembers);
+  int index = numMembers;
+
+  overload->foreach([&](syms::Symbol* member) {
+    members[--index] = member;
+  });
+
+  for(int i = 0; i < numMembers; ++i) {
+    writeSymbol(members[i], container);
+  }
+
+  DeleteArray(members);
+}
+
+void ImageWriter::writeParameters(syms::Symbol* function, int32_t container) {
+  if(nullptr == function->type()) {
+    return;
+  }
+
+  auto type = static_cast<types::FunctionType*>(function->type());
+  auto parameters = type->parameters();
+
+  for(int i = 0; i < type->numParameters(); ++i) {
+    if(nullptr != parameters[i]) {
+      writeSymbol(parameters[i], container);
+    }
+  }
+}
+
+//
+
+ImageReader::ImageReader(Context* context)
+    : m_context(context) {}
+
+bool ImageReader::load(const char* path) {
+  if(!m_file.open(path)) {
+    return NO;
+  }
+
+  return load(m_file.data(), m_file.size());
+}
+
+bool ImageReader::isValid(const ImageHeader* header, size_t size) {
+  if(size < sizeof(ImageHeader)) { //NOLINT
+    return NO;
+  }
+
+  if(header->m_magic != ImageHeader::Magic ||
+     header->m_version != ImageHeader::Version) {
+    return NO;
+  }
+
+  const uint64_t namesEnd =
+    header->m_namesOffset +
+    static_cast<uint64_t>(header->m_numNames) * sizeof(ImageName); //NOLINT
+  const uint64_t symbolsEnd =
+    header->m_symbolsOffset +
+    static_cast<uint64_t>(header->m_numSymbols) * sizeof(ImageSymbol); //NOLINT
+  const uint64_t typesEnd =
+    static_cast<uint64_t>(header->m_typesOffset) + header->m_typesSize;
+  const uint64_t poolEnd =
+    static_cast<uint64_t>(header->m_poolOffset) + header->m_poolSize;
+
+  // The types table is read in place so it has to be aligned.
+  if(0 != header->m_typesOffset % sizeof(uint32_t) || //NOLINT
+     0 != header->m_typesSize % sizeof(uint32_t)) { //NOLINT
+    return NO;
+  }
+
+  return namesEnd <= size && symbolsEnd <= size && typesEnd <= size && poolEnd <= size;
+}
+
+ALWAYS_INLINE static syms::Scope* newScope(Arena* arena, syms::Scope* parentScope, syms::ScopeKind kind) {
+  auto result = new (arena) syms::Scope(arena);
+  result->init(parentScope, kind);
+
+  return result;
+}
+
+bool ImageReader::load(const char* data, size_t size) {
+  return load(data, size, m_context->arena(), m_context->symbols()->global(), nullptr, nullptr);
+}
+
+bool ImageReader::resolve(const ImageType& type, syms::Symbol* module) {
+  if(nullptr == module || module->kind() != syms::SymbolKind::kModule) {
+    return NO;
+  }
+
+  auto symbol = module;
+
+  for(uint32_t i = 1; i < type.m_length && nullptr != symbol; ++i) {
+    symbol = symbol->scope()->getLocal(type.m_path[i]);
+
+    if(nullptr != symbol &&
+       symbol->kind() != syms::SymbolKind::kClass &&
+       symbol->kind() != syms::SymbolKind::kModule) {
+      symbol = nullptr;
+    }
+  }
+
+  if(nullptr == symbol || symbol->kind() != syms::SymbolKind::kClass) {
+    return NO;
+  }
+
+  if(type.m_symbol->kind() == syms::SymbolKind::kFunction) {
+    static_cast<types::FunctionType*>(type.m_symbol->type())->returnType(symbol->type());
+  } else {
+    type.m_symbol->type(symbol->type());
+  }
+
+  return YES;
+}
+
+bool ImageReader::load(
+    const char* data, size_t size, Arena* arena, syms::Scope* scope,
+    std::function<void(syms::Symbol*)> f, List<ImageType>* unresolved) { //NOLINT
+  auto header = reinterpret_cast<const ImageHeader*>(data);
+
+  if(!isValid(header, size)) {
+    std::cerr << "Error: Invalid image." << std::endl;
+    return NO;
+  }
+
+  auto names = m_context->names();
+  auto imageNames = reinterpret_cast<const ImageName*>(data + header->m_namesOffset);
+  auto imageSymbols = reinterpret_cast<const ImageSymbol*>(data + header->m_symbolsOffset);
+  auto pool = data + header->m_poolOffset;
+
+  // Names of the image are entered into the name table first. Ids of
+  // the image are local to it so we keep a mapping to our own ids.
+  const auto numNames = header->m_numNames;
+  auto nameIds = NewArray<NameId>(numNames);
+
+  for(uint32_t i = 0; i < numNames; ++i) {
+    const auto& name = imageNames[i];
+
+    if(name.m_offset + name.m_length >= header->m_poolSize) {
+      DeleteArray(nameIds);
+      return NO;
+    }
+
+    nameIds[i] = names->get(pool + name.m_offset, name.m_length);
+  }
+
+  const auto numSymbols = header->m_numSymbols;
+  auto symbols = NewArray<syms::Symbol*>(numSymbols);
+  auto scopes = NewArray<syms::Scope*>(numSymbols);
+  auto numParameters = NewArray<uint32_t>(numSymbols);
+  bool result = YES;
+
+  for(uint32_t i = 0; i < numSymbols && result; ++i) {
+    const auto& record = imageSymbols[i];
+    const auto container = record.m_container;
+
+    if(container < ImageSymbol::NoContainer ||
+       container >= static_cast<int32_t>(i) ||
+       record.m_name >= numNames) {
+      result = NO;
+      break;
+    }
+
+    // The container of a symbol is either the given scope, a
+    // declaration that has a scope or an overload.
+    syms::Symbol* containerSymbol =
+      container == ImageSymbol::NoContainer ? nullptr : symbols[container];
+    syms::OverloadSymbol* overload = nullptr;
+    syms::Scope* containerScope = scope;
+    syms::Symbol* parent = containerSymbol;
+
+    if(nullptr != containerSymbol) {
+      if(containerSymbol->kind() == syms::SymbolKind::kOverload) {
+        overload = static_cast<syms::OverloadSymbol*>(containerSymbol);
+        parent = overload->parent();
+      }
+
+      containerScope = scopes[container];
+    }
+
+    const auto name = nameIds[record.m_name];
+    types::Type* parentType = nullptr == parent ? nullptr : parent->type();
+
+    symbols[i] = nullptr;
+    scopes[i] = containerScope;
+    numParameters[i] = 0;
+
+    switch(static_cast<syms::SymbolKind>(record.m_kind)) {
+      case syms::SymbolKind::kModule: {
+          auto symbolScope = newScope(arena, containerScope, syms::ScopeKind::kModule);
+          auto symbol = new (arena) syms::ModuleSymbol();
+
+          symbol->init(name, parent, nullptr, symbolScope, nullptr);
+          containerScope->put(name, symbol);
+          symbols[i] = symbol;
+          scopes[i] = symbolScope;
+
+          if(nullptr != f && nullptr == parent) {
+            f(symbol);
+          }
+        }
+        break;
+      case syms::SymbolKind::kClass: {
+          auto symbolScope = newScope(arena, containerScope, syms::ScopeKind::kClass);
+          auto symbol = new (arena) syms::ClassSymbol();
+          auto type = new (arena) types::ClassType(symbol, 0, nullptr, 0, nullptr);
+
+          symbol->init(name, parent, nullptr, symbolScope, type);
+          containerScope->put(name, symbol);
+          symbols[i] = symbol;
+          scopes[i] = symbolScope;
+        }
+        break;
+      case syms::SymbolKind::kFunction: {
+          auto symbolScope = newScope(arena, containerScope, syms::ScopeKind::kFunction);
+          auto symbol = new (arena) syms::FunctionSymbol();
+          auto parameters = arena->newArray<syms::Symbol*>(record.m_numParameters);
+          auto type = new (arena) types::FunctionType(
+            symbol, 0, nullptr, parentType,
+            record.m_numParameters, parameters, nullptr);
+
+          symbol->init(name, parent, nullptr, symbolScope, type);
+
+          if(nullptr != overload) {
+            overload->add(symbol);
+          } else {
+            containerScope->putOrOverload(name, symbol);
+          }
+
+          symbols[i] = symbol;
+          scopes[i] = symbolScope;
+        }
+        break;
+      case syms::SymbolKind::kOverload: {
+          auto symbol = new (arena) syms::OverloadSymbol();
+
+          symbol->init(name, parent, nullptr);
+          containerScope->put(name, symbol);
+          symbols[i] = symbol;
+        }
+        break;
+      case syms::SymbolKind::kVariable: {
+          auto symbol = new (arena) syms::VariableSymbol();
+
+          symbol->init(name, parent, nullptr);
+          containerScope->put(name, symbol);
+          symbols[i] = symbol;
+
+          if(nullptr != parent && parent->kind() == syms::SymbolKind::kFunction) {
+            // A variable contained in a function is one of its parameters.
+            auto type = static_cast<types::FunctionType*>(parent->type());
+            auto& index = numParameters[container];
+
+            if(index < static_cast<uint32_t>(type->numParameters())) {
+              type->parameters()[index++] = symbol;
+            } else {
+              result = NO;
+            }
+          }
+        }
+        break;
+      default:
+        result = NO;
+        break;
+    }
+  }
+
+  // Types are resolved once all symbols exist since a class may be
+  // declared after the symbols that refer to it.
+  auto types = reinterpret_cast<const uint32_t*>(data + header->m_typesOffset);
+  const auto numTypes = header->m_typesSize / sizeof(uint32_t); //NOLINT
+  List<ImageType> pending;
+
+  for(uint32_t i = 0; i < numSymbols && result; ++i) {
+    const auto& record = imageSymbols[i];
+    auto symbol = symbols[i];
+
+    if(ImageSymbol::NoType == record.m_type) {
+      continue;
+    }
+
+    if((symbol->kind() != syms::SymbolKind::kFunction && symbol->kind() != syms::SymbolKind::kVariable) ||
+       record.m_type >= numTypes || 0 == types[record.m_type] ||
+       types[record.m_type] > numTypes - record.m_type - 1) {
+      result = NO;
+      break;
+    }
+
+    const auto length = types[record.m_type];
+    auto path = types + record.m_type + 1;
+    auto pathIds = NewArray<NameId>(length);
+
+    for(uint32_t j = 0; j < length && result; ++j) {
+      if(path[j] >= numNames) {
+        result = NO;
+      } else {
+        pathIds[j] = nameIds[path[j]];
+      }
+    }
+
+    ImageType type;
+
+    type.m_symbol = symbol;
+    type.m_path = pathIds;
+    type.m_length = length;
+
+    if(result && !resolve(type, scope->get(pathIds[0])) && nullptr != unresolved) {
+      // Only the paths that are kept have to outlive the image.
+      type.m_path = arena->newArray<NameId>(length);
+      ArrayCopy(type.m_path, pathIds, static_cast<int>(length * sizeof(NameId))); //NOLINT
+      pending.addLast(type);
+    }
+
+    DeleteArray(pathIds);
+  }
+
+  // Symbols of an image that is corrupt are never used.
+  if(result) {
+    pending.foreach([&](ImageType type) {
+      unresolved->addLast(type);
+    });
+  }
+
+  DeleteArray(numParameters);
+  DeleteArray(scopes);
+  DeleteArray(symbols);
+  DeleteArray(nameIds);
+
+  if(!result) {
+    std::cerr << "Error: Corrupt image." << std::endl;
+  }
+
+  return result;
+}
+} //namespace internal
+} //namespace brutus
@@ -0,0 +1,160 @@
+#ifndef BRUTUS_IMAGE_H_
+#define BRUTUS_IMAGE_H_
+
+#include <cstdio>
+#include <functional>
+
+#include "brutus.h"
+#include "buffer.h"
+#include "list.h"
+#include "mapped.h"
+#include "name.h"
+#include "scopes.h"
+#include "symbols.h"
+
+namespace brutus {
+  class Context;
+
+  namespace internal {
+    // An image stores the names and declaration symbols of compiled
+    // modules in a relocatable binary format. It contains no pointers:
+    // names are indices into the name table of the image and symbols
+    // refer to each other by their record index.
+    //
+    // Layout:
+    //
+    //   ImageHeader
+    //   ImageName[numNames]
+    //   ImageSymbol[numSymbols]
+    //   uint32_t[typesSize / 4] paths of the classes symbols refer to
+    //   char[poolSize]         zero-terminated characters of all names
+    //
+    // Symbols are stored in preorder. The container of a symbol is
+    // the symbol whose scope holds it (or the overload it belongs to)
+    // and always precedes it.
+    //
+    // The type of a variable or parameter and the return type of a
+    // function are stored as the path of their class: its length
+    // followed by the names of the enclosing modules and classes, the
+    // top-level module first. A class may be declared by another image
+    // or unit so it is only resolved by name once the image is loaded.
+    //
+    // Only declarations are stored: modules, classes, functions with
+    // their parameters, variables and overloads. Symbols of an image
+    // have no AST.
+    class ImageHeader {
+      public:
+        static const uint32_t Magic = 0x4d495242; // "BRIM"
+        static const uint32_t Version = 2;
+
+        uint32_t m_magic;
+        uint32_t m_version;
+        uint32_t m_numNames;
+        uint32_t m_numSymbols;
+        uint32_t m_namesOffset;
+        uint32_t m_symbolsOffset;
+        uint32_t m_typesOffset;
+        uint32_t m_typesSize;
+        uint32_t m_poolOffset;
+        uint32_t m_poolSize;
+    };
+
+    class ImageName {
+      public:
+        uint32_t m_offset;
+        uint32_t m_length;
+    };
+
+    class ImageSymbol {
+      public:
+        static const int32_t NoContainer = -1;
+        static const uint32_t NoType = 0xffffffff;
+
+        uint32_t m_kind;
+        uint32_t m_name;
+        int32_t m_container;
+        uint32_t m_numParameters;
+
+        // Index of the path of the type in the types table.
+        uint32_t m_type;
+    };
+
+    // The type of a symbol that could not be resolved when its image
+    // was loaded, since the top-level module of the path was missing.
+    class ImageType {
+      public:
+        syms::Symbol* m_symbol;
+        NameId* m_path;
+        uint32_t m_length;
+    };
+
+    class ImageWriter {
+      public:
+        explicit ImageWriter(Context* context);
+
+        // Writes all modules of the global scope.
+        bool write(FILE* fp);
+
+        // Adds a module with all of its declarations.
+        void add(syms::Symbol* module);
+
+        // Appends an image of the modules that have been added.
+        void write(ByteBuffer* target);
+
+      private:
+        Context* const m_context;
+        ByteBuffer m_names;
+        ByteBuffer m_symbols;
+        ByteBuffer m_types;
+        ByteBuffer m_pool;
+        NameMap<uint32_t> m_nameIndex;
+        uint32_t m_numNames;
+        uint32_t m_numSymbols;
+
+        ImageHeader header() const;
+        uint32_t nameOf(NameId name);
+        uint32_t typeOf(types::Type* type);
+        void writeSymbol(syms::Symbol* symbol, int32_t container);
+        void writeScope(syms::Scope* scope, int32_t container);
+        void writeOverload(syms::OverloadSymbol* overload, int32_t container);
+        void writeParameters(syms::Symbol* function, int32_t container);
+
+        DISALLOW_COPY_AND_ASSIGN(ImageWriter);
+    }; //class ImageWriter
+
+    class ImageReader {
+      public:
+        explicit ImageReader(Context* context);
+
+        // Maps the image at the given path and enters its names into
+        // the name table and its modules into the global scope.
+        bool load(const char* path);
+
+        // Same as load(path) for an image that is already in memory.
+        bool load(const char* data, size_t size);
+
+        // Same as load(data, size) but allocates the symbols in the
+        // given arena, enters the modules into the given scope and calls
+        // f with every module that is entered.
+        //
+        // Types are resolved against the given scope. The types whose
+        // module cannot be found are appended to unresolved if it is
+        // given, their paths are allocated in the arena as well.
+        bool load(
+          const char* data, size_t size, Arena* arena, syms::Scope* scope,
+          std::function<void(syms::Symbol*)> f, List<ImageType>* unresolved); //NOLINT
+
+        // Resolves a type in the given top-level module of its path.
+        static bool resolve(const ImageType& type, syms::Symbol* module);
+
+      private:
+        Context* const m_context;
+        MappedFile m_file;
+
+        bool isValid(const ImageHeader* header, size_t size);
+
+        DISALLOW_COPY_AND_ASSIGN(ImageReader);
+    }; //class ImageReader
+  } //namespace internal
+} //namespace brutus
+#endif
@@ -0,0 +1,397 @@
+#include "incremental.h"
+#include "compiler.h"
+#include "trace.h"
+#include "visitor.h"
+
+namespace brutus {
+namespace internal {
+// Modules and their declarations whose source range is known. Units
+// loaded from the parse cache have no ranges.
+ALWAYS_INLINE static bool hasSourceRange(ast::Node* node) {
+  switch(node->kind()) {
+    case ast::NodeKind::kClass:
+    case ast::NodeKind::kFunction:
+    case ast::NodeKind::kModule:
+    case ast::NodeKind::kVariable:
+      return 0 != static_cast<ast::Declaration*>(node)->sourceLength();
+    default:
+      return NO;
+  }
+}
+
+// Index of the node whose source range contains the given characters,
+// or -1 if there is none.
+static int indexOfRange(ast::NodeList* nodes, size_t offset, size_t length) {
+  for(int i = 0, n = nodes->size(); i < n; ++i) {
+    auto node = nodes->nodes()[i];
+
+    if(!hasSourceRange(node)) {
+      continue;
+    }
+
+    auto range = static_cast<ast::Declaration*>(node);
+    const size_t start = range->sourceOffset();
+
+    if(start <= offset && offset + length <= start + range->sourceLength()) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+// Moves a node and all of its children by delta characters.
+static void move(ast::Node* node, int64_t delta) {
+  node->offset(static_cast<uint32_t>(node->offset() + delta));
+
+  ast::forEachChild(node, [delta](ast::Node* child) {
+    move(child, delta);
+  });
+}
+
+ALWAYS_INLINE static void foreachModule(ast::Node* program, std::function<void(ast::Module*)> f) { //NOLINT
+  if(ast::NodeKind::kProgram != program->kind()) {
+    return;
+  }
+
+  static_cast<ast::Program*>(program)->modules()->foreach([&](ast::Node* node) {
+    if(ast::NodeKind::kModule == node->kind()) {
+      f(static_cast<ast::Module*>(node));
+    }
+  });
+}
+
+// Calls f with the symbols of the top-level modules of the unit.
+static void foreachModuleSymbol(CompilationUnit* unit, std::function<void(syms::Symbol*)> f) { //NOLINT
+  if(unit->isRestored()) {
+    unit->modules()->foreach(f);
+  } else if(nullptr != unit->ast()) {
+    foreachModule(unit->ast(), [&](ast::Module* module) {
+      if(nullptr != module->symbol()) {
+        f(module->symbol());
+      }
+    });
+  }
+}
+
+// Adds the names of the top-level modules of the unit that are not
+// in the list yet.
+static void moduleNames(CompilationUnit* unit, List<NameId>* names) {
+  foreachModuleSymbol(unit, [names](syms::Symbol* module) {
+    if(-1 == names->indexOf(module->name())) {
+      names->addLast(module->name());
+    }
+  });
+}
+
+IncrementalParser::IncrementalParser(
+    Context* context, List<CompilationUnit*>* units,
+    SymbolsPhase* symbols, LinkPhase* link)
+    : m_context(context),
+      m_units(units),
+      m_symbols(symbols),
+      m_link(link) {}
+
+EditResult IncrementalParser::edit(
+    CompilationUnit* unit, size_t offset, size_t length,
+    const char* text, size_t textLength) {
+  TRACE_SCOPE("incremental", "edit");
+
+  // Skipped bodies of a dependency point into its text so it must not
+  // change. A unit restored from the build cache is rebuilt from its
+  // text.
+  if((nullptr == unit->ast() && !unit->isRestored()) || unit->isDependency()) {
+    return EditResult::kInvalid;
+  }
+
+  auto buffer = unit->text();
+
+  if(offset > buffer->size() || length > buffer->size() - offset) {
+    return EditResult::kInvalid;
+  }
+
+  buffer->replace(offset, length, text, textLength);
+  unit->lines()->reset();
+
+  if(nullptr != unit->ast() && reparseDeclaration(unit, offset, length, textLength)) {
+    return EditResult::kDeclaration;
+  }
+
+  rebuild(unit);
+
+  return EditResult::kUnit;
+}
+
+bool IncrementalParser::reparseDeclaration(CompilationUnit* unit, size_t offset, size_t length, size_t textLength) {
+  TRACE_SCOPE("incremental", "reparseDeclaration");
+
+  if(ast::NodeKind::kProgram != unit->ast()->kind()) {
+    return NO;
+  }
+
+  // The ranges still refer to the text before the edit.
+  auto modules = static_cast<ast::Program*>(unit->ast())->modules();
+  const auto moduleIndex = indexOfRange(modules, offset, length);
+
+  if(-1 == moduleIndex) {
+    return NO;
+  }
+
+  auto module = static_cast<ast::Module*>(modules->nodes()[moduleIndex]);
+  auto text = unit->text();
+  Diagnostics errors;
+
+  auto parse = [&](ast::Node* declaration, bool isModule) -> ast::Node* {
+    const auto sourceLength = static_cast<ast::Declaration*>(declaration)->sourceLength();
+
+    errors.clear();
+
+    auto result = Parser::parseDeclarationAt(
+      text->data(), text->size(), declaration->offset(),
+      sourceLength - length + textLength,
+      m_context->names(), unit->arena(), &errors);
+
+    // A declaration that turns into a module or the other way around
+    // changes the structure of the unit.
+    if(nullptr == result || isModule != (ast::NodeKind::kModule == result->kind())) {
+      return nullptr;
+    }
+
+    return result;
+  };
+
+  // An edit that is not within a single declaration of a module, or
+  // that does not leave a single declaration, reparses the module.
+  auto nodes = module->declarations();
+  auto index = indexOfRange(nodes, offset, length);
+  ast::Node* node = -1 == index ? nullptr : parse(nodes->nodes()[index], NO);
+
+  if(nullptr == node) {
+    nodes = modules;
+    index = moduleIndex;
+    node = parse(module, YES);
+  }
+
+  if(nullptr == node) {
+    return NO;
+  }
+
+  const bool isModule = nodes == modules;
+  auto declaration = static_cast<ast::Declaration*>(nodes->nodes()[index]);
+  const size_t start = declaration->sourceOffset();
+  const size_t end = start + declaration->sourceLength();
+  const auto delta = static_cast<int64_t>(textLength) - static_cast<int64_t>(length);
+
+  // Diagnostics of the old declaration are replaced by those of the
+  // new one.
+  unit->diagnostics()->replace(
+    static_cast<uint32_t>(start), static_cast<uint32_t>(end), delta);
+
+  for(int i = 0; i < errors.size(); ++i) {
+    auto& error = errors.at(i);
+    unit->diagnostics()->report(error.m_code, error.m_offset, error.m_args[0], error.m_args[1]);
+  }
+
+  auto symbol = declaration->symbol();
+
+  if(nullptr != symbol) {
+    if(isModule) {
+      m_context->symbols()->global()->remove(symbol);
+    } else {
+      module->symbol()->scope()->remove(symbol);
+    }
+
+    m_context->symbols()->invalidate();
+  }
+
+  nodes->set(index, node);
+
+  // Nodes that follow the edit move by the difference in length. The
+  // nodes of a module that contains the edit are moved one by one.
+  auto moveAfterEdit = [&](ast::Node* node) {
+    if(node->offset() >= end) {
+      move(node, delta);
+    }
+  };
+
+  foreachModule(unit->ast(), [&](ast::Module* candidate) {
+    if(candidate == node) {
+      return;
+    } else if(candidate->offset() >= end) {
+      move(candidate, delta);
+    } else {
+      candidate->declarations()->foreach(moveAfterEdit);
+      candidate->dependencies()->foreach(moveAfterEdit);
+    }
+  });
+
+  // The range of a module grows or shrinks with its declarations.
+  if(!isModule && hasSourceRange(module)) {
+    module->sourceRange(
+      module->sourceOffset(), static_cast<uint32_t>(module->sourceLength() + delta));
+  }
+
+  if(isModule) {
+    m_symbols->buildModuleSymbols(unit, static_cast<ast::Module*>(node));
+  } else {
+    m_symbols->buildDeclarationSymbols(unit, node, module);
+  }
+
+  // The new symbols replace those of the declaration and of everything
+  // nested in it, so the unit and the units that use its module are
+  // linked again. A module that changes its name may hide any name.
+  List<NameId> names;
+  bool isGlobal = NO;
+
+  if(isModule) {
+    auto replacement = node->symbol();
+
+    if(nullptr != symbol) {
+      names.addLast(symbol->name());
+    }
+
+    if(-1 == names.indexOf(replacement->name())) {
+      names.addLast(replacement->name());
+      isGlobal = YES;
+    }
+  } else {
+    names.addLast(module->symbol()->name());
+  }
+
+  relink(unit, &names, isGlobal);
+
+  return YES;
+}
+
+void IncrementalParser::rebuild(CompilationUnit* unit) {
+  TRACE_SCOPE("incremental", "rebuild");
+  List<NameId> modules;
+
+  moduleNames(unit, &modules);
+
+  const auto numModules = modules.size();
+
+  discard(unit);
+  parse(unit);
+  m_symbols->apply(unit);
+  moduleNames(unit, &modules);
+
+  // A new module may hide any name another unit refers to and every
+  // unit is linked against the dependencies, like the type of a number
+  // literal.
+  relink(unit, &modules, unit->isDependency() || modules.size() != numModules);
+}
+
+void IncrementalParser::relink(CompilationUnit* unit, List<NameId>* modules, bool isGlobal) {
+  auto isAffected = [&](CompilationUnit* other) {
+    return isGlobal || other->uses()->exists([&](NameId name) {
+      return -1 != modules->indexOf(name);
+    });
+  };
+
+  // Units restored from the build cache have no AST that could be
+  // linked again so they are compiled from their text. This replaces
+  // the symbols of their modules as well, so the units that use those
+  // are affected too.
+  List<CompilationUnit*> parsed;
+  bool isChanged;
+
+  do {
+    isChanged = NO;
+
+    m_units->foreach([&](CompilationUnit* other) {
+      if(other != unit && other->isRestored() && isAffected(other)) {
+        moduleNames(other, modules);
+        discard(other);
+        parse(other);
+        m_symbols->apply(other);
+        parsed.addLast(other);
+        isChanged = YES;
+      }
+    });
+  } while(isChanged);
+
+  // Several units may declare a module of the same name. The first of
+  // them is the one in the global scope, like in a compile of all
+  // units, even if another one has been entered in the meantime.
+  auto global = m_context->symbols()->global();
+
+  modules->foreach([&](NameId name) {
+    auto current = global->getLocal(name);
+    syms::Symbol* first = nullptr;
+    bool isDeclared = NO;
+
+    m_units->foreach([&](CompilationUnit* other) {
+      foreachModuleSymbol(other, [&](syms::Symbol* module) {
+        if(module->name() == name) {
+          first = nullptr == first ? module : first;
+          isDeclared = isDeclared || module == current;
+        }
+      });
+    });
+
+    // A module of an image is never replaced.
+    if(nullptr == first || current == first || (nullptr != current && !isDeclared)) {
+      return;
+    }
+
+    if(nullptr != current) {
+      global->remove(current);
+    }
+
+    global->put(first);
+    m_context->symbols()->invalidate();
+  });
+
+  // Whether a unit is affected depends on what it used before it is
+  // linked again.
+  List<CompilationUnit*> linked;
+
+  m_units->foreach([&](CompilationUnit* other) {
+    if(other != unit && nullptr != other->ast() && (-1 != parsed.indexOf(other) || isAffected(other))) {
+      linked.addLast(other);
+    }
+  });
+
+  m_link->apply(unit);
+
+  linked.foreach([&](CompilationUnit* other) {
+    m_link->apply(other);
+  });
+}
+
+void IncrementalParser::parse(CompilationUnit* unit) {
+  auto text = unit->text();
+  MemoryCharStream stream(text->data(), text->size());
+  Lexer lexer;
+  Parser parser(&lexer, m_context->names(), unit->arena());
+
+  unit->diagnostics()->clear();
+  parser.diagnostics(unit->diagnostics());
+  lexer.init(&stream);
+  unit->ast(parser.parseProgram());
+}
+
+void IncrementalParser::discard(CompilationUnit* unit) {
+  auto global = m_context->symbols()->global();
+
+  if(nullptr != unit->ast()) {
+    foreachModule(unit->ast(), [&](ast::Module* module) {
+      if(nullptr != module->symbol()) {
+        global->remove(module->symbol());
+      }
+    });
+
+    m_context->symbols()->invalidate();
+  } else if(unit->isRestored()) {
+    unit->modules()->foreach([&](syms::Symbol* module) {
+      global->remove(module);
+    });
+
+    m_context->symbols()->invalidate();
+  }
+
+  unit->discard();
+}
+} //namespace internal
+} //namespace brutus
@@ -0,0 +1,75 @@
+#ifndef BRUTUS_INCREMENTAL_H_
+#define BRUTUS_INCREMENTAL_H_
+
+#include "brutus.h"
+#include "ast.h"
+#include "list.h"
+#include "phases.h"
+
+namespace brutus {
+  class CompilationUnit;
+  class Context;
+
+  namespace internal {
+    enum class EditResult {
+      kInvalid,      // the edit has not been applied
+      kDeclaration,  // a single declaration or module has been reparsed
+      kUnit          // the whole unit has been reparsed
+    }; //enum EditResult
+
+    // Applies edits to the text of a compiled unit and brings its AST
+    // and symbols up to date.
+    //
+    // The parser records the source range of every module and of its
+    // declarations. An edit that lies within one declaration of a
+    // module only reparses that declaration and replaces its symbol in
+    // the scope of the module. An edit elsewhere within a module
+    // reparses the module. Everything else falls back to reparsing the
+    // whole unit.
+    //
+    // The unit and the units that use the module are linked again
+    // since they may refer to the replaced symbols or to those nested
+    // in them. A replaced declaration stays in the arena of its unit
+    // until the unit is rebuilt.
+    class IncrementalParser {
+      public:
+        explicit IncrementalParser(
+          Context* context, List<CompilationUnit*>* units,
+          SymbolsPhase* symbols, LinkPhase* link);
+
+        // Replaces length characters of the text of the unit at the
+        // given offset with textLength characters of text.
+        EditResult edit(
+          CompilationUnit* unit, size_t offset, size_t length,
+          const char* text, size_t textLength);
+
+        // Discards the memory of the unit and compiles it again from
+        // its text. Other units are linked again if they use one of its
+        // modules since they may refer to its old symbols.
+        void rebuild(CompilationUnit* unit);
+
+        // Removes the modules of the unit from the global scope and
+        // frees its AST and symbols. Other units must not refer to
+        // them anymore.
+        void discard(CompilationUnit* unit);
+
+      private:
+        Context* const m_context;
+        List<CompilationUnit*>* const m_units;
+        SymbolsPhase* const m_symbols;
+        LinkPhase* const m_link;
+
+        // Parses the whole text of the unit.
+        void parse(CompilationUnit* unit);
+
+        // Links the unit again along with the other units that use one
+        // of the given modules, or all of them if the change is global.
+        void relink(CompilationUnit* unit, List<NameId>* modules, bool isGlobal);
+
+        bool reparseDeclaration(CompilationUnit* unit, size_t offset, size_t length, size_t textLength);
+
+        DISALLOW_COPY_AND_ASSIGN(IncrementalParser);
+    }; //class IncrementalParser
+  } //namespace internal
+} //namespace brutus
+#endif
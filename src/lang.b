@@ -1,106 +1,109 @@
 module brutus { 
   class Atom[T] {
-    virtual def hashCode: Int32
-    virtual def toString: String
+    virtual def hashCode(): Int32
+    virtual def toString(): String
   }
   
-  immutable class Unit extends Atom[T] {
-    override def hashCode = -1
-    override def toString = "()"
+  immutable class Unit {
+    def hashCode(): Int32 = 0
+    def toString(): String = "()"
   }
 
   immutable class Int8 {
-    native def hashCode
-    native def toString
-    native def ~: Int8
-
-    native def +(that: Int8): Int8
-    native def -(that: Int8): Int8
-    native def *(that: Int8): Int8
-    native def /(that: Int8): Int8
-    native def %(that: Int8): Int8
-    native def &(that: Int8): Int8
-    native def |(that: Int8): Int8
-    native def ^(that: Int8): Int8
-    native def >>(that: Int8): Int8
-    native def <<(that: Int8): Int8
-
-    native def +(that: Int16): Int16
-    native def -(that: Int16): Int16
-    native def *(that: Int16): Int16
-    native def /(that: Int16): Int16
-    native def %(that: Int16): Int16
-    native def &(that: Int16): Int16
-    native def |(that: Int16): Int16
-    native def ^(that: Int16): Int16
-    native def >>(that: Int16): Int16
-    native def <<(that: Int16): Int16
-
-    native def +(that: Int32): Int32
-    native def -(that: Int32): Int32
-    native def *(that: Int32): Int32
-    native def /(that: Int32): Int32
-    native def %(that: Int32): Int32
-    native def &(that: Int32): Int32
-    native def |(that: Int32): Int32
-    native def ^(that: Int32): Int32
-    native def >>(that: Int32): Int32
-    native def <<(that: Int32): Int32
-
-    native def +(that: Int64): Int64
-    native def -(that: Int64): Int64
-    native def *(that: Int64): Int64
-    native def /(that: Int64): Int64
-    native def %(that: Int64): Int64
-    native def &(that: Int64): Int64
-    native def |(that: Int64): Int64
-    native def ^(that: Int64): Int64
-    native def >>(that: Int64): Int64
-    native def <<(that: Int64): Int64
-
-    native def +(that: UInt8): Int8
-    native def -(that: UInt8): Int8
-    native def *(that: UInt8): Int8
-    native def /(that: UInt8): Int8
-    native def %(that: UInt8): Int8
-    native def &(that: UInt8): Int8
-    native def |(that: UInt8): Int8
-    native def ^(that: UInt8): Int8
-    native def >>(that: UInt8): Int8
-    native def <<(that: UInt8): Int8
-
-    native def +(that: UInt16): Int16
-    native def -(that: UInt16): Int16
-    native def *(that: UInt16): Int16
-    native def /(that: UInt16): Int16
-    native def %(that: UInt16): Int16
-    native def &(that: UInt16): Int16
-    native def |(that: UInt16): Int16
-    native def ^(that: UInt16): Int16
-    native def >>(that: UInt16): Int16
-    native def <<(that: UInt16): Int16
-
-    native def +(that: UInt32): Int32
-    native def -(that: UInt32): Int32
-    native def *(that: UInt32): Int32
-    native def /(that: UInt32): Int32
-    native def %(that: UInt32): Int32
-    native def &(that: UInt32): Int32
-    native def |(that: UInt32): Int32
-    native def ^(that: UInt32): Int32
-    native def >>(that: UInt32): Int32
-    native def <<(that: UInt32): Int32
-
-    native def +(that: UInt64): Int64
-    native def -(that: UInt64): Int64
-    native def *(that: UInt64): Int64
-    native def /(that: UInt64): Int64
-    native def %(that: UInt64): Int64
-    native def &(that: UInt64): Int64
-    native def |(that: UInt64): Int64
-    native def ^(that: UInt64): Int64
-    native def >>(that: UInt64): Int64
-    native def <<(that: UInt64): Int64
+    public native def hashCode(): Int32
+    public native def toString(): String
+    public native def ~(): Int8
+
+    public native def +(that: Int8): Int8
+    public native def -(that: Int8): Int8
+    public native def *(that: Int8): Int8
+    public native def /(that: Int8): Int8
+    public native def %(that: Int8): Int8
+    public native def &(that: Int8): Int8
+    public native def |(that: Int8): Int8
+    public native def ^(that: Int8): Int8
+    public native def >>(that: Int8): Int8
+    public native def <<(that: Int8): Int8
+
+    public native def +(that: Int16): Int16
+    public native def -(that: Int16): Int16
+    public native def *(that: Int16): Int16
+    public native def /(that: Int16): Int16
+    public native def %(that: Int16): Int16
+    public native def &(that: Int16): Int16
+    public native def |(that: Int16): Int16
+    public native def ^(that: Int16): Int16
+    public native def >>(that: Int16): Int16
+    public native def <<(that: Int16): Int16
+
+    public native def +(that: Int32): Int32
+    public native def -(that: Int32): Int32
+    public native def *(that: Int32): Int32
+    public native def /(that: Int32): Int32
+    public native def %(that: Int32): Int32
+    public native def &(that: Int32): Int32
+    public native def |(that: Int32): Int32
+    public native def ^(that: Int32): Int32
+    public native def >>(that: Int32): Int32
+    public native def <<(that: Int32): Int32
+
+    public native def +(that: Int64): Int64
+    public native def -(that: Int64): Int64
+    public native def *(that: Int64): Int64
+    public native def /(that: Int64): Int64
+    public native def %(that: Int64): Int64
+    public native def &(that: Int64): Int64
+    public native def |(that: Int64): Int64
+    public native def ^(that: Int64): Int64
+    public native def >>(that: Int64): Int64
+    public native def <<(that: Int64): Int64
+
+    public native def +(that: UInt8): Int8
+    public native def -(that: UInt8): Int8
+    public native def *(that: UInt8): Int8
+    public native def /(that: UInt8): Int8
+    public native def %(that: UInt8): Int8
+    public native def &(that: UInt8): Int8
+    public native def |(that: UInt8): Int8
+    public native def ^(that: UInt8): Int8
+    public native def >>(that: UInt8): Int8
+    public native def <<(that: UInt8): Int8
+
+    public native def +(that: UInt16): Int16
+    public native def -(that: UInt16): Int16
+    public native def *(that: UInt16): Int16
+    public native def /(that: UInt16): Int16
+    public native def %(that: UInt16): Int16
+    public native def &(that: UInt16): Int16
+    public native def |(that: UInt16): Int16
+    public native def ^(that: UInt16): Int16
+    public native def >>(that: UInt16): Int16
+    public native def <<(that: UInt16): Int16
+
+    public native def +(that: UInt32): Int32
+    public native def -(that: UInt32): Int32
+    public native def *(that: UInt32): Int32
+    public native def /(that: UInt32): Int32
+    public native def %(that: UInt32): Int32
+    public native def &(that: UInt32): Int32
+    public native def |(that: UInt32): Int32
+    public native def ^(that: UInt32): Int32
+    public native def >>(that: UInt32): Int32
+    public native def <<(that: UInt32): Int32
+
+    public native def +(that: UInt64): Int64
+    public native def -(that: UInt64): Int64
+    public native def *(that: UInt64): Int64
+    public native def /(that: UInt64): Int64
+    public native def %(that: UInt64): Int64
+    public native def &(that: UInt64): Int64
+    public native def |(that: UInt64): Int64
+    public native def ^(that: UInt64): Int64
+    public native def >>(that: UInt64): Int64
+    public native def <<(that: UInt64): Int64
+  }
+
+  class Int {
   }
 
   class Int16 {
@@ -146,9 +149,9 @@ module brutus {
   }
 
   class Array[T] {
-    native def apply(index: Int): T
-    native def update(index: Int, value: T): Unit
-    native def slice(offset: Int, count: Int): Array[T]
+    public native def apply(index: Int): T
+    public native def update(index: Int, value: T): Unit
+    public native def slice(offset: Int, count: Int): Array[T]
   }
 
   class String {
@@ -303,9 +303,15 @@ Lexer::Lexer() {
 }
 
 void Lexer::init(CharStream* charStream)  {
+  init(charStream, 0);
+}
+
+void Lexer::init(CharStream* charStream, size_t offset) {
   m_stream = charStream;
   m_line = 0;
-  m_column = 0;
+  m_lineOffset = offset;
+  m_offset = offset;
+  m_tokenOffset = offset;
   m_currentChar = '\0';
   m_advanceWithLastChar = false;
   resetBuffer();
@@ -332,6 +338,8 @@ Token Lexer::resulting(
 }
 
 Token Lexer::nextToken() {
+  m_tokenOffset = m_offset;
+
   while(canAdvance()) {
     auto currentChar = advance();
 
@@ -356,13 +364,13 @@ Token Lexer::nextToken() {
       // It is important to note the side effect which resets the
       // position information.
       ++m_line;
-      m_column = 0;
+      m_lineOffset = m_offset;
 
       return resulting(
         [&](const char c) { return isNewLine(c); },
         [&](const char) -> bool {
           ++m_line;
-          m_column = 0;
+          m_lineOffset = m_offset;
 
           return YES;
         },
@@ -429,7 +437,11 @@ unsigned int Lexer::posLine() {
 }
 
 unsigned int Lexer::posColumn() {
-  return m_column;
+  return static_cast<unsigned int>(m_tokenOffset - m_lineOffset);
+}
+
+size_t Lexer::posOffset() {
+  return m_tokenOffset;
 }
 
 bool Lexer::canAdvance() {
@@ -447,7 +459,7 @@ char Lexer::advance() {
     m_currentChar = m_stream->next();
   }
 
-  ++m_column;
+  ++m_offset;
 
   return m_currentChar;
 }
@@ -460,7 +472,7 @@ void Lexer::rewind() {
 #endif
 
   m_advanceWithLastChar = YES;
-  --m_column;
+  --m_offset;
 }
 
 bool Lexer::isWhitespace(const char c) {
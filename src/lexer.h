@@ -76,17 +76,28 @@ namespace brutus {
       public:
         explicit Lexer();
         void init(CharStream* charStream);
+
+        // Initializes the lexer for a stream that starts at the given
+        // offset of a larger source, like the body of a function.
+        void init(CharStream* charStream, size_t offset);
         Token nextToken();
         char* value();
         size_t valueLength();
+
+        // Line and column of the last token. Lines are counted from the
+        // start of the stream and only updated at line breaks.
         unsigned int posLine();
         unsigned int posColumn();
 
+        // Byte offset of the first character of the last token.
+        size_t posOffset();
+
       private:
         static const size_t BUFFER_SIZE = 0x1000;
 
         CharStream* m_stream;
-        unsigned int m_line, m_column;
+        unsigned int m_line;
+        size_t m_lineOffset, m_offset, m_tokenOffset;
         char m_currentChar;
         bool m_advanceWithLastChar;
 
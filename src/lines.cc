@@ -0,0 +1,53 @@
+#include "lines.h"
+
+namespace brutus {
+namespace internal {
+void LineTable::build() {
+  const auto data = m_text->data();
+  const auto size = m_text->size();
+  uint32_t start = 0;
+
+  m_starts.clear();
+  m_starts.append(start);
+
+  for(size_t i = 0; i < size; ++i) {
+    if('\n' == data[i]) {
+      start = static_cast<uint32_t>(i + 1);
+      m_starts.append(start);
+    }
+  }
+
+  m_isBuilt = YES;
+}
+
+uint32_t LineTable::numLines() {
+  if(!m_isBuilt) {
+    build();
+  }
+
+  return static_cast<uint32_t>(m_starts.size() / sizeof(uint32_t)); //NOLINT
+}
+
+void LineTable::position(size_t offset, uint32_t* line, uint32_t* column) {
+  const auto n = numLines();
+  const auto starts = m_starts.at<uint32_t>(0);
+
+  // The last line that starts at or before the offset.
+  uint32_t low = 0;
+  uint32_t high = n;
+
+  while(high - low > 1) {
+    const auto middle = low + (high - low) / 2;
+
+    if(starts[middle] <= offset) {
+      low = middle;
+    } else {
+      high = middle;
+    }
+  }
+
+  *line = low;
+  *column = static_cast<uint32_t>(offset - starts[low]);
+}
+} //namespace internal
+} //namespace brutus
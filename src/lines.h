@@ -0,0 +1,43 @@
+#ifndef BRUTUS_LINES_H_
+#define BRUTUS_LINES_H_
+
+#include "brutus.h"
+#include "buffer.h"
+
+namespace brutus {
+  namespace internal {
+    // Maps offsets into the text of a unit to lines and columns.
+    //
+    // Nodes only keep the offset of their first character. The start
+    // of every line is found the first time a position is needed,
+    // which is usually when a diagnostic is printed, and every lookup
+    // after that is a binary search.
+    class LineTable {
+      public:
+        explicit LineTable(const ByteBuffer* text)
+            : m_text(text),
+              m_isBuilt(NO) {}
+
+        // Zero-based line and column of the character at the offset.
+        void position(size_t offset, uint32_t* line, uint32_t* column);
+
+        uint32_t numLines();
+
+        // Forgets all lines. Must be called when the text changes.
+        ALWAYS_INLINE void reset() {
+          m_starts.clear();
+          m_isBuilt = NO;
+        }
+
+      private:
+        const ByteBuffer* const m_text;
+        ByteBuffer m_starts;
+        bool m_isBuilt;
+
+        void build();
+
+        DISALLOW_COPY_AND_ASSIGN(LineTable);
+    }; //class LineTable
+  } //namespace internal
+} //namespace brutus
+#endif
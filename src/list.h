@@ -21,7 +21,7 @@ namespace brutus {
       };
 
     public:
-      List() : List(internal::HeapAllocator::instance()) {}
+      List() : List(&internal::HeapAllocator::instance()) {}
       List(internal::Allocator* allocator)
           : m_first(nullptr),
             m_last(nullptr),
@@ -116,6 +116,8 @@ namespace brutus {
 
         if(nullptr != newFirst) {
           newFirst->m_prev = nullptr;
+        } else {
+          m_last = nullptr;
         }
 
         m_alloc->free(oldFirst);
@@ -133,6 +135,8 @@ namespace brutus {
 
         if(nullptr != newLast) {
           newLast->m_next = nullptr;
+        } else {
+          m_first = nullptr;
         }
 
         m_alloc->free(oldLast);
@@ -156,6 +160,8 @@ namespace brutus {
           if(!f(entry->m_value)) {
             return NO;
           }
+
+          entry = entry->m_next;
         }
 
         return YES;
@@ -168,6 +174,8 @@ namespace brutus {
           if(f(entry->m_value)) {
             return YES;
           }
+
+          entry = entry->m_next;
         }
 
         return NO;
@@ -187,9 +195,10 @@ namespace brutus {
         auto entry = m_first->m_next;
 
         while(nullptr != entry) {
+          auto next = entry->m_next;
+
           if(entry->m_value == value) {
             auto prev = entry->m_prev;
-            auto next = entry->m_next;
 
             prev->m_next = next;
             next->m_prev = prev;
@@ -198,7 +207,7 @@ namespace brutus {
             --m_size;
           }
 
-          entry = entry->m_next;
+          entry = next;
         }
       }
 
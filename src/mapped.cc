@@ -0,0 +1,112 @@
+#include "mapped.h"
+
+#ifndef OS_WINDOWS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstdio>
+
+#include "alloc.h"
+
+namespace brutus {
+namespace internal {
+#ifndef OS_WINDOWS
+bool MappedFile::open(const char* path) {
+  close();
+
+  auto fd = ::open(path, O_RDONLY);
+
+  if(fd < 0) {
+    return NO;
+  }
+
+  struct stat info;
+
+  if(0 != fstat(fd, &info) || info.st_size <= 0) {
+    ::close(fd);
+    return NO;
+  }
+
+  auto size = static_cast<size_t>(info.st_size);
+  auto data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  // The mapping stays valid after the descriptor has been closed.
+  ::close(fd);
+
+  if(MAP_FAILED == data) {
+    return NO;
+  }
+
+  m_data = reinterpret_cast<const char*>(data);
+  m_size = size;
+  m_isMapped = YES;
+
+  return YES;
+}
+
+void MappedFile::close() {
+  if(nullptr == m_data) {
+    return;
+  }
+
+  if(m_isMapped) {
+    munmap(const_cast<char*>(m_data), m_size);
+  } else {
+    Malloc::Delete(const_cast<char*>(m_data));
+  }
+
+  m_data = nullptr;
+  m_size = 0;
+  m_isMapped = NO;
+}
+#else
+bool MappedFile::open(const char* path) {
+  close();
+
+  auto fp = fopen(path, "rb");
+
+  if(!fp) {
+    return NO;
+  }
+
+  fseek(fp, 0, SEEK_END);
+  auto size = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+
+  if(size <= 0) {
+    fclose(fp);
+    return NO;
+  }
+
+  auto data = reinterpret_cast<char*>(Malloc::New(size));
+  auto numRead = fread(data, kCharSize, size, fp);
+
+  fclose(fp);
+
+  if(numRead != static_cast<size_t>(size)) {
+    Malloc::Delete(data);
+    return NO;
+  }
+
+  m_data = data;
+  m_size = static_cast<size_t>(size);
+  m_isMapped = NO;
+
+  return YES;
+}
+
+void MappedFile::close() {
+  if(nullptr != m_data) {
+    Malloc::Delete(const_cast<char*>(m_data));
+  }
+
+  m_data = nullptr;
+  m_size = 0;
+  m_isMapped = NO;
+}
+#endif
+} //namespace internal
+} //namespace brutus
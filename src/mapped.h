@@ -0,0 +1,48 @@
+#ifndef BRUTUS_MAPPED_H_
+#define BRUTUS_MAPPED_H_
+
+#include "brutus.h"
+
+namespace brutus {
+  namespace internal {
+    // A read-only view of a whole file.
+    //
+    // On POSIX systems the file is mapped into memory. Other systems
+    // fall back to reading the file into a heap buffer so the contents
+    // are always available through data() and size().
+    class MappedFile {
+      public:
+        explicit MappedFile()
+            : m_data(nullptr),
+              m_size(0),
+              m_isMapped(NO) {}
+
+        ~MappedFile() {
+          close();
+        }
+
+        bool open(const char* path);
+        void close();
+
+        ALWAYS_INLINE const char* data() const {
+          return m_data;
+        }
+
+        ALWAYS_INLINE size_t size() const {
+          return m_size;
+        }
+
+        ALWAYS_INLINE bool isOpen() const {
+          return nullptr != m_data;
+        }
+
+      private:
+        const char* m_data;
+        size_t m_size;
+        bool m_isMapped;
+
+        DISALLOW_COPY_AND_ASSIGN(MappedFile);
+    }; //class MappedFile
+  } //namespace internal
+} //namespace brutus
+#endif
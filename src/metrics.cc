@@ -0,0 +1,367 @@
+#ifndef OS_WINDOWS
+#include <sys/resource.h>
+#include <time.h>
+#endif
+
+#include <ctime>
+#include <iomanip>
+
+#include "metrics.h"
+#include "compiler.h"
+#include "name.h"
+#include "symbols.h"
+#include "visitor.h"
+
+namespace brutus {
+namespace internal {
+#define METRIC_NAME(x, name) name,
+static const char* const kPhaseNames[] = {
+  METRIC_PHASES(METRIC_NAME)
+};
+
+static const char* const kCounterNames[] = {
+  METRIC_COUNTERS(METRIC_NAME)
+};
+#undef METRIC_NAME
+
+#define NODE_KIND_NAME(x) #x,
+static const char* const kNodeKindNames[] = {
+  AST_NODE_KINDS(NODE_KIND_NAME)
+};
+#undef NODE_KIND_NAME
+
+ALWAYS_INLINE static Stopwatch::Rep cpuNS(int clock) {
+#ifndef OS_WINDOWS
+  struct timespec time;
+
+  if(0 == clock_gettime(clock, &time)) {
+    return static_cast<Stopwatch::Rep>(time.tv_sec) * 1000000000ULL +
+      static_cast<Stopwatch::Rep>(time.tv_nsec);
+  }
+#else
+  UNUSED(clock);
+#endif
+
+  return static_cast<Stopwatch::Rep>(std::clock()) * (1000000000ULL / CLOCKS_PER_SEC);
+}
+
+Stopwatch::Rep Timing::threadCpuNS() {
+#ifndef OS_WINDOWS
+  return cpuNS(CLOCK_THREAD_CPUTIME_ID);
+#else
+  return cpuNS(0);
+#endif
+}
+
+Stopwatch::Rep Timing::processCpuNS() {
+#ifndef OS_WINDOWS
+  return cpuNS(CLOCK_PROCESS_CPUTIME_ID);
+#else
+  return cpuNS(0);
+#endif
+}
+
+//
+
+void UnitMetrics::reset() {
+  for(int i = 0; i < kNumMetricPhases; ++i) {
+    m_phases[i] = Timing();
+  }
+
+  ArrayFill(m_counters, 0, kNumCounters);
+  ArrayFill(m_nodes, 0, kNumNodeKinds);
+}
+
+void UnitMetrics::time(MetricPhase phase, std::function<void()> f) { //NOLINT
+  Stopwatch stopwatch;
+  Timing timing;
+  const auto cpuStart = Timing::threadCpuNS();
+
+  stopwatch.start();
+  f();
+  stopwatch.stop();
+
+  timing.m_wallNS = stopwatch.totalNS();
+  timing.m_cpuNS = Timing::threadCpuNS() - cpuStart;
+
+  m_phases[static_cast<int>(phase)].add(timing);
+}
+
+void UnitMetrics::collect(CompilationUnit* unit) {
+  m_counters[static_cast<int>(Counter::kNodes)] = 0;
+  m_counters[static_cast<int>(Counter::kScopes)] = 0;
+  m_counters[static_cast<int>(Counter::kSymbols)] = 0;
+  ArrayFill(m_nodes, 0, kNumNodeKinds);
+
+  if(nullptr != unit->ast()) {
+    count(unit->ast());
+  }
+
+  m_counters[static_cast<int>(Counter::kArenaBytes)] = unit->arena()->totalBytes();
+}
+
+void UnitMetrics::count(ast::Node* node) {
+  ++m_nodes[static_cast<int>(node->kind())];
+  add(Counter::kNodes, 1);
+
+  // Every symbol the SymbolsPhase creates belongs to the node that
+  // declares it. A resolved reference points to the symbol of its
+  // declaration instead.
+  auto symbol = node->symbol();
+
+  if(nullptr != symbol && symbol->ast() == node) {
+    add(Counter::kSymbols, 1);
+
+    if(nullptr != symbol->scope()) {
+      add(Counter::kScopes, 1);
+    }
+  }
+
+  if(ast::NodeKind::kBlock == node->kind() && nullptr != static_cast<ast::Block*>(node)->scope()) {
+    add(Counter::kScopes, 1);
+  }
+
+  ast::forEachChild(node, [this](ast::Node* child) {
+    count(child);
+  });
+}
+
+//
+
+Metrics::Metrics(List<CompilationUnit*>* units, NameTable* names, Arena* arena, int numWorkers)
+    : m_units(units),
+      m_names(names),
+      m_arena(arena),
+      m_numWorkers(numWorkers),
+      m_numNames(0),
+      m_isCollected(YES),
+      m_cpuStart(0),
+      m_namesStart(0) {}
+
+void Metrics::begin() {
+  m_units->foreach([](CompilationUnit* unit) {
+    unit->metrics()->reset();
+  });
+
+  m_namesStart = m_names->size();
+  m_cpuStart = Timing::processCpuNS();
+  m_stopwatch.start();
+}
+
+void Metrics::end() {
+  m_stopwatch.stop();
+
+  m_compile.m_wallNS = m_stopwatch.totalNS();
+  m_compile.m_cpuNS = Timing::processCpuNS() - m_cpuStart;
+  m_numNames = m_names->size() - m_namesStart;
+  m_isCollected = NO;
+}
+
+void Metrics::collect() {
+  if(m_isCollected) {
+    return;
+  }
+
+  m_units->foreach([](CompilationUnit* unit) {
+    unit->metrics()->collect(unit);
+  });
+
+  m_isCollected = YES;
+}
+
+Timing Metrics::phase(MetricPhase phase) {
+  Timing result;
+
+  m_units->foreach([&](CompilationUnit* unit) {
+    result.add(unit->metrics()->phase(phase));
+  });
+
+  return result;
+}
+
+int64_t Metrics::counter(Counter counter) {
+  int64_t result = 0;
+
+  collect();
+  m_units->foreach([&](CompilationUnit* unit) {
+    result += unit->metrics()->counter(counter);
+  });
+
+  return result;
+}
+
+int64_t Metrics::numNodes(ast::NodeKind kind) {
+  int64_t result = 0;
+
+  collect();
+  m_units->foreach([&](CompilationUnit* unit) {
+    result += unit->metrics()->numNodes(kind);
+  });
+
+  return result;
+}
+
+const char* Metrics::nameOf(MetricPhase phase) {
+  return kPhaseNames[static_cast<int>(phase)];
+}
+
+const char* Metrics::nameOf(Counter counter) {
+  return kCounterNames[static_cast<int>(counter)];
+}
+
+static void printTiming(std::ostream& output, const char* name, const Timing& timing) {
+  output
+    << std::left << std::setw(10) << name << std::right
+    << std::setw(12) << timing.m_wallNS / 1000000.0
+    << std::setw(12) << timing.m_cpuNS / 1000000.0
+    << std::endl;
+}
+
+void Metrics::print(std::ostream& output) {
+  const auto flags = output.flags();
+  const auto precision = output.precision();
+
+  output << std::fixed << std::setprecision(3);
+  output
+    << std::left << std::setw(10) << "phase" << std::right
+    << std::setw(12) << "wall ms" << std::setw(12) << "cpu ms" << std::endl;
+
+  for(int i = 0; i < kNumMetricPhases; ++i) {
+    printTiming(output, kPhaseNames[i], phase(static_cast<MetricPhase>(i)));
+  }
+
+  printTiming(output, "total", m_compile);
+
+  output << "units " << m_units->size() << ", workers " << m_numWorkers << ", names " << m_numNames;
+
+  for(int i = 0; i < kNumCounters; ++i) {
+    output << ", " << kCounterNames[i] << ' ' << counter(static_cast<Counter>(i));
+  }
+
+  output << std::endl;
+  output.flags(flags);
+  output.precision(precision);
+}
+
+int64_t Metrics::peakResidentBytes() {
+#ifndef OS_WINDOWS
+  struct rusage usage;
+
+  if(0 == getrusage(RUSAGE_SELF, &usage)) {
+#ifdef OS_LINUX
+    return static_cast<int64_t>(usage.ru_maxrss) * 1024;
+#else
+    return static_cast<int64_t>(usage.ru_maxrss);
+#endif
+  }
+#endif
+
+  return 0;
+}
+
+static void printBytes(std::ostream& output, const char* name, int64_t bytes) {
+  output
+    << std::left << std::setw(10) << name << std::right
+    << std::setw(12) << bytes / 1024
+    << std::endl;
+}
+
+void Metrics::printMemory(std::ostream& output) {
+  int64_t unitBytes = 0;
+
+  m_units->foreach([&](CompilationUnit* unit) {
+    unitBytes += unit->arena()->totalBytes() + static_cast<int64_t>(unit->text()->size());
+  });
+
+  output << std::left << std::setw(10) << "memory" << std::right << std::setw(12) << "KiB" << std::endl;
+  printBytes(output, "units", unitBytes);
+  printBytes(output, "shared", m_arena->totalBytes());
+  printBytes(output, "names", m_names->poolSize());
+
+  const auto peak = peakResidentBytes();
+
+  if(0 != peak) {
+    printBytes(output, "peak rss", peak);
+  }
+
+  output << "units " << m_units->size() << ", names " << m_names->size() << std::endl;
+}
+
+static void writeTiming(std::ostream& output, const char* name, const Timing& timing) {
+  output << '"' << name << "\": {\"wall\": " << timing.m_wallNS << ", \"cpu\": " << timing.m_cpuNS << '}';
+}
+
+static void writePhases(std::ostream& output, std::function<Timing(MetricPhase)> phase) { //NOLINT
+  output << '{';
+
+  for(int i = 0; i < kNumMetricPhases; ++i) {
+    output << (0 == i ? "" : ", ");
+    writeTiming(output, kPhaseNames[i], phase(static_cast<MetricPhase>(i)));
+  }
+
+  output << '}';
+}
+
+static void writeCounters(std::ostream& output, std::function<int64_t(Counter)> counter) { //NOLINT
+  output << '{';
+
+  for(int i = 0; i < kNumCounters; ++i) {
+    output << (0 == i ? "" : ", ") << '"' << kCounterNames[i] << "\": " << counter(static_cast<Counter>(i));
+  }
+
+  output << '}';
+}
+
+void Metrics::writeJson(std::ostream& output) {
+  collect();
+
+  output << '{' << std::endl;
+  output << "  \"unit\": \"ns\"," << std::endl;
+  output << "  \"units\": " << m_units->size() << ',' << std::endl;
+  output << "  \"workers\": " << m_numWorkers << ',' << std::endl;
+  output << "  \"names\": " << m_numNames << ',' << std::endl;
+  output << "  ";
+  writeTiming(output, "compile", m_compile);
+  output << ',' << std::endl;
+
+  output << "  \"phases\": ";
+  writePhases(output, [this](MetricPhase phase) { return this->phase(phase); });
+  output << ',' << std::endl;
+
+  output << "  \"counters\": ";
+  writeCounters(output, [this](Counter counter) { return this->counter(counter); });
+  output << ',' << std::endl;
+
+  output << "  \"nodes\": {";
+
+  for(int i = 0; i < kNumNodeKinds; ++i) {
+    output << (0 == i ? "" : ", ") << '"' << kNodeKindNames[i] << "\": " << numNodes(static_cast<ast::NodeKind>(i));
+  }
+
+  output << "}," << std::endl;
+  output << "  \"perUnit\": [" << std::endl;
+
+  int index = 0;
+
+  m_units->foreach([&](CompilationUnit* unit) {
+    auto metrics = unit->metrics();
+
+    output
+      << (0 == index ? "" : ",\n")
+      << "    {\"index\": " << index
+      << ", \"dependency\": " << (unit->isDependency() ? "true" : "false")
+      << ", \"bytes\": " << unit->text()->size()
+      << ", \"phases\": ";
+    writePhases(output, [metrics](MetricPhase phase) { return metrics->phase(phase); });
+    output << ", \"counters\": ";
+    writeCounters(output, [metrics](Counter counter) { return metrics->counter(counter); });
+    output << '}';
+
+    ++index;
+  });
+
+  output << std::endl << "  ]" << std::endl;
+  output << '}' << std::endl;
+}
+} //namespace internal
+} //namespace brutus
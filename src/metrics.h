@@ -0,0 +1,186 @@
+#ifndef BRUTUS_METRICS_H_
+#define BRUTUS_METRICS_H_
+
+#include <iostream>
+
+#include "brutus.h"
+#include "ast.h"
+#include "list.h"
+#include "stopwatch.h"
+
+namespace brutus {
+  class CompilationUnit;
+
+  namespace internal {
+    class NameTable;
+
+    // The phases a compiler runs for every unit.
+#define METRIC_PHASES(V) \
+  V(Parse, "parse") \
+  V(Symbols, "symbols") \
+  V(Link, "link")
+
+    // Counters of a unit. Tokens are counted by the parser, the other
+    // counters are taken from the AST and the arena of the unit.
+#define METRIC_COUNTERS(V) \
+  V(Tokens, "tokens") \
+  V(Nodes, "nodes") \
+  V(Scopes, "scopes") \
+  V(Symbols, "symbols") \
+  V(ArenaBytes, "arenaBytes") \
+  V(Restored, "restored")
+
+#define DECLARE_METRIC(x, name) k##x,
+    enum class MetricPhase {
+      METRIC_PHASES(DECLARE_METRIC)
+      kNumPhases
+    }; //enum MetricPhase
+
+    enum class Counter {
+      METRIC_COUNTERS(DECLARE_METRIC)
+      kNumCounters
+    }; //enum Counter
+#undef DECLARE_METRIC
+
+#define COUNT_NODE_KIND(x) + 1
+    static const int kNumNodeKinds = 0 AST_NODE_KINDS(COUNT_NODE_KIND);
+#undef COUNT_NODE_KIND
+
+    static const int kNumMetricPhases = static_cast<int>(MetricPhase::kNumPhases);
+    static const int kNumCounters = static_cast<int>(Counter::kNumCounters);
+
+    // Wall and CPU time of some work.
+    class Timing {
+      public:
+        Timing() : m_wallNS(0), m_cpuNS(0) {}
+
+        Stopwatch::Rep m_wallNS;
+        Stopwatch::Rep m_cpuNS;
+
+        ALWAYS_INLINE void add(const Timing& other) {
+          m_wallNS += other.m_wallNS;
+          m_cpuNS += other.m_cpuNS;
+        }
+
+        // CPU time of the calling thread, or of the process if the
+        // platform cannot measure a single thread.
+        static Stopwatch::Rep threadCpuNS();
+
+        // CPU time of all threads of the process.
+        static Stopwatch::Rep processCpuNS();
+    };
+
+    // Measurements of one unit. Each phase of a unit runs on a single
+    // thread at a time so no locks are needed.
+    class UnitMetrics {
+      public:
+        explicit UnitMetrics() {
+          reset();
+        }
+
+        void reset();
+
+        // Runs f and adds its wall and CPU time to the given phase.
+        void time(MetricPhase phase, std::function<void()> f); //NOLINT
+
+        ALWAYS_INLINE const Timing& phase(MetricPhase phase) const {
+          return m_phases[static_cast<int>(phase)];
+        }
+
+        ALWAYS_INLINE void add(Counter counter, int64_t value) {
+          m_counters[static_cast<int>(counter)] += value;
+        }
+
+        ALWAYS_INLINE int64_t counter(Counter counter) const {
+          return m_counters[static_cast<int>(counter)];
+        }
+
+        ALWAYS_INLINE int64_t numNodes(ast::NodeKind kind) const {
+          return m_nodes[static_cast<int>(kind)];
+        }
+
+        // Counts the nodes, scopes and symbols of the AST and the bytes
+        // of the arena of the unit.
+        void collect(CompilationUnit* unit);
+
+      private:
+        Timing m_phases[kNumMetricPhases];
+        int64_t m_counters[kNumCounters];
+        int64_t m_nodes[kNumNodeKinds];
+
+        void count(ast::Node* node);
+
+        DISALLOW_COPY_AND_ASSIGN(UnitMetrics);
+    }; //class UnitMetrics
+
+    // The metrics of the last compile of a compiler. Every unit keeps
+    // its own, this sums them up and adds what is shared by all units.
+    //
+    // Timings and tokens are recorded while compiling. All other
+    // counters are collected from the ASTs when they are first asked
+    // for after a compile so they cost nothing unless someone looks.
+    class Metrics {
+      public:
+        // The arena is that of the compiler which holds what all units
+        // share, like the global scope and the symbols of images.
+        explicit Metrics(List<CompilationUnit*>* units, NameTable* names, Arena* arena, int numWorkers);
+
+        // Called by the compiler around a compile.
+        void begin();
+        void end();
+
+        // Wall and CPU time of the whole compile. The CPU time is that
+        // of all threads.
+        ALWAYS_INLINE const Timing& compile() const {
+          return m_compile;
+        }
+
+        // Time spent in a phase summed over all units.
+        Timing phase(MetricPhase phase);
+
+        int64_t counter(Counter counter);
+        int64_t numNodes(ast::NodeKind kind);
+
+        // Names interned during the compile.
+        ALWAYS_INLINE int64_t numNames() const {
+          return m_numNames;
+        }
+
+        // A table of the time of every phase followed by the counters.
+        void print(std::ostream& output);
+
+        // Writes all metrics, including those of every unit, as a JSON
+        // object.
+        void writeJson(std::ostream& output);
+
+        // A table of the memory the units and the compiler hold, and
+        // the peak resident size of the process if it is known.
+        void printMemory(std::ostream& output);
+
+        // Peak resident memory of the process in bytes, or zero.
+        static int64_t peakResidentBytes();
+
+        static const char* nameOf(MetricPhase phase);
+        static const char* nameOf(Counter counter);
+
+      private:
+        List<CompilationUnit*>* const m_units;
+        NameTable* const m_names;
+        Arena* const m_arena;
+        const int m_numWorkers;
+        Timing m_compile;
+        int64_t m_numNames;
+        bool m_isCollected;
+
+        // Start of the current compile.
+        Stopwatch m_stopwatch;
+        Stopwatch::Rep m_cpuStart;
+        int m_namesStart;
+
+        void collect();
+
+        DISALLOW_COPY_AND_ASSIGN(Metrics);
+    }; //class Metrics
+  } //namespace internal
+} //namespace brutus
+#endif
@@ -0,0 +1,42 @@
+#include "brutus.h"
+
+#include "compiler.h"
+
+// Compiles the prelude and writes its declarations as an image which
+// the compiler loads at startup instead of compiling the prelude.
+//
+// Usage: brutus_mkimage <prelude> <image>
+int main(int argc, char** argv) {
+  if(argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <prelude> <image>" << std::endl;
+    return 1;
+  }
+
+  auto fp = fopen(argv[1], "r");
+
+  if(!fp) {
+    std::cerr << "Could not read \"" << argv[1] << "\"." << std::endl;
+    return 1;
+  }
+
+  auto compiler = new brutus::Compiler();
+  compiler->addDependency(fp);
+  compiler->compile();
+  compiler->printDiagnostics(std::cerr);
+
+  // An image of a prelude with errors would be loaded by every compile
+  // without anyone seeing the errors again.
+  const auto numErrors = compiler->info()->totalErrors();
+  auto result = 0 == numErrors;
+
+  if(!result) {
+    std::cerr << numErrors << " error(s) in \"" << argv[1] << "\", no image written." << std::endl;
+  } else if(!(result = compiler->writeImage(argv[2]))) {
+    std::cerr << "Could not write \"" << argv[2] << "\"." << std::endl;
+  }
+
+  delete compiler;
+  fclose(fp);
+
+  return result ? 0 : 1;
+}
@@ -0,0 +1,166 @@
+#include "modules.h"
+
+#ifndef OS_WINDOWS
+#include <sys/stat.h>
+#include <sys/types.h>
+#else
+#include <direct.h>
+#endif
+
+#include <cstring>
+
+#include "compiler.h"
+#include "image.h"
+#include "mapped.h"
+#include "trace.h"
+
+namespace brutus {
+namespace internal {
+ModulePath::ModulePath(Context* context)
+    : m_context(context),
+      m_directory(nullptr) {
+  // Members of a loaded module see the global scope like those of a
+  // module that has been compiled from source.
+  m_scope = new (context->arena()) syms::Scope(context->arena());
+  m_scope->init(context->symbols()->global(), syms::ScopeKind::kGlobal);
+}
+
+ModulePath::~ModulePath() {
+  if(nullptr != m_directory) {
+    DeleteArray(m_directory);
+  }
+}
+
+bool ModulePath::open(const char* directory) {
+  if(nullptr != m_directory) {
+    DeleteArray(m_directory);
+    m_directory = nullptr;
+  }
+
+#ifndef OS_WINDOWS
+  mkdir(directory, 0755);
+#else
+  _mkdir(directory);
+#endif
+
+  const auto length = std::strlen(directory) + 1;
+
+  m_directory = NewArray<char>(length);
+  ArrayCopy(m_directory, directory, length);
+
+  // Modules that could not be found before may exist in this one.
+  m_isMissing.clear();
+
+  return YES;
+}
+
+bool ModulePath::pathOf(NameId name, char* path, size_t size) {
+  auto value = m_context->names()->value(name);
+
+  // The name of a module becomes the name of a file so it must not
+  // leave the directory.
+  if('\0' == value[0] || '.' == value[0] ||
+     nullptr != std::strchr(value, '/') || nullptr != std::strchr(value, '\\')) {
+    return NO;
+  }
+
+  const auto length = snprintf(path, size, "%s/%s.bmi", m_directory, value);
+
+  return length > 0 && static_cast<size_t>(length) < size;
+}
+
+syms::Symbol* ModulePath::get(NameId name) {
+  auto result = m_scope->getLocal(name);
+
+  if(nullptr != result || !isOpen() || m_isMissing.get(name)) {
+    return result;
+  }
+
+  char path[0x400];
+  MappedFile file;
+
+  if(!pathOf(name, path, sizeof(path)) || !file.open(path)) { //NOLINT
+    m_isMissing.put(name, YES);
+    return nullptr;
+  }
+
+  TRACE_SCOPE("modules", "load");
+  ImageReader reader(m_context);
+  List<ImageType> unresolved;
+
+  if(!reader.load(file.data(), file.size(), m_context->arena(), m_scope, nullptr, &unresolved)) {
+    m_isMissing.put(name, YES);
+    return nullptr;
+  }
+
+  // A file that does not declare the module it is named after is
+  // ignored.
+  result = m_scope->getLocal(name);
+
+  if(nullptr == result || result->kind() != syms::SymbolKind::kModule) {
+    m_isMissing.put(name, YES);
+    return nullptr;
+  }
+
+  // The classes of other modules are loaded from their own interface
+  // files. A module that refers back to this one finds it already.
+  unresolved.foreach([&](ImageType type) {
+    ImageReader::resolve(type, get(type.m_path[0]));
+  });
+
+  return result;
+}
+
+void ModulePath::interfaceOf(Context* context, syms::Symbol* module, ByteBuffer* target) {
+  ImageWriter writer(context);
+
+  writer.add(module);
+  writer.write(target);
+}
+
+bool ModulePath::store(syms::Symbol* module) {
+  char path[0x400];
+
+  if(!isOpen() || !pathOf(module->name(), path, sizeof(path))) { //NOLINT
+    return NO;
+  }
+
+  ByteBuffer interface;
+
+  interfaceOf(m_context, module, &interface);
+
+  {
+    MappedFile file;
+
+    if(file.open(path) &&
+       file.size() == interface.size() &&
+       0 == std::memcmp(file.data(), interface.data(), interface.size())) {
+      return YES;
+    }
+  }
+
+  char tempPath[sizeof(path) + 4]; //NOLINT
+
+  snprintf(tempPath, sizeof(tempPath), "%s.tmp", path); //NOLINT
+
+  // Interfaces are written to a temporary file first so a compiler
+  // that reads them at the same time never sees a partial one.
+  auto fp = fopen(tempPath, "wb");
+
+  if(!fp) {
+    return NO;
+  }
+
+  const bool result = interface.writeTo(fp);
+
+  fclose(fp);
+
+  if(!result || 0 != rename(tempPath, path)) {
+    remove(tempPath);
+    return NO;
+  }
+
+  return YES;
+}
+} //namespace internal
+} //namespace brutus
@@ -0,0 +1,65 @@
+#ifndef BRUTUS_MODULES_H_
+#define BRUTUS_MODULES_H_
+
+#include "brutus.h"
+#include "buffer.h"
+#include "name.h"
+#include "scopes.h"
+#include "symbols.h"
+
+namespace brutus {
+  class Context;
+
+  namespace internal {
+    // The interface files of compiled modules.
+    //
+    // An interface file is an image of a single top-level module and is
+    // named after it, like "a.bmi" for module a. It holds the names of
+    // the module and the symbols of its declarations with the types of
+    // their parameters, variables and results, but no function bodies
+    // and no AST. A module that requires another one is linked against
+    // its interface so its source is never read. A type that refers to
+    // a class of another module loads that module's interface as well.
+    //
+    // Modules that are loaded from interface files are not entered into
+    // the global scope. They are only visible to the modules that
+    // require them. Like images they are loaded once and stay for the
+    // lifetime of the compiler.
+    class ModulePath {
+      public:
+        explicit ModulePath(Context* context);
+        ~ModulePath();
+
+        // Reads and writes interface files in the given directory and
+        // creates it if it does not exist yet.
+        bool open(const char* directory);
+
+        ALWAYS_INLINE bool isOpen() const {
+          return nullptr != m_directory;
+        }
+
+        // Returns the module of the given name from its interface file
+        // or nullptr if there is none. The file is only read once.
+        syms::Symbol* get(NameId name);
+
+        // Writes the interface file of a top-level module. An existing
+        // file is only replaced if the interface changed so the files of
+        // modules whose declarations are the same keep their time.
+        bool store(syms::Symbol* module);
+
+        // Appends the interface of a module to the given buffer.
+        static void interfaceOf(Context* context, syms::Symbol* module, ByteBuffer* target);
+
+      private:
+        Context* const m_context;
+        syms::Scope* m_scope;
+        NameMap<bool> m_isMissing;
+        char* m_directory;
+
+        bool pathOf(NameId name, char* path, size_t size);
+
+        DISALLOW_COPY_AND_ASSIGN(ModulePath);
+    }; //class ModulePath
+  } //namespace internal
+} //namespace brutus
+#endif
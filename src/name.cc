@@ -1,238 +1,261 @@
 #include "name.h"
 
+#include <algorithm>
+#include <cstring>
+
+#include "trace.h"
+
 namespace brutus {
 namespace internal {
-template<class T>
-void NameCache<T>::init() {
-  m_table = m_arena->newArray<Entry<T>*>(m_tableSize);
-  ArrayFill(m_table, 0, m_tableSize);
+const float NameTable::DefaultLoadFactor = 0.75f;
+
+NameTable::NameTable(int initialCapacity, float loadFactor) : m_size(0), m_buckets(nullptr) {
+  m_loadFactor = loadFactor;
+  init(NextPow2(initialCapacity));
 }
 
-template<class T>
-T NameCache<T>::get(Name* key) {
-  const int hashCode = hashCodeOf(key);
-  const int keyIndex = indexOf(hashCode, m_tableSize);
-  Entry<T>* entry = m_table[keyIndex];
-  
-  while(entry != nullptr) {
-    if(entry->m_key == key) {
-      return entry->m_value;
-    }
+NameTable::NameTable() : m_size(0), m_buckets(nullptr) {
+  m_loadFactor = DefaultLoadFactor;
+  init(DefaultCapacity);
+}
 
-    entry = entry->m_next;
+NameTable::~NameTable() {
+  for(int i = 0; i < MaxPages; ++i) {
+    DeleteArray(m_pages[i]);
   }
 
-  return nullptr;
-}
+  for(int i = 0; i < MaxPoolChunks; ++i) {
+    Malloc::Delete(m_pool[i]);
+  }
 
-template<class T>
-void NameCache<T>::put(Name* key, T value) {
-  const int hashCode = hashCodeOf(key);
-  const int keyIndex = indexOf(hashCode, m_tableSize);
-  Entry<T>* entry = m_table[keyIndex];
-  
-  while(entry != nullptr) {
-    if(entry->m_key == key) {
-      entry->m_value = value;
-      return;
-    }
+  auto buckets = m_buckets.load(std::memory_order_relaxed);
 
-    entry = entry->m_next;
+  while(nullptr != buckets) {
+    auto previous = buckets->m_previous;
+
+    delete buckets;
+    buckets = previous;
   }
-  
-  auto oldEntry = m_table[keyIndex];
-  auto newEntry = new (m_arena) Entry(key, value, oldEntry);
 
-  m_table[keyIndex] = newEntry;
+  DeleteArray(m_pages);
+  DeleteArray(m_pool);
+}
 
-  if(m_size++ >= m_threshold) {
-    resize(2 * m_tableSize);
+NameTable::Buckets::Buckets(int capacity)
+    : m_capacity(capacity),
+      m_names(NewArray<std::atomic<NameId>>(capacity)),
+      m_previous(nullptr) {
+  for(int i = 0; i < capacity; ++i) {
+    m_names[i].store(kInvalidName, std::memory_order_relaxed);
   }
 }
 
-template<class T>
-int NameCache<T>::hashCodeOf(Name* name) {
-  return name->m_hashCode;
+NameTable::Buckets::~Buckets() {
+  DeleteArray(m_names);
 }
 
-template<class T>
-void NameCache<T>::resize(int newSize) {
-  auto oldTable = m_table;
-  auto oldSize = m_tableSize;
+void NameTable::init(int capacity) {
+  // An open addressed table needs at least one empty bucket to end
+  // a probe.
+  m_threshold = std::min(
+    static_cast<int>(static_cast<float>(capacity) * m_loadFactor), capacity - 1);
+  m_buckets.store(new Buckets(capacity), std::memory_order_relaxed);
+
+  m_pages = NewArray<Entry*>(MaxPages);
+  ArrayFill(m_pages, 0, MaxPages);
+
+  m_pool = NewArray<char*>(MaxPoolChunks);
+  ArrayFill(m_pool, 0, MaxPoolChunks);
+  m_poolSize = 0;
+  m_poolChunk = -1;
+  m_poolPosition = PoolChunkSize;
+
+  // The predefined names are interned first so that their ids are
+  // the same for every NameTable.
+  m_empty = get("", 0);
+  m_brutus_Int = get("brutus.Int", 10);
+  m_brutus_String = get("brutus.String", 13);
+}
 
-  if(oldSize == NameTable::MaximumCapacity) {
-    m_threshold = std::numeric_limits<int>::max();
-    return;
-  }
+NameId NameTable::find(const char* value, int length) {
+  return lookup(m_buckets.load(std::memory_order_acquire), value, length, hashCodeOf(value, length));
+}
 
-  Entry<T>** newTable = m_arena->newArray<Entry<T>*>(newSize);
-  ArrayFill(newTable, 0, newSize);
-  transfer(oldTable, oldSize, newTable, newSize);
+NameId NameTable::lookup(Buckets* buckets, const char* value, int length, int hashCode) {
+  const int mask = buckets->m_capacity - 1;
 
-  m_table = newTable;
-  m_tableSize = newSize;
-  m_threshold = static_cast<int>(static_cast<float>(newSize) * m_loadFactor);
-}
+  for(int index = indexOf(hashCode, buckets->m_capacity);; index = (index + 1) & mask) {
+    // The acquire pairs with the release in insert() so the entry of
+    // the name is complete.
+    const NameId name = buckets->m_names[index].load(std::memory_order_acquire);
 
-template<class T>
-void NameCache<T>::transfer(Entry<T>** src, int srcSize, Entry<T>** dst, int dstSize) {
-  for (int i = 0; i < srcSize; i++) {
-    Entry<T>* entry = src[i];
+    if(name == kInvalidName) {
+      return kInvalidName;
+    }
 
-    if(entry != nullptr) {
-      do {
-        Entry<T>* next = entry->m_next;
-        int index = indexOf(entry->m_key->m_hashCode, dstSize);
+    const Entry& e = entry(name);
 
-        entry->m_next = dst[index];
-        dst[index] = name;
+    // If the name has an equal hash code and length
+    // it is a pretty good candidate.
 
-        name = next;
-      } while (name != nullptr);
+    if(e.m_hashCode == hashCode && e.m_length == length) {
+      // The last check requires to test the entire value for
+      // equality. Only if this test succeeds we can guarantee
+      // that the correct name has been selected.
+      if(0 == std::memcmp(value, valueAt(e.m_offset), length)) {
+        return name;
+      }
     }
   }
-
-  ArrayFill(src, 0, srcSize);
 }
 
-const float NameTable::DefaultLoadFactor = 0.75f;
-
-NameTable::NameTable(int initialCapacity, float loadFactor, Arena* arena) : m_arena(arena), m_size(0) {
-  int capacity = NextPow2(initialCapacity);
-  m_loadFactor = loadFactor;
-  m_threshold = static_cast<int>(static_cast<float>(capacity) * loadFactor);
-  m_tableSize = capacity;
-  init();
-}
+void NameTable::insert(Buckets* buckets, NameId name, int hashCode) {
+  const int mask = buckets->m_capacity - 1;
+  int index = indexOf(hashCode, buckets->m_capacity);
 
-NameTable::NameTable(Arena* arena) : m_arena(arena), m_size(0) {
-  m_loadFactor = DefaultLoadFactor;
-  m_threshold = static_cast<int>(static_cast<float>(DefaultCapacity) * DefaultLoadFactor);
-  m_tableSize = DefaultCapacity;
-  init();
-}
+  while(buckets->m_names[index].load(std::memory_order_relaxed) != kInvalidName) {
+    index = (index + 1) & mask;
+  }
 
-void NameTable::init() {
-  m_table = m_arena->newArray<Name*>(m_tableSize);
-  ArrayFill(m_table, 0, m_tableSize);
+  buckets->m_names[index].store(name, std::memory_order_release);
 }
 
-Name* NameTable::get(const char* value, int length, bool copyValue) {
+NameId NameTable::get(const char* value, int length) {
   // First we perform a lookup in the internal
   // hash table which is created by the list of
-  // name entries.
+  // name entries. A name that exists is found
+  // without a lock.
 
   const int hashCode = hashCodeOf(value, length);
-  const int keyIndex = indexOf(hashCode, m_tableSize);
-  Name* entry = m_table[keyIndex];
-  
-  while(entry != nullptr) {
-    // If the name has an equal hash code and length
-    // it is a pretty good candidate.
-
-    if(entry->m_hashCode == hashCode && entry->m_length == length) {
-      // The last check requires to test the entire value for
-      // equality. Only if this test succeeds we can guarantee
-      // that the correct name has been selected.
-      bool isEqual = YES;
+  const NameId found = lookup(m_buckets.load(std::memory_order_acquire), value, length, hashCode);
 
-      const char* p = value;
-      const char* q = entry->m_value;
-
-      for(int i = 0; i < length; ++i) {
-        if(*p++ != *q++) {
-          isEqual = NO;
-          break;
-        }
-      }
+  if(found != kInvalidName) {
+    return found;
+  }
 
-      if(isEqual) {
-        return entry;
-      }
-    }
+  // Another thread may have interned the same name since, so it is
+  // looked up again under the lock. The buckets only change under it.
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto buckets = m_buckets.load(std::memory_order_relaxed);
+  const NameId existing = lookup(buckets, value, length, hashCode);
 
-    entry = entry->m_next;
+  if(existing != kInvalidName) {
+    return existing;
   }
 
   // No existing Name was found. We need to insert a new
   // entry into the table. We also know for sure that no
   // such key->value association exists.
+  TRACE_SCOPE("names", "intern");
+
+  const int size = m_size.load(std::memory_order_relaxed);
+
+  // The last chunk of the pool cannot be followed by another one.
+  const bool isPoolFull =
+    m_poolPosition + length + 1 > PoolChunkSize && m_poolChunk + 1 == MaxPoolChunks;
+
+  if(size == EntriesPerPage * MaxPages || length >= PoolChunkSize || isPoolFull) {
+    std::cerr << "Error: Cannot intern another name." << std::endl;
+    return kInvalidName;
+  }
+
+  const NameId name = static_cast<NameId>(size);
+  const int page = name >> EntriesPerPageBits;
 
-  if(copyValue) {
-    // The Lexer shares the same buffer to save some space.
-    // Copying the value into a name is the only operation
-    // we perform to persist it.
-    //
-    // That is where copyValue comes into place. If one might
-    // want to enter a name manually it is absolutely possible
-    // to specify this and no additional copy is made.
-    auto valueCopy = m_arena->newArray<char>(length);
-    ArrayCopy(valueCopy, value, kCharSize * length);
-    value = valueCopy;
+  if(nullptr == m_pages[page]) {
+    m_pages[page] = NewArray<Entry>(EntriesPerPage);
   }
-  
-  auto oldName = m_table[keyIndex];
-  auto newName = new (m_arena) Name(hashCode, value, length, oldName);
 
-  m_table[keyIndex] = newName;
+  Entry& e = m_pages[page][name & (EntriesPerPage - 1)];
 
-  if(m_size++ >= m_threshold) {
-    resize(2 * m_tableSize);
+  e.m_hashCode = hashCode;
+  e.m_offset = intern(value, length);
+  e.m_length = length;
+
+  m_size.store(size + 1, std::memory_order_release);
+
+  if(size >= m_threshold) {
+    // The new buckets hold the name already.
+    resize(2 * buckets->m_capacity);
+  } else {
+    insert(buckets, name, hashCode);
   }
 
-  return newName;
+  return name;
 }
 
-int NameTable::hashCodeOf(const char* value, int length) {
-  const char* p = value;
-  unsigned int sum = 23;
-  
-  for(int i = 0; i < length; ++i) {
-    sum += (*p++ * 31);
+uint32_t NameTable::intern(const char* value, int length) {
+  // The Lexer shares the same buffer to save some space.
+  // Copying the value into the pool is the only operation
+  // we perform to persist it. A name never spans two chunks
+  // and is always followed by a terminating zero.
+
+  if(m_poolPosition + length + 1 > PoolChunkSize) {
+    ++m_poolChunk;
+    m_pool[m_poolChunk] =
+      reinterpret_cast<char*>(Malloc::New(PoolChunkSize * kCharSize));
+    m_poolPosition = 0;
   }
 
-  sum ^= (sum >> 20) ^ (sum >> 12);
-  sum ^= (sum >>  7) ^ (sum >>  4);
+  auto target = m_pool[m_poolChunk] + m_poolPosition;
+  ArrayCopy(target, value, kCharSize * length);
+  target[length] = '\0';
 
-  return static_cast<int>(sum);
+  const uint32_t offset =
+    (static_cast<uint32_t>(m_poolChunk) << PoolChunkBits) |
+    static_cast<uint32_t>(m_poolPosition);
+
+  m_poolPosition += length + 1;
+  m_poolSize += length + 1;
+
+  return offset;
 }
 
-void NameTable::resize(int newSize) {
-  auto oldTable = m_table;
-  auto oldSize = m_tableSize;
+int NameTable::hashCodeOf(const char* value, int length) {
+  // FNV-1a. Names of the same characters in another order, like
+  // generated ones, must not collide since the buckets are probed
+  // linearly.
+  uint32_t hash = 2166136261u;
 
-  if(oldSize == MaximumCapacity) {
-    m_threshold = std::numeric_limits<int>::max();
-    return;
+  for(int i = 0; i < length; ++i) {
+    hash ^= static_cast<uint8_t>(value[i]);
+    hash *= 16777619u;
   }
 
-  Name** newTable = m_arena->newArray<Name*>(newSize);
-  ArrayFill(newTable, 0, newSize);
-  transfer(oldTable, oldSize, newTable, newSize);
+  hash ^= (hash >> 20) ^ (hash >> 12);
+  hash ^= (hash >>  7) ^ (hash >>  4);
 
-  m_table = newTable;
-  m_tableSize = newSize;
-  m_threshold = static_cast<int>(static_cast<float>(newSize) * m_loadFactor);
+  return static_cast<int>(hash);
 }
 
-void NameTable::transfer(Name** src, int srcSize, Name** dst, int dstSize) {
-  for (int i = 0; i < srcSize; i++) {
-    Name* name = src[i];
+void NameTable::resize(int newSize) {
+  auto buckets = m_buckets.load(std::memory_order_relaxed);
+  const int size = m_size.load(std::memory_order_relaxed);
+
+  if(buckets->m_capacity == MaximumCapacity) {
+    m_threshold = MaximumCapacity - 1;
+    insert(buckets, static_cast<NameId>(size - 1), entry(static_cast<NameId>(size - 1)).m_hashCode);
+    return;
+  }
 
-    if (name != nullptr) {
-      do {
-        Name* next = name->m_next;
-        int index = indexOf(name->m_hashCode, dstSize);
+  TraceScope trace("names", "resize", "capacity", newSize);
 
-        name->m_next = dst[index];
-        dst[index] = name;
+  // Since the entries live in their own pages only the buckets
+  // need to be rebuilt. We walk the names in order of their id.
+  auto newTable = new Buckets(newSize);
 
-        name = next;
-      } while (name != nullptr);
-    }
+  for(NameId name = 0; name < static_cast<NameId>(size); ++name) {
+    insert(newTable, name, entry(name).m_hashCode);
   }
 
-  ArrayFill(src, 0, srcSize);
+  // Other threads may still probe the old buckets. They find every
+  // name that has been in there and look a missing one up again under
+  // the lock.
+  newTable->m_previous = buckets;
+  m_buckets.store(newTable, std::memory_order_release);
+
+  m_threshold = std::min(
+    static_cast<int>(static_cast<float>(newSize) * m_loadFactor), newSize - 1);
 }
 } //namespace internal
-} //namespace brutus
\ No newline at end of file
+} //namespace brutus
@@ -1,128 +1,90 @@
 #ifndef BRUTUS_NAME_H_
 #define BRUTUS_NAME_H_
 
+#include <atomic>
 #include <limits>
+#include <mutex>
 
 #include "brutus.h"
-#include "arena.h"
+#include "alloc.h"
 
 namespace brutus {
   namespace internal {
-    class NameTable;
-
-    template<class T>
-    class NameCache;
-    
-    namespace syms { class Scope; }
-
-    class Name : public ArenaMember {
+    // Names are interned by the NameTable and referred to by a dense
+    // 32-bit identifier. The first name that is interned gets the id 0,
+    // the second one 1 and so on.
+    //
+    // Since identifiers are dense they can be used to index side tables
+    // directly and since they do not depend on any address they can be
+    // written to disk as they are.
+    typedef uint32_t NameId;
+
+    static const NameId kInvalidName = std::numeric_limits<NameId>::max();
+
+    // A side table that associates a value with a NameId.
+    //
+    // The table is a plain array indexed by the id of the name. Since
+    // ids are dense this requires no hashing and no probing at all. The
+    // array grows on demand and unset values are T().
+    template<typename T>
+    class NameMap {
       public:
-        void* operator new(size_t size, Arena* arena) {
-          return arena->alloc(size);
-        }
+        explicit NameMap()
+            : m_values(nullptr),
+              m_capacity(0) {}
 
-        explicit Name(const int& hashCode, const char* value, const int& length, Name* next)
-            : m_hashCode(hashCode),
-              m_value(value),
-              m_length(length),
-              m_next(next) {}
+        ~NameMap() {
+          clear();
+        }
 
-        ALWAYS_INLINE const char* value() const {
-          return m_value;
+        ALWAYS_INLINE T get(NameId name) const {
+          return name < m_capacity ? m_values[name] : T();
         }
 
-        ALWAYS_INLINE int length() const {
-          return m_length;
+        ALWAYS_INLINE bool contains(NameId name) const {
+          return get(name) != T();
         }
-      private:
-        void* operator new(size_t size);
-        const int m_hashCode;
-        const char* m_value;
-        const int m_length;
-        Name* m_next;
-
-        friend class NameTable;
-        friend class NameCache<void>;
-        friend class syms::Scope;
-
-        DISALLOW_COPY_AND_ASSIGN(Name);
-    }; //class Name
-    
-    //TODO(joa): can be replaced with generic map<K,V>
-    template<class T>
-    class NameCache {
-      private:
-        template<class T>
-        class Entry : public ArenaMember {
-          public:
-            void* operator new(size_t size, Arena* arena) {
-              return arena->alloc(size);
-            }
-
-            explicit Entry(Name* key, T value, Entry<T>* next) 
-                : m_key(key), 
-                  m_value(value),
-                  m_next(next) {}
-
-          private:
-            Name* m_key;
-            T m_value;
-            Entry<T>* m_next;
-        };
 
-      public:
-        explicit NameCache(int initialCapacity, float loadFactor, Arena* arena) 
-            : m_arena(arena) {
-          int capacity = NextPow2(initialCapacity);
-          m_size = 0;
-          m_loadFactor = loadFactor;
-          m_threshold = static_cast<int>(static_cast<float>(capacity) * loadFactor);
-          m_tableSize = capacity;
-          init();
+        void put(NameId name, T value) {
+          if(name >= m_capacity) {
+            grow(name + 1);
+          }
+
+          m_values[name] = value;
         }
 
-        explicit NameCache(Arena* arena) 
-            : m_arena(arena) {
-          m_size = 0;
-          m_loadFactor = NameTable::DefaultLoadFactor;
-          m_threshold = static_cast<int>(static_cast<float>(NameTable::DefaultCapacity) * NameTable::DefaultLoadFactor);
-          m_tableSize = NameTable::DefaultCapacity;
-          init();
+        void remove(NameId name) {
+          if(name < m_capacity) {
+            m_values[name] = T();
+          }
         }
 
-        T get(Name* key);
-        void put(Name* key, T value);
-        bool contains(Name* key);
+        void clear() {
+          DeleteArray(m_values);
+          m_values = nullptr;
+          m_capacity = 0;
+        }
 
       private:
-        Arena* const m_arena;
-        int m_size;
-        Entry<T>** m_table;
-        int m_tableSize;
-        int m_threshold;
-        float m_loadFactor;
+        T* m_values;
+        NameId m_capacity;
 
-        void init();
-        int hashCodeOf(Name* value);
-        void resize(int newCapacity);
-        void transfer(Entry<T>** src, int srcSize, Entry<T>** dst, int dstSize);
+        void grow(NameId minCapacity) {
+          auto newCapacity =
+            static_cast<NameId>(NextPow2(static_cast<int>(minCapacity)));
+          auto newValues = NewArray<T>(newCapacity);
 
-        ALWAYS_INLINE int indexOf(int hash, int length) {
-          // Same as "return hash % length" given that length is
-          // a power of two.
-          int result = hash & (length - 1);
-
-#ifdef DEBUG
-          if(result < 0) {
-            std::cerr << "Error: NameCache index is less than zero." << std::endl;
+          for(NameId i = 0; i < newCapacity; ++i) {
+            newValues[i] = i < m_capacity ? m_values[i] : T();
           }
-#endif
 
-          return result;
+          DeleteArray(m_values);
+          m_values = newValues;
+          m_capacity = newCapacity;
         }
 
-        DISALLOW_COPY_AND_ASSIGN(NameCache);
-    };
+        DISALLOW_COPY_AND_ASSIGN(NameMap);
+    }; //class NameMap
 
     class NameTable {
       public:
@@ -130,35 +92,126 @@ namespace brutus {
         static const int DefaultCapacity = 1 << 8;
         static const int MaximumCapacity = 1 << 30;
 
-        explicit NameTable(int initialCapacity, float loadFactor, Arena* arena);
-        explicit NameTable(Arena* arena);
-        Name* get(const char* value, int length, bool copyValue);
+        // Entries are stored in pages and the characters of all names
+        // are stored in a string pool of large chunks. Neither pages
+        // nor chunks are moved once they have been allocated so a value
+        // returned by value() stays valid for the lifetime of the table.
+        //
+        // Names can be interned from several threads at once. Finding a
+        // name that exists takes no lock. The buckets are an open
+        // addressed array of ids and an id is only stored into it once
+        // its entry is complete. A larger array replaces the buckets when
+        // they fill up; the old one is kept until the table is deleted
+        // since another thread may still probe it. Only interning a new
+        // name locks, and looks the name up again under the lock.
+        static const int EntriesPerPageBits = 12;
+        static const int EntriesPerPage = 1 << EntriesPerPageBits;
+        static const int MaxPages = 1 << 12;
+        static const int PoolChunkBits = 20;
+        static const int PoolChunkSize = 1 << PoolChunkBits;
+        static const int MaxPoolChunks = 1 << 12;
+
+        explicit NameTable(int initialCapacity, float loadFactor);
+        explicit NameTable();
+        ~NameTable();
+
+        // Interns the given characters and returns the id of the name.
+        // The characters are always copied into the string pool.
+        NameId get(const char* value, int length);
+
+        // Returns the id of an already interned name or kInvalidName if
+        // no such name exists. Unlike get() this never interns.
+        NameId find(const char* value, int length);
+
+        // The zero-terminated characters of the given name.
+        ALWAYS_INLINE const char* value(NameId name) const {
+          return valueAt(entry(name).m_offset);
+        }
+
+        ALWAYS_INLINE int length(NameId name) const {
+          return entry(name).m_length;
+        }
 
-        inline Name* empty() {
-          return this->get("", 1, /*copyValue=*/false);
+        ALWAYS_INLINE int hashCode(NameId name) const {
+          return entry(name).m_hashCode;
         }
 
-        #define PREDEFINED_NAME(x) \
-          return this->get(x, sizeof(x) - 1, /*copyValue=*/false)
+        ALWAYS_INLINE NameId empty() const {
+          return m_empty;
+        }
 
-        inline Name* brutus_Int() { PREDEFINED_NAME("brutus.Int"); }
-        inline Name* brutus_String() { PREDEFINED_NAME("brutus.String"); }
+        ALWAYS_INLINE NameId brutus_Int() const {
+          return m_brutus_Int;
+        }
 
-        inline int size() {
-          return m_size;
+        ALWAYS_INLINE NameId brutus_String() const {
+          return m_brutus_String;
         }
+
+        // The number of interned names. All ids are in [0, size()).
+        ALWAYS_INLINE int size() const {
+          return m_size.load(std::memory_order_acquire);
+        }
+
+        // The number of bytes occupied by the string pool.
+        ALWAYS_INLINE int64_t poolSize() const {
+          return m_poolSize;
+        }
+
       private:
-        Arena* const m_arena;
-        int m_size;
-        Name** m_table;
-        int m_tableSize;
+        class Entry {
+          public:
+            int m_hashCode;
+            uint32_t m_offset;
+            int m_length;
+        };
+
+        class Buckets {
+          public:
+            explicit Buckets(int capacity);
+            ~Buckets();
+
+            int m_capacity;
+            std::atomic<NameId>* m_names;
+            Buckets* m_previous;
+        };
+
+        std::atomic<int> m_size;
+        std::atomic<Buckets*> m_buckets;
         int m_threshold;
         float m_loadFactor;
 
-        void init();
+        Entry** m_pages;
+        char** m_pool;
+        int64_t m_poolSize;
+        int m_poolChunk;
+        int m_poolPosition;
+
+        std::mutex m_mutex;
+
+        NameId m_empty;
+        NameId m_brutus_Int;
+        NameId m_brutus_String;
+
+        void init(int capacity);
         int hashCodeOf(const char* value, int length);
+        NameId lookup(Buckets* buckets, const char* value, int length, int hashCode);
+        void insert(Buckets* buckets, NameId name, int hashCode);
+        uint32_t intern(const char* value, int length);
         void resize(int newCapacity);
-        void transfer(Name** src, int srcSize, Name** dst, int dstSize);
+
+        ALWAYS_INLINE Entry& entry(NameId name) const {
+#ifdef DEBUG
+          if(name >= static_cast<NameId>(m_size.load(std::memory_order_relaxed))) {
+            std::cerr << "Error: Name " << name << " does not exist." << std::endl;
+          }
+#endif
+          return m_pages[name >> EntriesPerPageBits][name & (EntriesPerPage - 1)];
+        }
+
+        ALWAYS_INLINE const char* valueAt(uint32_t offset) const {
+          return m_pool[offset >> PoolChunkBits] + (offset & (PoolChunkSize - 1));
+        }
 
         ALWAYS_INLINE int indexOf(int hash, int length) {
           // Same as "return hash % length" given that length is
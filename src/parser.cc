@@ -1,4 +1,5 @@
 #include "parser.h"
+#include "streams.h"
 
 namespace brutus {
 namespace internal {
@@ -31,20 +32,12 @@ namespace internal {
 //
 
 // Macro to expect a certain token type. If no such token is found
-// the ast::Error token is returned.
-
-#ifdef _MSC_VER
-#define SNPRINTF _snprintf
-#else
-#define SNPRINTF snprintf
-#endif
+// the error is reported and an ast::Error node is returned.
 
 #define EXPECT(t) \
   if(!poll(t)) { \
-    auto buf = m_arena->newArray<char>(0x100); \
-    SNPRINTF(buf, 0x100, "%s:%d Invalid syntax. Expected %s, got %s.", __FILE__, \
-      __LINE__, tok::toString(t), tok::toString(m_currentToken)); \
-    return error(buf); \
+    return error(DiagnosticCode::kExpectedToken, \
+      static_cast<uint32_t>(t), static_cast<uint32_t>(m_currentToken)); \
   }
 
 //
@@ -58,8 +51,23 @@ ast::Node* Parser::parseProgram() {
   auto modules = result->modules();
 
   while(peek(Token::kModule)) {
-    modules->add(parseModule(), m_arena);
-    EXPECT(Token::kNewLine);
+    const auto start = m_lexer->posOffset();
+    auto module = parseModule();
+
+    recordRange(module, start);
+    modules->add(module, m_arena);
+
+    if(!poll(Token::kNewLine)) {
+      if(ast::NodeKind::kError != module->kind()) {
+        modules->add(error(DiagnosticCode::kExpectedToken,
+          static_cast<uint32_t>(Token::kNewLine), static_cast<uint32_t>(m_currentToken)), m_arena);
+      }
+
+      // The next module is parsed on its own.
+      while(!peek(Token::kModule) && !peek(Token::kEof)) {
+        advance();
+      }
+    }
   }
 
   return result;
@@ -80,9 +88,11 @@ ast::Node* Parser::parseProgram() {
 //  ;
 //
 ast::Node* Parser::parseModule() {
+  const auto offset = m_lexer->posOffset();
+
   EXPECT(Token::kModule);
 
-  auto result = alloc<ast::Module>();
+  auto result = alloc<ast::Module>(offset);
   ast::Node* name = nullptr;
 
   if(peek(Token::kIdentifier)) {
@@ -99,23 +109,33 @@ ast::Node* Parser::parseModule() {
   EXPECT(Token::kLBrace);
   EXPECT(Token::kNewLine);
 
+  const auto depth = m_depth;
   auto dependencies = result->dependencies();
   auto declarations = result->declarations();
 
   do {
+    const auto start = m_lexer->posOffset();
+    ast::Node* element = nullptr;
+
     // ModuleDeclaration
     if(peek(Token::kRequire)) {
-      dependencies->add(parseModuleDependency(), m_arena);
+      element = parseModuleDependency();
+      dependencies->add(element, m_arena);
     } else {
-      ast::Node* declaration = parseDeclaration();
+      element = parseDeclaration();
 
-      if(nullptr == declaration) {
-        declarations->add(parseExpression(), m_arena);
+      if(nullptr == element) {
+        element = parseExpression();
       } else {
-        declarations->add(declaration, m_arena);
+        recordRange(element, start);
       }
+
+      declarations->add(element, m_arena);
+    }
+
+    if(!expectNewLine(element, start, depth, declarations)) {
+      break;
     }
-    EXPECT(Token::kNewLine);
   } while(!peek(Token::kRBrace));
 
   EXPECT(Token::kRBrace);
@@ -129,9 +149,11 @@ ast::Node* Parser::parseModule() {
 //  ;
 
 ast::Node* Parser::parseModuleDependency() {
+  const auto offset = m_lexer->posOffset();
+
   EXPECT(Token::kRequire);
 
-  auto result = alloc<ast::ModuleDependency>();
+  auto result = alloc<ast::ModuleDependency>(offset);
   auto name = parseIdentifier(); //TODO(joa): parseActorName()
 
   //TODO(joa):
@@ -169,7 +191,7 @@ ast::Node* Parser::parseModuleVersion() {
     //TODO(joa): NumberLiteral
     UNUSED(number);
 
-    return error("TODO NumberLiteral");
+    return error(DiagnosticCode::kNumberLiteralNotImplemented);
   }
 
   if(poll(Token::kComma)) {
@@ -180,12 +202,12 @@ ast::Node* Parser::parseModuleVersion() {
 
     if(poll(Token::kRBrac)) {
       //?,x]
-      return error("TODO ?,x]");
+      return error(DiagnosticCode::kIntervalNotImplemented);
     } else if(poll(Token::kRParen)) {
       //?,x)
-      return error("TODO ?,x)");
+      return error(DiagnosticCode::kIntervalNotImplemented);
     } else {
-      return error("Expected ']' or ')'");
+      return error(DiagnosticCode::kExpectedIntervalEnd);
     }
   } else {
     // ?x
@@ -197,10 +219,10 @@ ast::Node* Parser::parseModuleVersion() {
       //[x,
       if(poll(Token::kRBrac)) {
         // [x,]
-        return error("TODO ?x,]");
+        return error(DiagnosticCode::kIntervalNotImplemented);
       } else if(poll(Token::kRParen)) {
         // [x,)
-        return error("TODO ?x,)");
+        return error(DiagnosticCode::kIntervalNotImplemented);
       } else {
         //[x,y
         auto y = parseNumberLiteral();
@@ -209,20 +231,20 @@ ast::Node* Parser::parseModuleVersion() {
 
         if(poll(Token::kRBrac)) {
           //[x,y]
-          return error("TODO ?x,y]");
+          return error(DiagnosticCode::kIntervalNotImplemented);
         } else if(poll(Token::kRParen)) {
           //[x,y)
-          return error("TODO ?x,y)");
+          return error(DiagnosticCode::kIntervalNotImplemented);
         } else {
-          return error("Expected ']' or ')'");
+          return error(DiagnosticCode::kExpectedIntervalEnd);
         }
       }
     } else if(isBracket && poll(Token::kRBrac)) {
       //[x]
       //return
-      return error("TODO [x]");
+      return error(DiagnosticCode::kIntervalNotImplemented);
     } else {
-      return error("Expected ',' or ']'");
+      return error(DiagnosticCode::kExpectedCommaOrBracket);
     }
   }
 }
@@ -235,14 +257,23 @@ ast::Node* Parser::parseModuleVersion() {
 //  ;
 //
 ast::Node* Parser::parseBlock() {
+  const auto offset = m_lexer->posOffset();
+
   if(poll(Token::kLBrace)) {
     EXPECT(Token::kNewLine);
-    auto block = alloc<ast::Block>();
+    auto block = alloc<ast::Block>(offset);
     auto expressions = block->expressions();
+    const auto depth = m_depth;
 
     do {
-      expressions->add(parseBlock(), m_arena);
-      EXPECT(Token::kNewLine);
+      const auto start = m_lexer->posOffset();
+      auto expression = parseBlock();
+
+      expressions->add(expression, m_arena);
+
+      if(!expectNewLine(expression, start, depth, expressions)) {
+        break;
+      }
     } while(!peek(Token::kRBrace));
 
     EXPECT(Token::kRBrace);
@@ -306,28 +337,28 @@ ast::Node* Parser::parseDeclaration() {
 
     if(peek(Token::kDef)) {
       if((flags & Parser::ACC_IMMUTABLE) != 0) {
-        return error("Function may not be marked immutable.");
+        return error(DiagnosticCode::kImmutableFunction);
       }
 
       return parseFunction(flags);
     } else if(peek(Token::kClass)) {
       if((flags & Parser::ACC_PURE) != 0) {
-        return error("Class may not be marked pure.");
+        return error(DiagnosticCode::kPureClass);
       }
 
       return parseClass(flags);
     } else if(peek(Token::kVal) || peek(Token::kVar)) {
       if((flags & Parser::ACC_IMMUTABLE) != 0) {
-        return error("Variable may not be marked immutable.");
+        return error(DiagnosticCode::kImmutableVariable);
       }
 
       if((flags & Parser::ACC_PURE) != 0) {
-        return error("Variable may not be marked pure.");
+        return error(DiagnosticCode::kPureVariable);
       }
 
       return parseVariable(flags);
     } else {
-      return error("Expected 'def', 'var', 'val' or 'class'.");
+      return error(DiagnosticCode::kExpectedDeclaration);
     }
   } else if(poll(Token::kImmutable)) {
     unsigned int flags = Parser::ACC_PUBLIC | Parser::ACC_IMMUTABLE;
@@ -343,7 +374,7 @@ ast::Node* Parser::parseDeclaration() {
     if(peek(Token::kClass)) {
       return parseClass(flags);
     } else {
-      return error("Expected 'class'.");
+      return error(DiagnosticCode::kExpectedClass);
     }
   } else if(poll(Token::kPure)) {
     unsigned int flags = Parser::ACC_PUBLIC | Parser::ACC_PURE;
@@ -359,7 +390,7 @@ ast::Node* Parser::parseDeclaration() {
     if(peek(Token::kDef)) {
       return parseFunction(flags);
     } else {
-      return error("Expected 'def'.");
+      return error(DiagnosticCode::kExpectedDef);
     }
   } else if(poll(Token::kVirtual)) {
     // "virtual class" is the same as "public virtual class"
@@ -376,7 +407,7 @@ ast::Node* Parser::parseDeclaration() {
     } else if(peek(Token::kVal) || peek(Token::kVar)) {
       return parseVariable(flags);
     } else {
-      return error("Expected 'def', 'val', 'var' or 'class'.");
+      return error(DiagnosticCode::kExpectedDeclaration);
     }
   } else {
     return nullptr;
@@ -405,13 +436,15 @@ bool Parser::peekVisibility() {
 //
 ast::Node* Parser::parseClass(unsigned int flags) {
   if(0 == flags) {
-    return error("Internal error.");
+    return error(DiagnosticCode::kInternalError);
   }
 
+  const auto offset = m_lexer->posOffset();
+
   EXPECT(Token::kClass);
 
   auto name = parseIdentifier();
-  auto result = alloc<ast::Class>();
+  auto result = alloc<ast::Class>(offset);
 
   if(peek(Token::kLBrac)) {
     auto error = parseTypeParameterList(result->typeParameters());
@@ -435,11 +468,23 @@ ast::Node* Parser::parseClass(unsigned int flags) {
     EXPECT(Token::kNewLine);
 
     auto members = result->members();
+    const auto depth = m_depth;
 
     while(!poll(Token::kRBrace)) {
       pollAll(Token::kNewLine);
-      members->add(parseDeclaration(), m_arena);
-      EXPECT(Token::kNewLine);
+
+      const auto start = m_lexer->posOffset();
+      auto member = parseDeclaration();
+
+      if(nullptr == member) {
+        member = error(DiagnosticCode::kExpectedDeclaration);
+      }
+
+      members->add(member, m_arena);
+
+      if(!expectNewLine(member, start, depth, members)) {
+        EXPECT(Token::kRBrace);
+      }
     }
   }
 
@@ -470,10 +515,12 @@ ast::Node* Parser::parseClass(unsigned int flags) {
 //  | 'def' Identifier TypeParameterList? '(' ParameterList ')' '{' Block '}'
 //
 ast::Node* Parser::parseFunction(unsigned int flags) {
+  const auto offset = m_lexer->posOffset();
+
   EXPECT(Token::kDef);
 
   auto name = parseIdentifier();
-  auto result = alloc<ast::Function>();
+  auto result = alloc<ast::Function>(offset);
 
   if(peek(Token::kLBrac)) {
     auto error = parseTypeParameterList(result->typeParameters());
@@ -487,7 +534,7 @@ ast::Node* Parser::parseFunction(unsigned int flags) {
 
   if(!peek(Token::kRParen)) {
     if(!parseParameterList(result->parameters())) {
-      return error("Function exceeds max arity.");
+      return error(DiagnosticCode::kTooManyParameters);
     }
   }
 
@@ -495,34 +542,155 @@ ast::Node* Parser::parseFunction(unsigned int flags) {
 
   ast::Node* block = nullptr;
   ast::Node* type = nullptr;
+  ast::LazyBody* lazyBody = nullptr;
 
   if(poll(Token::kColon)) {
     type = parseType();
 
     if(poll(Token::kAssign)) {
-      block = parseBlock();
+      if(isOutline() && peek(Token::kLBrace)) {
+        lazyBody = skipBody();
+
+        if(nullptr == lazyBody) {
+          return error(DiagnosticCode::kUnexpectedEndOfFile);
+        }
+      } else {
+        block = parseBlock();
+      }
     } else if(peek(Token::kNewLine)) {
       flags |= ACC_ABSTRACT;
     } else {
-      return error("Expected '=' or '\n'.");
+      return error(DiagnosticCode::kExpectedFunctionBody);
     }
   } else if(peek(Token::kLBrace)) {
-    block = parseBlock();
+    if(isOutline()) {
+      lazyBody = skipBody();
+
+      if(nullptr == lazyBody) {
+        return error(DiagnosticCode::kUnexpectedEndOfFile);
+      }
+    } else {
+      block = parseBlock();
+    }
   } else if(peek(Token::kNewLine)) {
     flags |= ACC_ABSTRACT;
   } else {
-    return error("Expected ':', '{' or '\n'.");
+    return error(DiagnosticCode::kExpectedReturnType);
   }
 
   if((flags & ACC_ABSTRACT) != 0 && block != nullptr) {
-    return error("Internal error.");
+    return error(DiagnosticCode::kInternalError);
   }
 
   result->init(name, type, block, flags);
+  result->lazyBody(lazyBody);
 
   return result;
 }
 
+//
+// Skips a block in braces by counting the braces of the tokens that
+// follow. The lexer takes care of braces in strings and comments.
+//
+ast::LazyBody* Parser::skipBody() {
+  const auto offset = m_lexer->posOffset();
+  int depth = 0;
+
+  while(YES) {
+    if(peek(Token::kLBrace)) {
+      ++depth;
+    } else if(peek(Token::kRBrace)) {
+      if(0 == --depth) {
+        break;
+      }
+    } else if(peek(Token::kEof)) {
+      return nullptr;
+    }
+
+    advance();
+  }
+
+  auto result = new (m_arena) ast::LazyBody();
+  result->init(m_source, offset, m_lexer->posOffset() + 1 - offset);
+
+  // Continue with the token after the closing brace.
+  advance();
+
+  return result;
+}
+
+void Parser::recordRange(ast::Node* declaration, size_t offset) {
+  switch(declaration->kind()) {
+    case ast::NodeKind::kClass:
+    case ast::NodeKind::kFunction:
+    case ast::NodeKind::kModule:
+    case ast::NodeKind::kVariable:
+      // The current token is the one that ends the declaration.
+      static_cast<ast::Declaration*>(declaration)->sourceRange(
+        static_cast<uint32_t>(offset),
+        static_cast<uint32_t>(m_lexer->posOffset() - offset));
+      break;
+    default:
+      break;
+  }
+}
+
+ast::Node* Parser::parseDeclarationAt(
+    const char* source, size_t size, size_t offset, size_t length,
+    NameTable* names, Arena* arena, Diagnostics* diagnostics) {
+  // The stream covers the rest of the source so the lexer sees the
+  // same characters a parse of the whole source would see. Errors
+  // are only reported once the declaration is known to fit.
+  MemoryCharStream stream(source + offset, size - offset);
+  Lexer lexer;
+  Parser parser(&lexer, names, arena);
+  Diagnostics errors;
+
+  parser.diagnostics(&errors);
+
+  lexer.init(&stream, offset);
+  parser.advance();
+
+  const auto start = lexer.posOffset();
+  auto result = parser.peek(Token::kModule) ? parser.parseModule() : parser.parseDeclaration();
+
+  if(nullptr == result || !parser.peek(Token::kNewLine) ||
+     start != offset || lexer.posOffset() != offset + length) {
+    return nullptr;
+  }
+
+  switch(result->kind()) {
+    case ast::NodeKind::kClass:
+    case ast::NodeKind::kFunction:
+    case ast::NodeKind::kModule:
+    case ast::NodeKind::kVariable:
+      parser.recordRange(result, offset);
+
+      for(int i = 0; i < errors.size(); ++i) {
+        auto& error = errors.at(i);
+        diagnostics->report(error.m_code, error.m_offset, error.m_args[0], error.m_args[1]);
+      }
+
+      return result;
+    default:
+      return nullptr;
+  }
+}
+
+ast::Node* Parser::parseLazyBody(
+    const ast::LazyBody* body, NameTable* names, Arena* arena, Diagnostics* diagnostics) {
+  MemoryCharStream stream(body->source() + body->offset(), body->length());
+  Lexer lexer;
+  Parser parser(&lexer, names, arena);
+
+  parser.diagnostics(diagnostics);
+
+  lexer.init(&stream, body->offset());
+  parser.advance();
+
+  return parser.parseBlock();
+}
+
 bool Parser::parseParameterList(ast::NodeList* list) {
   int arity = 0;
 
@@ -542,7 +710,7 @@ ast::Node* Parser::parseParameter() {
   auto name = parseIdentifier();
   EXPECT(Token::kColon);
   auto type = parseType();
-  auto result = alloc<ast::Parameter>();
+  auto result = alloc<ast::Parameter>(name->offset());
 
   result->init(name, type);
 
@@ -588,7 +756,7 @@ ast::Node* Parser::parseExpression(bool allowInfixCall) {
         ++arity;
 
         if(arity > consts::MaxTupleArity) {
-          return error("Tuple exceeds max arity.");
+          return error(DiagnosticCode::kTooManyTupleElements);
         }
       } while(!poll(Token::kRParen));
     } else {
@@ -626,7 +794,7 @@ ast::Node* Parser::parsePrimaryExpression() {
   } else if(peek(Token::kThis)) {
     return parseThis();
   } else {
-    return error("Expected primary expression.");
+    return error(DiagnosticCode::kExpectedPrimaryExpression);
   }
 }
 
@@ -644,7 +812,7 @@ bool Parser::peekPrimaryExpression() {
 ast::Node* Parser::continueWithExpression(
     ast::Node* expression, bool allowInfixCall) {
   if(nullptr == expression) {
-    return error("Expected expression.");
+    return error(DiagnosticCode::kExpectedExpression);
   } else {
     while(true) {
       if(peek(Token::kDot)) {
@@ -654,7 +822,7 @@ ast::Node* Parser::continueWithExpression(
         //TODO(joa): implement ref
         //auto ref = parseRef(expression);
         //expression = ref;
-        expression = error("TODO: implement #-select");
+        expression = error(DiagnosticCode::kHashSelectNotImplemented);
       } else if(peek(Token::kLParen) ||
           (allowInfixCall && peek(Token::kIdentifier))) {
         auto call = parseCall(expression);
@@ -679,7 +847,7 @@ ast::Node* Parser::parseSelect(ast::Node* object) {
   EXPECT(Token::kDot);
 
   auto qualifier = parseIdentifier();
-  auto result = alloc<ast::Select>();
+  auto result = alloc<ast::Select>(object->offset());
 
   result->init(object, qualifier);
 
@@ -694,7 +862,7 @@ ast::Node* Parser::parseSelect(ast::Node* object) {
 ast::Node* Parser::parseAssign(ast::Node* target) {
   EXPECT(Token::kAssign);
 
-  auto result = alloc<ast::Assign>();
+  auto result = alloc<ast::Assign>(target->offset());
   auto isForced = poll(Token::kForce);
 
   result->init(target, parseExpression(), isForced);
@@ -708,7 +876,7 @@ ast::Node* Parser::parseAssign(ast::Node* target) {
 //  | Expression Identifier SingleArgument
 //
 ast::Node* Parser::parseCall(ast::Node* callee) {
-  auto result = alloc<ast::Call>();
+  auto result = alloc<ast::Call>(callee->offset());
 
   if(poll(Token::kLParen)) {
     if(!peek(Token::kRParen)) {
@@ -720,14 +888,14 @@ ast::Node* Parser::parseCall(ast::Node* callee) {
     result->init(callee);
   } else if(peek(Token::kIdentifier)) {
     auto name = parseIdentifier();
-    auto select = alloc<ast::Select>();
+    auto select = alloc<ast::Select>(callee->offset());
 
     select->init(callee, name);
     result->init(select);
 
     result->arguments()->add(parseSingleArgument(), m_arena);
   } else {
-    return error("Expected call.");
+    return error(DiagnosticCode::kExpectedCall);
   }
 
   return result;
@@ -799,9 +967,10 @@ ast::Node* Parser::parseSingleArgument() {
 //    (':' Type?) ->' Block NEWLINE* '}'
 //
 ast::Node* Parser::parseAnonymousFunctionExpression() {
+  const auto offset = m_lexer->posOffset();
   EXPECT(Token::kLBrace);
   pollAll(Token::kNewLine);
-  auto result = alloc<ast::Function>();
+  auto result = alloc<ast::Function>(offset);
   parseAnonymousFunctionParameterList(result->parameters());
   ast::Node* returnType = nullptr;
   if(poll(Token::kColon)) {
@@ -831,7 +1000,7 @@ void Parser::parseAnonymousFunctionParameterList(ast::NodeList* parameters) {
 ast::Node* Parser::parseAnonymousFunctionParameter() {
   auto ident = parseIdentifier();
   auto type = poll(Token::kColon) ? parseType() : nullptr;
-  auto result = alloc<ast::Parameter>();
+  auto result = alloc<ast::Parameter>(ident->offset());
   result->init(ident, type);
   return result;
 }
@@ -841,11 +1010,13 @@ ast::Node* Parser::parseAnonymousFunctionParameter() {
 //  : 'this'
 //
 ast::Node* Parser::parseThis() {
+  const auto offset = m_lexer->posOffset();
+
   if(poll(Token::kThis)) {
-    return alloc<ast::This>();
+    return alloc<ast::This>(offset);
   }
 
-  return error("Expected this.");
+  return error(DiagnosticCode::kExpectedThis);
 }
 
 //
@@ -856,12 +1027,14 @@ ast::Node* Parser::parseThis() {
 //  | 'false'
 //
 ast::Node* Parser::parseBooleanLiteral() {
+  const auto offset = m_lexer->posOffset();
+
   if(poll(Token::kTrue) || poll(Token::kYes)) {
-    return alloc<ast::True>();
+    return alloc<ast::True>(offset);
   } else if(poll(Token::kFalse) || poll(Token::kNo)) {
-    return alloc<ast::False>();
+    return alloc<ast::False>(offset);
   } else {
-    return error("Expected boolean literal.");
+    return error(DiagnosticCode::kExpectedBooleanLiteral);
   }
 }
 
@@ -916,7 +1089,7 @@ ast::Node* Parser::parseIfCase() {
   auto condition = parseExpression();
   EXPECT(Token::kRArrow);
   auto block = parseExpression();
-  auto result = alloc<ast::IfCase>();
+  auto result = alloc<ast::IfCase>(condition->offset());
   result->init(condition, block);
   return result;
 }
@@ -928,6 +1101,7 @@ ast::Node* Parser::parseIfCase() {
 ast::Node* Parser::parseVariable(unsigned int flags) {
   UNUSED(flags);
 
+  const auto offset = m_lexer->posOffset();
   bool modifiable = NO;
   bool isForced = NO;
 
@@ -936,7 +1110,7 @@ ast::Node* Parser::parseVariable(unsigned int flags) {
   } else if(poll(Token::kVal)) {
     modifiable = NO;
   } else {
-    return error("Expected \"var\" or \"val\".");
+    return error(DiagnosticCode::kExpectedVarOrVal);
   }
 
   auto name = parseIdentifier();
@@ -955,10 +1129,10 @@ ast::Node* Parser::parseVariable(unsigned int flags) {
   }
 
   if(nullptr == init && nullptr == type) {
-    return error("Either a type or initializer must be given.");
+    return error(DiagnosticCode::kMissingTypeOrInitializer);
   }
 
-  auto result = alloc<ast::Variable>();
+  auto result = alloc<ast::Variable>(offset);
 
   result->init(modifiable, name, type, init, isForced);
 
@@ -989,7 +1163,7 @@ ast::Node* Parser::parseType() {
       ++arity;
 
       if(arity > consts::MaxTupleArity) {
-        return error("Tuple exceeds max arity.");
+        return error(DiagnosticCode::kTooManyTupleElements);
       }
     } while(!poll(Token::kRParen));
 
@@ -1004,7 +1178,7 @@ ast::Node* Parser::parseType() {
       do {
         parseType();
       } while(poll(Token::kComma));
-      EXPECT(Token::kRBrace);
+      EXPECT(Token::kRBrac);
     }
 
     if(poll(Token::kRArrow)) {
@@ -1039,7 +1213,7 @@ ast::Node* Parser::parseTypeParameterList(ast::NodeList* list) {
 //
 ast::Node* Parser::parseTypeParameter() {
   auto name = parseIdentifier();
-  auto result = alloc<ast::TypeParameter>();
+  auto result = alloc<ast::TypeParameter>(name->offset());
 
   if(poll(Token::kRArrow)) {
     auto bound = parseType();
@@ -1069,7 +1243,14 @@ ast::Node* Parser::parseIdentifier() {
 
 template<class T>
 T* Parser::alloc() {
-  return new (m_arena) T();
+  return alloc<T>(m_lexer->posOffset());
+}
+
+template<class T>
+T* Parser::alloc(size_t offset) {
+  auto result = new (m_arena) T();
+  result->offset(static_cast<uint32_t>(offset));
+  return result;
 }
 
 template<class T>
@@ -1079,16 +1260,25 @@ T* Parser::allocWithValue() {
   // character.
 
   auto result = alloc<T>();
-  auto name = m_names->get(m_lexer->value(), m_lexer->valueLength(), /*copyValue=*/YES);
+  auto name = m_names->get(m_lexer->value(), m_lexer->valueLength());
 
   result->init(name);
 
   return result;
 }
 
-ast::Node* Parser::error(const char* value) {
+ast::Node* Parser::error(DiagnosticCode code) {
+  return error(code, 0, 0);
+}
+
+ast::Node* Parser::error(DiagnosticCode code, uint32_t arg0, uint32_t arg1) {
   auto result = alloc<ast::Error>();
-  result->init(value, m_lexer->posLine(), m_lexer->posColumn());
+  result->init(code, arg0, arg1);
+
+  if(nullptr != m_diagnostics) {
+    m_diagnostics->report(code, result->offset(), arg0, arg1);
+  }
+
   return result;
 }
 
@@ -1109,6 +1299,54 @@ void Parser::pollAll(const Token& token) {
   while(poll(token));
 }
 
+bool Parser::expectNewLine(ast::Node* element, size_t offset, int depth, ast::NodeList* list) {
+  if(poll(Token::kNewLine)) {
+    return YES;
+  }
+
+  // An element that is an error has been reported already.
+  if(ast::NodeKind::kError != element->kind()) {
+    list->add(error(DiagnosticCode::kExpectedToken,
+      static_cast<uint32_t>(Token::kNewLine), static_cast<uint32_t>(m_currentToken)), m_arena);
+  }
+
+  synchronize(depth);
+
+  // An element that failed at its first token would fail there again.
+  if(m_lexer->posOffset() == offset && !peek(Token::kRBrace) && !peek(Token::kEof)) {
+    advance();
+    synchronize(depth);
+  }
+
+  pollAll(Token::kNewLine);
+
+  return !peek(Token::kEof);
+}
+
+void Parser::synchronize(int depth) {
+  while(m_depth >= depth) {
+    if(m_depth == depth) {
+      switch(m_currentToken) {
+        case Token::kRBrace:
+        case Token::kNewLine:
+        case Token::kDef:
+        case Token::kClass:
+        case Token::kVal:
+        case Token::kVar:
+          return;
+        default:
+          break;
+      }
+    }
+
+    if(peek(Token::kEof)) {
+      return;
+    }
+
+    advance();
+  }
+}
+
 ast::Node* Parser::consume(
     const Token& token,
     std::function<ast::Node*()> f) { //NOLINT
@@ -1118,16 +1356,25 @@ ast::Node* Parser::consume(
     return result;
   }
 
-  //TODO(joa): build more meaningful error message.
+  const auto unexpected = m_currentToken;
+
   advance();
 
-  return error("Error: Unexpected token.");
+  return error(DiagnosticCode::kUnexpectedToken, static_cast<uint32_t>(unexpected), 0);
 }
 
 void Parser::advance() {
+  if(peek(Token::kLBrace)) {
+    ++m_depth;
+  } else if(peek(Token::kRBrace)) {
+    --m_depth;
+  }
+
   do {
     m_currentToken = m_lexer->nextToken();
   } while(isIgnored(m_currentToken));
+
+  ++m_numTokens;
 }
 
 bool Parser::isIgnored(const Token& token) {
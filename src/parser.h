@@ -4,6 +4,7 @@
 #include "brutus.h"
 #include "arena.h"
 #include "ast.h"
+#include "diagnostics.h"
 #include "lexer.h"
 #include "name.h"
 
@@ -25,7 +26,49 @@ namespace brutus {
         explicit Parser(Lexer* lexer, NameTable* names, Arena* arena)
             :  m_lexer(lexer),
                m_names(names),
-               m_arena(arena) {}
+               m_arena(arena),
+               m_diagnostics(nullptr),
+               m_source(nullptr),
+               m_currentToken(Token::kEof),
+               m_depth(0),
+               m_numTokens(0) {}
+
+        // Syntax errors are reported to the given diagnostics in
+        // addition to being returned as ast::Error nodes.
+        void diagnostics(Diagnostics* value) {
+          m_diagnostics = value;
+        }
+
+        // Tokens read so far, not counting whitespace and comments.
+        ALWAYS_INLINE int numTokens() const {
+          return m_numTokens;
+        }
+
+        // Enables outline mode. In outline mode the bodies of functions
+        // in braces are skipped and only their source range is kept.
+        // The source must be the characters the lexer reads from and
+        // outlive the AST. Passing nullptr disables outline mode.
+        void outline(const char* source) {
+          m_source = source;
+        }
+
+        bool isOutline() const {
+          return nullptr != m_source;
+        }
+
+        // Parses a body that has been skipped in outline mode.
+        static ast::Node* parseLazyBody(
+          const ast::LazyBody* body, NameTable* names, Arena* arena,
+          Diagnostics* diagnostics);
+
+        // Parses a module or the declaration of a module that starts at
+        // the given offset of the source. Returns nullptr unless the
+        // source at the offset is one that ends with a newline after
+        // exactly length characters, like it would in a parse of the
+        // whole source.
+        static ast::Node* parseDeclarationAt(
+          const char* source, size_t size, size_t offset, size_t length,
+          NameTable* names, Arena* arena, Diagnostics* diagnostics);
 
         ast::Node* parseProgram();
         ast::Node* parseModule();
@@ -69,19 +112,41 @@ namespace brutus {
         Lexer* const m_lexer;
         NameTable* const m_names;
         Arena* const m_arena;
+        Diagnostics* m_diagnostics;
+        const char* m_source;
         Token m_currentToken;
 
+        // Number of braces that have been opened before the current
+        // token and not closed yet.
+        int m_depth;
+        int m_numTokens;
+
         void advance();
         bool isIgnored(const Token& token);
         bool peek(const Token& token);
         bool poll(const Token& token);
         void pollAll(const Token& token);
+
+        // Panic mode recovery. If an element of a module, class or block
+        // is not followed by a newline the error is reported and tokens
+        // are skipped until the list can continue at the next line, its
+        // closing brace or the keyword of a declaration. The list is the
+        // one whose opening brace left the parser at the given depth so
+        // an error inside a nested body never ends an outer list.
+        // Returns NO at the end of the source.
+        bool expectNewLine(ast::Node* element, size_t offset, int depth, ast::NodeList* list);
+        void synchronize(int depth);
         ast::Node* consume(
           const Token& token,
           std::function<ast::Node*()> f); //NOLINT
+        // Nodes start at the current token unless an offset is given.
         template<class T> T* alloc();
+        template<class T> T* alloc(size_t offset);
         template<class T> T* allocWithValue();
-        ast::Node* error(const char* value);
+        ast::Node* error(DiagnosticCode code);
+        ast::Node* error(DiagnosticCode code, uint32_t arg0, uint32_t arg1);
+        ast::LazyBody* skipBody();
+        void recordRange(ast::Node* declaration, size_t offset);
 
         DISALLOW_COPY_AND_ASSIGN(Parser);
     }; //class Parser
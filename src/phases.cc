@@ -1,5 +1,8 @@
 #include "phases.h"
+#include "cache.h"
 #include "compiler.h"
+#include "modules.h"
+#include "trace.h"
 #include "types.h"
 
 namespace brutus {
@@ -7,73 +10,228 @@ namespace internal {
 Phase::Phase(Context* context)
     : m_context(context) {}
 
-Stopwatch* Phase::stopwatch() {
-  return &m_stopwatch;
-}
+ast::Node* Phase::materialize(CompilationUnit* unit, ast::Function* function) {
+  if(function->hasLazyBody()) {
+    TRACE_SCOPE("parse", "materialize");
+    auto body = Parser::parseLazyBody(
+      function->lazyBody(), m_context->names(), unit->arena(), unit->diagnostics());
+
+    function->expr(body);
 
-void Phase::log() {
-  std::cout <<
-    name() << ": " <<
-    m_stopwatch.totalMS() << "ms, " <<
-    m_stopwatch.totalNS() << "ns" << std::endl;
+    if(nullptr != function->symbol()) {
+      SymbolsPhase symbols(m_context);
+      symbols.buildBodySymbols(unit, function);
+    }
+
+    // A link that finds the body is no longer skipped uses its symbols
+    // without waiting for the lock of the dependencies.
+    function->lazyBody(nullptr);
+  }
+
+  return function->expr();
 }
 
 //
 
-ParsePhase::ParsePhase(Context* context)
-    : Phase(context),
-      m_lexer(new internal::Lexer()),
-      m_parser(new internal::Parser(m_lexer, context->names(), context->arena())) {}
+ParseWorker::ParseWorker(Context* context)
+    : m_names(context->names()),
+      m_lexer(new internal::Lexer()) {}
 
-ParsePhase::~ParsePhase() {
+ParseWorker::~ParseWorker() {
   delete m_lexer;
-  delete m_parser;
 }
 
-const char* ParsePhase::name() {
-  return "ParsePhase";
-}
-
-void ParsePhase::apply(CompilationUnit* unit) {
+void ParseWorker::parse(CompilationUnit* unit, ParseCache* cache) {
   auto source = unit->source();
+  auto arena = unit->arena();
+  auto diagnostics = unit->diagnostics();
+  Parser parser(m_lexer, m_names, arena);
+
+  diagnostics->clear();
+  parser.diagnostics(diagnostics);
 
   switch(source->kind()) {
-    case SourceKind::kFile: {
+    case SourceKind::kFile:
+    case SourceKind::kMemory:
+    case SourceKind::kMapped: {
+        // The lexer runs on demand of the parser so lexing is part of
+        // this event. The number of tokens is attached to it.
+        TraceScope trace("parse", "lexAndParse");
         auto stream = unit->source()->newStream();
 
-        m_lexer->init(stream);
-        unit->ast(m_parser->parseProgram());
+        // The text is kept so the unit can be reparsed after an edit.
+        // Skipped bodies of a dependency are parsed later from their
+        // source range in the text as well.
+        auto text = readText(unit, stream);
+        const bool isOutline = unit->isDependency();
+        const bool isCached = nullptr != cache && cache->isOpen();
+        ast::Node* ast = nullptr;
+
+        if(isCached) {
+          // The cache is keyed by the text of the unit. An unchanged
+          // unit is loaded instead of parsed.
+          TRACE_SCOPE("cache", "load");
+          ast = cache->load(text->data(), text->size(), isOutline, arena, diagnostics);
+        }
+
+        if(nullptr == ast) {
+          MemoryCharStream textStream(text->data(), text->size());
+
+          m_lexer->init(&textStream);
+
+          if(isOutline) {
+            parser.outline(text->data());
+          }
+
+          ast = parser.parseProgram();
+
+          if(isCached) {
+            TRACE_SCOPE("cache", "store");
+            cache->store(text->data(), text->size(), isOutline, ast, diagnostics);
+          }
+        }
 
-        auto printer = new brutus::internal::ast::ASTPrinter(std::cout);
-        printer->print(unit->ast());
-        std::cout << std::endl;
+        unit->ast(ast);
 
+        unit->metrics()->add(Counter::kTokens, parser.numTokens());
+        trace.arg("tokens", parser.numTokens());
         delete stream;
       }
       break;
+    case SourceKind::kError:
 #ifdef DEBUG
-    default:
       std::cerr << "Unexpected source: " << static_cast<int>(source->kind()) << std::endl;
 #endif
+      break;
   }
 }
 
+ByteBuffer* ParseWorker::readText(CompilationUnit* unit, CharStream* stream) {
+  TraceScope trace("parse", "readText");
+  auto text = unit->text();
+  const char* data;
+  size_t size;
+
+  text->clear();
+
+  if(unit->source()->text(&data, &size)) {
+    text->append(data, size);
+  } else {
+    char buffer[0x1000];
+    size_t length = 0;
+
+    stream->foreach([&](char c) {
+      buffer[length++] = c;
+
+      if(length == sizeof(buffer)) { //NOLINT
+        text->append(buffer, length);
+        length = 0;
+      }
+    });
+    text->append(buffer, length);
+  }
+
+  trace.arg("bytes", static_cast<int64_t>(text->size()));
+
+  return text;
+}
+
+//
+
+ParsePhase::ParsePhase(Context* context, int numWorkers)
+    : Phase(context),
+      m_cache(nullptr),
+      m_numWorkers(numWorkers > 0 ? numWorkers : 1) {
+  m_workers = NewArray<ParseWorker*>(m_numWorkers);
+
+  for(int i = 0; i < m_numWorkers; ++i) {
+    m_workers[i] = nullptr;
+  }
+}
+
+ParsePhase::~ParsePhase() {
+  for(int i = 0; i < m_numWorkers; ++i) {
+    delete m_workers[i];
+  }
+
+  DeleteArray(m_workers);
+}
+
+const char* ParsePhase::name() {
+  return "ParsePhase";
+}
+
+ParseWorker* ParsePhase::worker(int index) {
+  // Workers are created by the thread that uses them first. A worker
+  // allocates in the arena of the unit it parses so parsing may overlap
+  // with other phases.
+  if(nullptr == m_workers[index]) {
+    m_workers[index] = new ParseWorker(m_context);
+  }
+
+  return m_workers[index];
+}
+
+void ParsePhase::cache(ParseCache* value) {
+  m_cache = value;
+}
+
+void ParsePhase::apply(CompilationUnit* unit) {
+  parse(unit, 0);
+}
+
+void ParsePhase::parse(CompilationUnit* unit, int worker) {
+  this->worker(worker)->parse(unit, m_cache);
+}
+
 //
 
 SymbolsPhase::SymbolsPhase(Context* context)
-    : Phase(context) {}
+    : Phase(context),
+      m_arena(nullptr) {}
 
 const char* SymbolsPhase::name() {
   return "SymbolsPhase";
 }
 
 void SymbolsPhase::apply(CompilationUnit* unit) {
+  m_arena = unit->arena();
   buildSymbols(unit->ast(), m_context->symbols()->global(), nullptr);
 }
 
-void SymbolsPhase::buildSymbols(ast::Node* node, syms::Scope* parentScope, syms::Symbol* parentSymbol) {
-#define K(x) ast::NodeKind::k##x
+void SymbolsPhase::enterModules(CompilationUnit* unit) {
+  auto ast = unit->ast();
+
+  if(nullptr == ast || ast::NodeKind::kProgram != ast->kind()) {
+    return;
+  }
+
+  m_arena = unit->arena();
+
+  static_cast<ast::Program*>(ast)->modules()->foreach([&](ast::Node* module) {
+    if(ast::NodeKind::kModule == module->kind()) {
+      buildModuleSymbol(static_cast<ast::Module*>(module), m_context->symbols()->global(), /*parentSymbol=*/nullptr);
+    }
+  });
+}
+
+void SymbolsPhase::enterDeclarations(CompilationUnit* unit) {
+  auto ast = unit->ast();
+
+  if(nullptr == ast || ast::NodeKind::kProgram != ast->kind()) {
+    return;
+  }
+
+  m_arena = unit->arena();
 
+  static_cast<ast::Program*>(ast)->modules()->foreach([&](ast::Node* module) {
+    if(ast::NodeKind::kModule == module->kind()) {
+      buildMemberSymbols(static_cast<ast::Module*>(module));
+    }
+  });
+}
+
+void SymbolsPhase::buildSymbols(ast::Node* node, syms::Scope* parentScope, syms::Symbol* parentSymbol) {
 #ifdef DEBUG
   if(nullptr == node) {
     std::cerr << "Node is null." << std::endl;
@@ -81,13 +239,12 @@ void SymbolsPhase::buildSymbols(ast::Node* node, syms::Scope* parentScope, syms:
   }
 #endif
 
+#define K(x) ast::NodeKind::k##x
+
   switch(node->kind()) {
     case K(Assign):
-    case K(Argument): {
-        auto symbol = new (m_context->arena()) syms::EmptySymbol();
-        symbol->init(parentSymbol, node);
-        node->symbol(symbol);
-      }
+    case K(Argument):
+      buildEmptySymbol(node, parentSymbol);
       break;
 
     case K(Block):
@@ -143,6 +300,12 @@ void SymbolsPhase::buildSymbols(ast::Node* node, syms::Scope* parentScope, syms:
 #undef K
 }
 
+void SymbolsPhase::buildEmptySymbol(ast::Node* node, syms::Symbol* parentSymbol) {
+  auto symbol = new (m_arena) syms::EmptySymbol();
+  symbol->init(parentSymbol, node);
+  node->symbol(symbol);
+}
+
 ALWAYS_INLINE static syms::Scope* newScope(Arena* arena, syms::Scope* parentScope, syms::ScopeKind kind) {
   auto result = new (arena) syms::Scope(arena);
   result->init(parentScope, kind);
@@ -150,7 +313,7 @@ ALWAYS_INLINE static syms::Scope* newScope(Arena* arena, syms::Scope* parentScop
   return result;
 }
 
-ALWAYS_INLINE static Name* nameOf(ast::Node* node) {
+ALWAYS_INLINE static NameId nameOf(ast::Node* node) {
 #ifdef DEBUG
   if(node->kind() != ast::NodeKind::kIdentifier) {
     std::cerr << "Invalid node." << std::endl;
@@ -161,9 +324,9 @@ ALWAYS_INLINE static Name* nameOf(ast::Node* node) {
 }
 
 void SymbolsPhase::buildClassSymbols(ast::Class* node, syms::Scope* parentScope, syms::Symbol* parentSymbol) {
-  auto scope = newScope(m_context->arena(), parentScope, syms::ScopeKind::kClass);
-  auto symbol = new (m_context->arena()) syms::ClassSymbol();
-  auto type = new (m_context->arena()) types::ClassType(symbol, 0, nullptr, 0, nullptr);
+  auto scope = newScope(m_arena, parentScope, syms::ScopeKind::kClass);
+  auto symbol = new (m_arena) syms::ClassSymbol();
+  auto type = new (m_arena) types::ClassType(symbol, 0, nullptr, 0, nullptr);
   auto name = nameOf(node->name());
 
   symbol->init(name, parentSymbol, node, scope, type);
@@ -176,9 +339,9 @@ void SymbolsPhase::buildClassSymbols(ast::Class* node, syms::Scope* parentScope,
 }
 
 void SymbolsPhase::buildFunctionSymbols(ast::Function* node, syms::Scope* parentScope, syms::Symbol* parentSymbol) {
-  auto scope = newScope(m_context->arena(), parentScope, syms::ScopeKind::kFunction);
-  auto symbol = new (m_context->arena()) syms::FunctionSymbol();
-  auto type = new (m_context->arena()) types::FunctionType(
+  auto scope = newScope(m_arena, parentScope, syms::ScopeKind::kFunction);
+  auto symbol = new (m_arena) syms::FunctionSymbol();
+  auto type = new (m_arena) types::FunctionType(
       symbol, 0, nullptr, parentSymbol->type(),
       node->parameters()->size(),
       node->parameters()->mapToArray<syms::Symbol*>(
@@ -189,7 +352,7 @@ void SymbolsPhase::buildFunctionSymbols(ast::Function* node, syms::Scope* parent
             default:
               return nullptr; //TODO(joa): fixme
           }
-        }, m_context->arena())
+        }, m_arena)
       , nullptr);
   auto name = nameOf(node->name());
 
@@ -207,21 +370,52 @@ void SymbolsPhase::buildFunctionSymbols(ast::Function* node, syms::Scope* parent
     node->parameters()->mapToArray<syms::Symbol*>(
           [&](ast::Node* node) -> syms::Symbol* {
             return node->symbol();
-          }, m_context->arena());
+          }, m_arena);
 
-  if(!node->isAbstract()) {
+  if(!node->isAbstract() && !node->hasLazyBody()) {
     buildSymbols(node->expr(), scope, symbol);
   }
 }
 
+void SymbolsPhase::buildBodySymbols(CompilationUnit* unit, ast::Function* node) {
+  auto symbol = node->symbol();
+
+  m_arena = unit->arena();
+
+  buildSymbols(node->expr(), symbol->scope(), symbol);
+}
+
+void SymbolsPhase::buildDeclarationSymbols(CompilationUnit* unit, ast::Node* declaration, ast::Module* module) {
+  auto symbol = module->symbol();
+
+  m_arena = unit->arena();
+
+  buildSymbols(declaration, symbol->scope(), symbol);
+}
+
+void SymbolsPhase::buildModuleSymbols(CompilationUnit* unit, ast::Module* node) {
+  m_arena = unit->arena();
+  buildSymbols(node, m_context->symbols()->global(), /*parentSymbol=*/nullptr);
+}
+
 void SymbolsPhase::buildModuleSymbols(ast::Module* node, syms::Scope* parentScope, syms::Symbol* parentSymbol) {
-  auto scope = newScope(m_context->arena(), parentScope, syms::ScopeKind::kModule);
-  auto symbol =  new (m_context->arena()) syms::ModuleSymbol();
+  buildModuleSymbol(node, parentScope, parentSymbol);
+  buildMemberSymbols(node);
+}
+
+void SymbolsPhase::buildModuleSymbol(ast::Module* node, syms::Scope* parentScope, syms::Symbol* parentSymbol) {
+  auto scope = newScope(m_arena, parentScope, syms::ScopeKind::kModule);
+  auto symbol =  new (m_arena) syms::ModuleSymbol();
   auto name = nameOf(node->name());
 
   symbol->init(name, parentSymbol, node, scope, nullptr); //TODO(joa): module type?
   node->symbol(symbol);
   parentScope->put(name, symbol);
+}
+
+void SymbolsPhase::buildMemberSymbols(ast::Module* node) {
+  auto symbol = node->symbol();
+  auto scope = symbol->scope();
 
   node->declarations()->foreach([&](ast::Node* declaration) {
     buildSymbols(declaration, scope, symbol);
@@ -229,7 +423,7 @@ void SymbolsPhase::buildModuleSymbols(ast::Module* node, syms::Scope* parentScop
 }
 
 void SymbolsPhase::buildVariableSymbol(ast::Variable* node, syms::Scope* parentScope, syms::Symbol* parentSymbol) {
-  auto symbol =  new (m_context->arena()) syms::VariableSymbol();
+  auto symbol =  new (m_arena) syms::VariableSymbol();
   auto name = nameOf(node->name());
 
   symbol->init(name, parentSymbol, node);
@@ -238,7 +432,7 @@ void SymbolsPhase::buildVariableSymbol(ast::Variable* node, syms::Scope* parentS
 }
 
 void SymbolsPhase::buildParameterSymbol(ast::Parameter* node, syms::Scope* parentScope, syms::Symbol* parentSymbol) {
-  auto symbol =  new (m_context->arena()) syms::VariableSymbol();
+  auto symbol =  new (m_arena) syms::VariableSymbol();
   auto name = nameOf(node->name());
 
   symbol->init(name, parentSymbol, node);
@@ -247,8 +441,8 @@ void SymbolsPhase::buildParameterSymbol(ast::Parameter* node, syms::Scope* paren
 }
 
 void SymbolsPhase::buildBlockScope(ast::Block* node, syms::Scope* parentScope, syms::Symbol* parentSymbol) {
-  auto scope = newScope(m_context->arena(), parentScope, syms::ScopeKind::kBlock);
-  auto symbol = new (m_context->arena()) syms::EmptySymbol();
+  auto scope = newScope(m_arena, parentScope, syms::ScopeKind::kBlock);
+  auto symbol = new (m_arena) syms::EmptySymbol();
 
   symbol->init(parentSymbol, node);
   node->scope(scope);
@@ -267,7 +461,7 @@ void SymbolsPhase::buildProgramScope(ast::Program* node, syms::Scope* symbolTabl
 
 
 void SymbolsPhase::buildIfSymbol(ast::If* node, syms::Scope* parentScope, syms::Symbol* parentSymbol) {
-  auto symbol = new (m_context->arena()) syms::EmptySymbol();
+  auto symbol = new (m_arena) syms::EmptySymbol();
 
   symbol->init(parentSymbol, node);
   node->symbol(symbol);
@@ -278,7 +472,7 @@ void SymbolsPhase::buildIfSymbol(ast::If* node, syms::Scope* parentScope, syms::
 }
 
 void SymbolsPhase::buildIfCaseSymbol(ast::IfCase* node, syms::Scope* parentScope, syms::Symbol* parentSymbol) {
-  auto symbol = new (m_context->arena()) syms::EmptySymbol();
+  auto symbol = new (m_arena) syms::EmptySymbol();
 
   symbol->init(parentSymbol, node);
   node->symbol(symbol);
@@ -288,21 +482,233 @@ void SymbolsPhase::buildIfCaseSymbol(ast::IfCase* node, syms::Scope* parentScope
 
 //
 
-LinkPhase::LinkPhase(Context* context)
-    : Phase(context) {}
+LinkPhase::LinkPhase(Context* context, std::recursive_mutex* dependencies)
+    : Phase(context),
+      m_unit(nullptr),
+      m_module(nullptr),
+      m_modulePath(nullptr),
+      m_units(nullptr),
+      m_dependencies(dependencies),
+      m_int(nullptr),
+      m_string(nullptr),
+      m_isIntResolved(NO),
+      m_isStringResolved(NO) {}
 
 const char* LinkPhase::name() {
   return "LinkPhase";
 }
 
 void LinkPhase::apply(CompilationUnit* unit) {
+  std::unique_lock<std::recursive_mutex> lock(*m_dependencies, std::defer_lock);
+
+  if(unit->isDependency()) {
+    lock.lock();
+  }
+
+  auto diagnostics = unit->diagnostics();
+
+  // A unit is linked again after a unit it depends on changed.
+  diagnostics->remove(DiagnosticCode::kNoSuchName);
+  diagnostics->remove(DiagnosticCode::kUnresolvedExpression);
+  diagnostics->remove(DiagnosticCode::kNoSuchModule);
+  unit->uses()->clear();
+
+  m_unit = unit;
+  m_module = nullptr;
+  m_isIntResolved = NO;
+  m_isStringResolved = NO;
   link(unit->ast(), m_context->symbols()->global(), /*parentType=*/nullptr);
 }
 
+void LinkPhase::modulePath(ModulePath* value) {
+  m_modulePath = value;
+}
+
+void LinkPhase::units(List<CompilationUnit*>* value) {
+  m_units = value;
+}
+
+CompilationUnit* LinkPhase::ownerOf(ast::Function* function) {
+  CompilationUnit* result = nullptr;
+
+  if(nullptr == m_units) {
+    return result;
+  }
+
+  // A skipped body refers to the text of its unit.
+  auto source = function->lazyBody()->source();
+
+  m_units->forall([&](CompilationUnit* unit) {
+    if(unit->isDependency() && unit->text()->data() == source) {
+      result = unit;
+    }
+
+    return nullptr == result;
+  });
+
+  return result;
+}
+
+void LinkPhase::linkSkippedBody(syms::Symbol* symbol) {
+  if(syms::SymbolKind::kOverload == symbol->kind()) {
+    static_cast<syms::OverloadSymbol*>(symbol)->foreach([this](syms::Symbol* alternative) {
+      linkSkippedBody(alternative);
+    });
+    return;
+  }
+
+  auto node = symbol->ast();
+
+  if(syms::SymbolKind::kFunction != symbol->kind() ||
+     nullptr == node ||
+     ast::NodeKind::kFunction != node->kind()) {
+    return;
+  }
+
+  auto function = static_cast<ast::Function*>(node);
+
+  if(!function->hasLazyBody()) {
+    return;
+  }
+
+  // Another unit may be parsing the body at the same time.
+  std::lock_guard<std::recursive_mutex> lock(*m_dependencies);
+
+  if(!function->hasLazyBody()) {
+    return;
+  }
+
+  auto owner = ownerOf(function);
+
+  if(nullptr == owner) {
+    return;
+  }
+
+  // The body is linked as part of the unit and the module that declare
+  // it. It is no longer skipped once it has been parsed so this
+  // happens once.
+  auto module = symbol->parent();
+
+  while(nullptr != module && syms::SymbolKind::kModule != module->kind()) {
+    module = module->parent();
+  }
+
+  auto unit = m_unit;
+  auto current = m_module;
+
+  m_unit = owner;
+  m_module = nullptr == module ? nullptr : static_cast<ast::Module*>(module->ast());
+  link(materialize(owner, function), symbol->scope(), symbol->type());
+  m_unit = unit;
+  m_module = current;
+}
+
+void LinkPhase::use(NameId module) {
+  auto uses = m_unit->uses();
+
+  if(-1 == uses->indexOf(module)) {
+    uses->addLast(module);
+  }
+}
+
+syms::Symbol* LinkPhase::findRequired(NameId name) {
+  syms::Symbol* result = nullptr;
+
+  if(nullptr == m_module) {
+    return result;
+  }
+
+  // Required modules are searched in the order they are required. A
+  // module is found by its own name as well, which is the only way to
+  // refer to one that has been loaded from an interface file.
+  m_module->dependencies()->forall([&](ast::Node* node) {
+    auto module = node->symbol();
+
+    if(nullptr == module || module->kind() != syms::SymbolKind::kModule) {
+      return YES;
+    }
+
+    result = module->name() == name ? module : module->scope()->getLocal(name);
+
+    return nullptr == result;
+  });
+
+  return result;
+}
+
+types::Type* LinkPhase::typeOf(ast::Node* node, syms::Scope* scope) {
+  // Only a type that is given by name is resolved. A name that is not
+  // a class is left untyped, the link phase does not report it.
+  if(nullptr == node || node->kind() != ast::NodeKind::kIdentifier) {
+    return nullptr;
+  }
+
+  auto name = static_cast<ast::Identifier*>(node)->name();
+  auto symbol = scope->get(name);
+
+  if(nullptr == symbol) {
+    symbol = findRequired(name);
+  }
+
+  if(nullptr == symbol || symbol->kind() != syms::SymbolKind::kClass) {
+    return nullptr;
+  }
+
+  return symbol->type();
+}
+
+syms::Symbol* LinkPhase::literalClass(NameId name, syms::Symbol** symbol, bool* isResolved) {
+  // The symbol table is shared by all workers, so it is only asked
+  // once per unit.
+  if(!*isResolved) {
+    *symbol = m_context->symbols()->get(name);
+    *isResolved = YES;
+  }
+
+  return *symbol;
+}
+
 syms::Symbol* LinkPhase::errorSymbol(syms::Symbol* parent, ast::Node* node, syms::ErrorReason reason) {
-  auto result = new (m_context->arena()) syms::ErrorSymbol();
+  // A node that is linked again keeps its error symbol, otherwise each
+  // link of a unit would allocate another one in its arena.
+  auto previous = node->symbol();
+  syms::ErrorSymbol* result = nullptr;
+  auto name = kInvalidName;
+
+  if(nullptr != previous && syms::SymbolKind::kError == previous->kind() && previous->ast() == node) {
+    result = static_cast<syms::ErrorSymbol*>(previous);
+  } else {
+    result = new (m_unit->arena()) syms::ErrorSymbol();
+  }
+
+  result->init(kInvalidName, parent, node, reason);
+
+  switch(node->kind()) {
+    case ast::NodeKind::kIdentifier:
+      name = static_cast<ast::Identifier*>(node)->name();
+      break;
+    case ast::NodeKind::kArgument:
+      name = nameOf(static_cast<ast::Argument*>(node)->name());
+      break;
+    case ast::NodeKind::kModuleDependency:
+      name = nameOf(static_cast<ast::ModuleDependency*>(node)->name());
+      break;
+    case ast::NodeKind::kSelect:
+      name = nameOf(static_cast<ast::Select*>(node)->qualifier());
+      break;
+    default:
+      break;
+  }
 
-  result->init(nullptr, parent, node, reason);
+  if(kInvalidName == name) {
+    m_unit->diagnostics()->report(DiagnosticCode::kUnresolvedExpression, node->offset());
+  } else if(syms::ErrorReason::kNoSuchModule == reason) {
+    m_unit->diagnostics()->report(DiagnosticCode::kNoSuchModule, node->offset(), name, 0);
+  } else if(syms::ErrorReason::kNoSuchMember == reason) {
+    m_unit->diagnostics()->report(DiagnosticCode::kNoSuchMember, node->offset(), name, 0);
+  } else {
+    m_unit->diagnostics()->report(DiagnosticCode::kNoSuchName, node->offset(), name, 0);
+  }
 
   return result;
 }
@@ -353,7 +759,6 @@ void LinkPhase::link(ast::Node* node, syms::Scope* parentScope, types::Type* par
         link(call->callee(), parentScope, parentType);
 
         auto calleeSymbol = call->callee()->symbol();
-        auto calleeType = calleeSymbol->type();
         auto calleeScope = calleeSymbol->scope();
 
         call->arguments()->foreach([&](ast::Node* argument) {
@@ -363,11 +768,11 @@ void LinkPhase::link(ast::Node* node, syms::Scope* parentScope, types::Type* par
             ast::Argument* arg = static_cast<ast::Argument*>(argument);
 
             if(arg->hasName()) {
-              auto parameterSymbol = calleeScope->get(nameOf(arg->name()));
+              auto parameterSymbol = nullptr == calleeScope ? nullptr : calleeScope->find(nameOf(arg->name()));
 
               if(nullptr == parameterSymbol) {
                 arg->symbol(
-                  errorSymbol(parentType->symbol(), arg, syms::ErrorReason::kNoSuchName));
+                  errorSymbol(nullptr == parentType ? nullptr : parentType->symbol(), arg, syms::ErrorReason::kNoSuchName));
               } else {
                 arg->symbol(parameterSymbol);
               }
@@ -402,8 +807,24 @@ void LinkPhase::link(ast::Node* node, syms::Scope* parentScope, types::Type* par
         auto scope = symbol->scope();
         auto type = symbol->type();
 
+        // The signature is part of the interface of the function and
+        // linked even if its body is skipped.
+        if(nullptr != type) {
+          static_cast<types::FunctionType*>(type)->returnType(typeOf(function->type(), scope));
+        }
+
+        function->parameters()->foreach([&](ast::Node* parameter) {
+          link(parameter, scope, type);
+        });
+
+        if(function->hasLazyBody() && m_unit->isDependency()) {
+          // Only the declarations of a dependency are linked. The body
+          // is linked once a name resolves to the function.
+          break;
+        }
+
         if(!function->isAbstract()) {
-          link(function->expr(), scope, type);
+          link(materialize(m_unit, function), scope, type);
         }
       }
       break;
@@ -421,17 +842,19 @@ void LinkPhase::link(ast::Node* node, syms::Scope* parentScope, types::Type* par
         auto symbol = parentScope->get(ident->name());
 
         if(nullptr == symbol) {
-          // Could not find name in current scope. Maybe we
-          // should try to find it
-
-          //TODO(joa): implement me
+          symbol = findRequired(ident->name());
+        } else if(symbol->kind() == syms::SymbolKind::kModule && nullptr == symbol->parent()) {
+          // The links of the unit depend on the declarations of any
+          // other module it refers to, required or not.
+          use(symbol->name());
         }
 
         if(nullptr == symbol) {
           ident->symbol(
-            errorSymbol(parentType->symbol(), ident, syms::ErrorReason::kNoSuchName));
+            errorSymbol(nullptr == parentType ? nullptr : parentType->symbol(), ident, syms::ErrorReason::kNoSuchName));
         } else {
           ident->symbol(symbol);
+          linkSkippedBody(symbol);
         }
       }
       break;
@@ -460,17 +883,41 @@ void LinkPhase::link(ast::Node* node, syms::Scope* parentScope, types::Type* par
         auto scope = symbol->scope();
         auto type = symbol->type();
 
+        m_module = module;
+
+        module->dependencies()->foreach([&](ast::Node* dependency) {
+          link(dependency, scope, type);
+        });
+
         module->declarations()->foreach([&](ast::Node* declaration) {
           link(declaration, scope, type);
         });
       }
       break;
-    case K(ModuleDependency):
+    case K(ModuleDependency): {
+        // A required module is declared by a unit, an image or else
+        // loaded from its interface file.
+        auto dependency = static_cast<ast::ModuleDependency*>(node);
+        auto name = nameOf(dependency->name());
+        auto symbol = m_context->symbols()->global()->getLocal(name);
+
+        if((nullptr == symbol || symbol->kind() != syms::SymbolKind::kModule) && nullptr != m_modulePath) {
+          symbol = m_modulePath->get(name);
+        }
+
+        use(name);
+
+        if(nullptr == symbol || symbol->kind() != syms::SymbolKind::kModule) {
+          dependency->symbol(
+            errorSymbol(nullptr, dependency, syms::ErrorReason::kNoSuchModule));
+        } else {
+          dependency->symbol(symbol);
+        }
+      }
       break;
     case K(Number): {
         auto number = static_cast<ast::Number*>(node);
-        auto symbol = m_context->symbols()->get(
-          m_context->names()->brutus_Int());
+        auto symbol = literalClass(m_context->names()->brutus_Int(), &m_int, &m_isIntResolved);
 
         if(nullptr == symbol) {
           // Only possible if predef is missing
@@ -481,8 +928,15 @@ void LinkPhase::link(ast::Node* node, syms::Scope* parentScope, types::Type* par
         }
       }
       break;
-    case K(Parameter):
-      // Parameter symbol has been built in SymbolsPhase
+    case K(Parameter): {
+        // Parameter symbol has been built in SymbolsPhase
+        auto parameter = static_cast<ast::Parameter*>(node);
+        auto symbol = parameter->symbol();
+
+        if(nullptr != symbol) {
+          symbol->type(typeOf(parameter->type(), parentScope));
+        }
+      }
       break;
     case K(Program): {
         auto program = static_cast<ast::Program*>(node);
@@ -498,22 +952,37 @@ void LinkPhase::link(ast::Node* node, syms::Scope* parentScope, types::Type* par
         link(select->qualifier(), parentScope, parentType);
 
         auto objectSymbol = select->object()->symbol();
-        auto objectType = objectSymbol->type();
+
+        if(syms::SymbolKind::kError == objectSymbol->kind()) {
+          // The object has been reported already.
+          select->symbol(objectSymbol);
+          break;
+        }
+
         auto objectScope = objectSymbol->scope();
-        auto symbol = objectScope->get(nameOf(select->qualifier()));
+        auto objectType = objectSymbol->type();
+
+        // A parameter or variable has no scope. Its members are those
+        // of the class of its type, if it has one.
+        if(nullptr == objectScope && nullptr != objectType && objectType->kind() == types::TypeKind::kClass) {
+          objectScope = objectType->symbol()->scope();
+        }
+
+        // The scope may belong to a unit that another worker links.
+        auto symbol = nullptr == objectScope ? nullptr : objectScope->find(nameOf(select->qualifier()));
 
         if(nullptr == symbol) {
           select->symbol(
-            errorSymbol(nullptr, select, syms::ErrorReason::kNoSuchName));
+            errorSymbol(nullptr, select, syms::ErrorReason::kNoSuchMember));
         } else {
           select->symbol(symbol);
+          linkSkippedBody(symbol);
         }
       }
       break;
     case K(String): {
         auto number = static_cast<ast::String*>(node);
-        auto symbol = m_context->symbols()->get(
-          m_context->names()->brutus_String());
+        auto symbol = literalClass(m_context->names()->brutus_String(), &m_string, &m_isStringResolved);
 
         if(nullptr == symbol) {
           // Only possible if predef is missing
@@ -551,8 +1020,15 @@ void LinkPhase::link(ast::Node* node, syms::Scope* parentScope, types::Type* par
       break;
     case K(TypeParameter):
       break;
-    case K(Variable):
-      // Variable symbol has been built in SymbolsPhase
+    case K(Variable): {
+        // Variable symbol has been built in SymbolsPhase
+        auto variable = static_cast<ast::Variable*>(node);
+        auto symbol = variable->symbol();
+
+        if(nullptr != symbol) {
+          symbol->type(typeOf(variable->type(), parentScope));
+        }
+      }
       break;
     default:
       std::cerr << "Internal error." << std::endl;
@@ -1,13 +1,16 @@
 #ifndef _BRUTUS_PHASES_H
 #define _BRUTUS_PHASES_H
 
+#include <mutex>
+
 #include "brutus.h"
 #include "arena.h"
-#include "stopwatch.h"
+#include "buffer.h"
 #include "ast.h"
 #include "scopes.h"
 #include "symbols.h"
 #include "lexer.h"
+#include "list.h"
 #include "parser.h"
 
 #define PHASE_OVERRIDES() \
@@ -19,32 +22,72 @@ namespace brutus {
   class Context;
 
   namespace internal {
+    class ModulePath;
+    class ParseCache;
+
     class Phase {
       public:
         explicit Phase(Context* context);
         virtual ~Phase() {}
         virtual const char* name() = 0;
         virtual void apply(CompilationUnit* unit) = 0;
-        Stopwatch* stopwatch();
-        void log();
 
       protected:
         Context* m_context;
 
+        // Returns the body of a function of the given unit and parses
+        // it first if it has been skipped in outline mode. The symbols
+        // of the body are entered as well if the function already has
+        // a symbol.
+        ast::Node* materialize(CompilationUnit* unit, ast::Function* function);
+
       private:
-        Stopwatch m_stopwatch;
         DISALLOW_COPY_AND_ASSIGN(Phase);
     };
 
+    // Parses units with its own lexer so that several workers can
+    // parse at the same time. The AST of a unit is allocated in the
+    // arena of the unit.
+    class ParseWorker {
+      public:
+        explicit ParseWorker(Context* context);
+        ~ParseWorker();
+
+        // Units found in the given cache are loaded instead. The cache
+        // may be nullptr.
+        void parse(CompilationUnit* unit, ParseCache* cache);
+
+      private:
+        NameTable* const m_names;
+        Lexer* m_lexer;
+
+        // Reads all characters of the unit into its text.
+        ByteBuffer* readText(CompilationUnit* unit, CharStream* stream);
+
+        DISALLOW_COPY_AND_ASSIGN(ParseWorker);
+    };
+
     class ParsePhase : public Phase {
       public:
-        explicit ParsePhase(Context* context);
+        explicit ParsePhase(Context* context, int numWorkers);
         ~ParsePhase();
         PHASE_OVERRIDES();
 
+        // Parses the unit with the given worker. Different workers may
+        // parse at the same time.
+        void parse(CompilationUnit* unit, int worker);
+
+        // Units are looked up in the given cache before they are parsed
+        // and stored in it afterwards. Applies to the units parsed
+        // after it has been set.
+        void cache(ParseCache* value);
+
       private:
-        Lexer* m_lexer;
-        Parser* m_parser;
+        ParseCache* m_cache;
+        ParseWorker** m_workers;
+        const int m_numWorkers;
+
+        ParseWorker* worker(int index);
 
         DISALLOW_COPY_AND_ASSIGN(ParsePhase);
     };
@@ -54,11 +97,37 @@ namespace brutus {
         explicit SymbolsPhase(Context* context);
         PHASE_OVERRIDES();
 
+        // Same as apply in two steps. The modules of a unit are entered
+        // into the global scope first, which other units see. Their
+        // declarations only go into the scopes of the unit, so those of
+        // one unit may be entered while other units are linked.
+        void enterModules(CompilationUnit* unit);
+        void enterDeclarations(CompilationUnit* unit);
+
+        // Enters the symbols of a body that has been parsed after the
+        // declaration of its function.
+        void buildBodySymbols(CompilationUnit* unit, ast::Function* node);
+
+        // Enters the symbols of a declaration of the given module that
+        // has been parsed after the module.
+        void buildDeclarationSymbols(CompilationUnit* unit, ast::Node* declaration, ast::Module* module);
+
+        // Enters the symbols of a module that has been parsed after the
+        // other modules of its unit.
+        void buildModuleSymbols(CompilationUnit* unit, ast::Module* node);
+
       private:
+        // Symbols, scopes and types are allocated in the arena of the
+        // unit they are declared in.
+        Arena* m_arena;
+
         void buildSymbols(ast::Node* node, syms::Scope* parentScope, syms::Symbol* parentSymbol);
+        void buildEmptySymbol(ast::Node* node, syms::Symbol* parentSymbol);
         void buildClassSymbols(ast::Class* node, syms::Scope* parentScope, syms::Symbol* parentSymbol);
         void buildFunctionSymbols(ast::Function* node, syms::Scope* parentScope, syms::Symbol* parentSymbol);
         void buildModuleSymbols(ast::Module* node, syms::Scope* parentScope, syms::Symbol* parentSymbol);
+        void buildModuleSymbol(ast::Module* node, syms::Scope* parentScope, syms::Symbol* parentSymbol);
+        void buildMemberSymbols(ast::Module* node);
         void buildVariableSymbol(ast::Variable* node, syms::Scope* parentScope, syms::Symbol* parentSymbol);
         void buildParameterSymbol(ast::Parameter* node, syms::Scope* parentScope, syms::Symbol* parentSymbol);
         void buildBlockScope(ast::Block* node, syms::Scope* parentScope, syms::Symbol* parentSymbol);
@@ -69,13 +138,45 @@ namespace brutus {
         DISALLOW_COPY_AND_ASSIGN(SymbolsPhase);
     };
 
+    // Several link phases of a compiler may link different units at
+    // the same time. A dependency is only linked while holding the
+    // given mutex since its skipped bodies are parsed and linked by
+    // whichever unit refers to them first.
     class LinkPhase : public Phase {
       public:
-        explicit LinkPhase(Context* context);
+        LinkPhase(Context* context, std::recursive_mutex* dependencies);
         PHASE_OVERRIDES();
 
+        // Required modules that are not declared by any unit are loaded
+        // from the interface files of the given path.
+        void modulePath(ModulePath* value);
+
+        // Only the declarations of a dependency are linked. The skipped
+        // body of a function of a dependency among the given units is
+        // parsed and linked once a link resolves a name to it.
+        void units(List<CompilationUnit*>* value);
+
       private:
+        CompilationUnit* m_unit;
+        ast::Module* m_module;
+        ModulePath* m_modulePath;
+        List<CompilationUnit*>* m_units;
+        std::recursive_mutex* const m_dependencies;
+
+        // The classes of number and string literals, looked up once
+        // per unit when the first literal is linked.
+        syms::Symbol* m_int;
+        syms::Symbol* m_string;
+        bool m_isIntResolved;
+        bool m_isStringResolved;
+
         void link(ast::Node* node, syms::Scope* scope, types::Type* parentType);
+        void use(NameId module);
+        syms::Symbol* findRequired(NameId name);
+        types::Type* typeOf(ast::Node* node, syms::Scope* scope);
+        syms::Symbol* literalClass(NameId name, syms::Symbol** symbol, bool* isResolved);
+        void linkSkippedBody(syms::Symbol* symbol);
+        CompilationUnit* ownerOf(ast::Function* function);
         syms::Symbol* errorSymbol(syms::Symbol* parent, ast::Node* node, syms::ErrorReason reason);
 
         DISALLOW_COPY_AND_ASSIGN(LinkPhase);
@@ -0,0 +1,268 @@
+#include <thread>
+
+#include "scheduler.h"
+#include "trace.h"
+
+namespace brutus {
+namespace internal {
+Task::Task(Function function)
+    : m_function(function),
+      m_numDependencies(0),
+      m_isFinished(NO),
+      m_successors(nullptr),
+      m_numSuccessors(0),
+      m_successorsSize(0) {}
+
+Task::~Task() {
+  if(nullptr != m_successors) {
+    DeleteArray(m_successors);
+  }
+}
+
+void Task::precede(Task* task) {
+  if(m_numSuccessors == m_successorsSize) {
+    auto newSize = m_successorsSize == 0 ? 4 : m_successorsSize << 1;
+    auto newSuccessors = NewArray<Task*>(newSize);
+
+    if(nullptr != m_successors) {
+      ArrayCopy(newSuccessors, m_successors, sizeof(Task*) * m_numSuccessors); //NOLINT
+      DeleteArray(m_successors);
+    }
+
+    m_successors = newSuccessors;
+    m_successorsSize = newSize;
+  }
+
+  m_successors[m_numSuccessors++] = task;
+  ++task->m_numDependencies;
+}
+
+//
+
+Scheduler::WorkQueue::WorkQueue()
+    : m_tasks(nullptr),
+      m_capacity(0),
+      m_head(0),
+      m_size(0) {}
+
+Scheduler::WorkQueue::~WorkQueue() {
+  if(nullptr != m_tasks) {
+    DeleteArray(m_tasks);
+  }
+}
+
+void Scheduler::WorkQueue::init(int capacity) {
+  // A task is queued at most once so the queue of a worker never holds
+  // more tasks than there are in the graph.
+  if(nullptr != m_tasks) {
+    DeleteArray(m_tasks);
+  }
+
+  m_tasks = NewArray<Task*>(capacity > 0 ? capacity : 1);
+  m_capacity = capacity > 0 ? capacity : 1;
+  m_head = 0;
+  m_size = 0;
+}
+
+void Scheduler::WorkQueue::push(Task* task) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  m_tasks[(m_head + m_size) % m_capacity] = task;
+  ++m_size;
+}
+
+Task* Scheduler::WorkQueue::pop() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if(0 == m_size) {
+    return nullptr;
+  }
+
+  --m_size;
+  return m_tasks[(m_head + m_size) % m_capacity];
+}
+
+Task* Scheduler::WorkQueue::steal() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if(0 == m_size) {
+    return nullptr;
+  }
+
+  auto result = m_tasks[m_head];
+
+  m_head = (m_head + 1) % m_capacity;
+  --m_size;
+
+  return result;
+}
+
+//
+
+Scheduler::Scheduler(int numWorkers)
+    : m_numWorkers(numWorkers > 0 ? numWorkers : 1),
+      m_queues(new WorkQueue[m_numWorkers]),
+      m_tasks(nullptr),
+      m_numTasks(0),
+      m_tasksSize(0),
+      m_numRemaining(0),
+      m_numReady(0) {}
+
+Scheduler::~Scheduler() {
+  for(int i = 0; i < m_numTasks; ++i) {
+    delete m_tasks[i];
+  }
+
+  if(nullptr != m_tasks) {
+    DeleteArray(m_tasks);
+  }
+
+  delete[] m_queues;
+}
+
+int Scheduler::defaultNumWorkers() {
+  const int numCores = static_cast<int>(std::thread::hardware_concurrency());
+  return numCores > 1 ? numCores : 1;
+}
+
+Task* Scheduler::newTask(Task::Function function) {
+  if(m_numTasks == m_tasksSize) {
+    auto newSize = m_tasksSize == 0 ? 16 : m_tasksSize << 1;
+    auto newTasks = NewArray<Task*>(newSize);
+
+    if(nullptr != m_tasks) {
+      ArrayCopy(newTasks, m_tasks, sizeof(Task*) * m_numTasks); //NOLINT
+      DeleteArray(m_tasks);
+    }
+
+    m_tasks = newTasks;
+    m_tasksSize = newSize;
+  }
+
+  auto result = new Task(function);
+  m_tasks[m_numTasks++] = result;
+
+  return result;
+}
+
+void Scheduler::run() {
+  if(0 == m_numTasks) {
+    return;
+  }
+
+  m_numRemaining = m_numTasks;
+  m_numReady = 0;
+
+  for(int i = 0; i < m_numWorkers; ++i) {
+    m_queues[i].init(m_numTasks);
+  }
+
+  // Tasks without dependencies are dealt out to all workers.
+  int worker = 0;
+
+  for(int i = 0; i < m_numTasks; ++i) {
+    if(0 == m_tasks[i]->m_numDependencies) {
+      m_queues[worker].push(m_tasks[i]);
+      worker = (worker + 1) % m_numWorkers;
+      ++m_numReady;
+    }
+  }
+
+  auto threads = NewArray<std::thread*>(m_numWorkers);
+
+  for(int i = 1; i < m_numWorkers; ++i) {
+    threads[i] = new std::thread([this, i]() { work(i); });
+  }
+
+  work(0);
+
+  for(int i = 1; i < m_numWorkers; ++i) {
+    threads[i]->join();
+    delete threads[i];
+  }
+
+  DeleteArray(threads);
+}
+
+void Scheduler::precede(Task* task, Task* successor) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if(!task->m_isFinished) {
+    task->precede(successor);
+  }
+}
+
+void Scheduler::work(int worker) {
+  Tracer::nameThread("worker", worker);
+
+  while(m_numRemaining > 0) {
+    auto task = next(worker);
+
+    if(nullptr == task) {
+      // All ready tasks are taken. The remaining ones wait for tasks
+      // that are still running on other workers.
+      std::unique_lock<std::mutex> lock(m_mutex);
+
+      m_ready.wait(lock, [this]() {
+        return m_numReady > 0 || 0 == m_numRemaining;
+      });
+
+      continue;
+    }
+
+    execute(task, worker);
+  }
+}
+
+Task* Scheduler::next(int worker) {
+  auto result = m_queues[worker].pop();
+
+  for(int i = 1; i < m_numWorkers && nullptr == result; ++i) {
+    result = m_queues[(worker + i) % m_numWorkers].steal();
+  }
+
+  if(nullptr != result) {
+    --m_numReady;
+  }
+
+  return result;
+}
+
+void Scheduler::execute(Task* task, int worker) {
+  task->m_function(worker);
+
+  {
+    // No successor is added once the task has finished so they are
+    // read without the lock below.
+    std::lock_guard<std::mutex> lock(m_mutex);
+    task->m_isFinished = YES;
+  }
+
+  int numReady = 0;
+
+  for(int i = 0; i < task->m_numSuccessors; ++i) {
+    auto successor = task->m_successors[i];
+
+    if(0 == --successor->m_numDependencies) {
+      m_queues[worker].push(successor);
+      ++numReady;
+    }
+  }
+
+  if(numReady > 0) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_numReady += numReady;
+
+    // This worker takes one of the tasks itself.
+    if(numReady > 1) {
+      m_ready.notify_all();
+    }
+  }
+
+  if(0 == --m_numRemaining) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_ready.notify_all();
+  }
+}
+} //namespace internal
+} //namespace brutus
@@ -0,0 +1,119 @@
+#ifndef BRUTUS_SCHEDULER_H_
+#define BRUTUS_SCHEDULER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+#include "brutus.h"
+#include "alloc.h"
+
+namespace brutus {
+  namespace internal {
+    // A unit of work in a task graph. A task becomes ready once all
+    // tasks that precede it have finished.
+    class Task {
+      public:
+        // The function is called with the index of the worker that runs
+        // the task so it can use per-worker state.
+        typedef std::function<void(int)> Function; //NOLINT
+
+        explicit Task(Function function);
+        ~Task();
+
+        // The given task may only run after this one has finished.
+        // Tasks that are running use Scheduler::precede instead.
+        void precede(Task* task);
+
+      private:
+        Function m_function;
+        std::atomic<int> m_numDependencies;
+        bool m_isFinished;
+        Task** m_successors;
+        int m_numSuccessors;
+        int m_successorsSize;
+
+        friend class Scheduler;
+
+        DISALLOW_COPY_AND_ASSIGN(Task);
+    }; //class Task
+
+    // Runs a graph of tasks on a pool of workers.
+    //
+    // Every worker has its own queue. A worker pushes the tasks that
+    // become ready to its own queue and takes the most recent one
+    // first. A worker without work steals the oldest task of another
+    // worker and sleeps until a task becomes ready if there is none.
+    //
+    // The calling thread is worker 0. A scheduler runs its graph once.
+    class Scheduler {
+      public:
+        explicit Scheduler(int numWorkers);
+        ~Scheduler();
+
+        // Creates a task that is owned by the scheduler.
+        Task* newTask(Task::Function function);
+
+        // Runs all tasks and returns once every one of them finished.
+        void run();
+
+        // Same as Task::precede but may be called by a running task, for
+        // dependencies that are only known once the graph runs. Nothing
+        // happens if the given task has finished already. The successor
+        // must depend on a task that has not finished, usually the one
+        // that calls this.
+        void precede(Task* task, Task* successor);
+
+        ALWAYS_INLINE int numWorkers() const {
+          return m_numWorkers;
+        }
+
+        // One worker per core.
+        static int defaultNumWorkers();
+
+      private:
+        // A queue of ready tasks. The owner pushes and pops at the
+        // tail while thieves take from the head.
+        class WorkQueue {
+          public:
+            explicit WorkQueue();
+            ~WorkQueue();
+            void init(int capacity);
+            void push(Task* task);
+            Task* pop();
+            Task* steal();
+
+          private:
+            std::mutex m_mutex;
+            Task** m_tasks;
+            int m_capacity;
+            int m_head;
+            int m_size;
+
+            DISALLOW_COPY_AND_ASSIGN(WorkQueue);
+        }; //class WorkQueue
+
+        const int m_numWorkers;
+        WorkQueue* m_queues;
+        Task** m_tasks;
+        int m_numTasks;
+        int m_tasksSize;
+        std::atomic<int> m_numRemaining;
+
+        // Idle workers wait for m_ready until there are queued tasks or
+        // all tasks have finished. m_numReady only grows while m_mutex
+        // is held so no wakeup is lost. m_mutex guards m_isFinished and
+        // the successors of running tasks as well.
+        std::mutex m_mutex;
+        std::condition_variable m_ready;
+        std::atomic<int> m_numReady;
+
+        void work(int worker);
+        Task* next(int worker);
+        void execute(Task* task, int worker);
+
+        DISALLOW_COPY_AND_ASSIGN(Scheduler);
+    }; //class Scheduler
+  } //namespace internal
+} //namespace brutus
+#endif
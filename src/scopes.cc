@@ -1,5 +1,6 @@
 #include "scopes.h"
 #include "symbols.h"
+#include "trace.h"
 
 namespace brutus {
 namespace internal {
@@ -9,7 +10,10 @@ const float Scope::DefaultLoadFactor = 0.75f;
 Scope::Scope(int initialCapacity, float loadFactor, Arena* arena)
     : m_arena(arena),
       m_size(0),
-      m_parent(nullptr) {
+      m_parent(nullptr),
+      m_resolved(nullptr),
+      m_resolvedVersion(0),
+      m_version(0) {
   int capacity = NextPow2(initialCapacity);
   m_loadFactor = loadFactor;
   m_threshold = static_cast<int>(static_cast<float>(capacity) * loadFactor);
@@ -20,7 +24,10 @@ Scope::Scope(Arena* arena)
     : m_arena(arena),
       m_size(0),
       m_parent(nullptr),
-      m_kind(ScopeKind::kUnknown) {
+      m_kind(ScopeKind::kUnknown),
+      m_resolved(nullptr),
+      m_resolvedVersion(0),
+      m_version(0) {
   m_loadFactor = DefaultLoadFactor;
   m_threshold = static_cast<int>(static_cast<float>(DefaultCapacity) * DefaultLoadFactor);
   m_tableSize = DefaultCapacity;
@@ -29,6 +36,12 @@ Scope::Scope(Arena* arena)
 void Scope::init(Scope* parent, ScopeKind kind) {
   m_parent = parent;
   m_kind = kind;
+
+  // Nothing has been resolved yet, which no version of the parents
+  // matches since the own version starts at one.
+  m_resolvedVersion = 0;
+  m_version.store(1, std::memory_order_relaxed);
+
   initTable();
 }
 
@@ -37,7 +50,7 @@ void Scope::initTable() {
   ArrayFill(m_table, 0, m_tableSize);
 }
 
-bool Scope::contains(Name* name) {
+bool Scope::contains(NameId name) {
   return get(name) != nullptr;
 }
 
@@ -45,30 +58,94 @@ bool Scope::contains(Symbol* symbol) {
   return contains(symbol->name());
 }
 
-Symbol* Scope::get(Name* name) {
-  const int hashCode = name->m_hashCode;
-  auto scope = this;
+Symbol* Scope::get(NameId name) {
+  // The global scope has no parents to search so a lookup is a single
+  // probe already.
+  if(nullptr == m_parent) {
+    return getLocal(name);
+  }
 
-  do {
-    const int keyIndex = indexOf(hashCode, scope->m_tableSize);
-    Symbol* entry = scope->m_table[keyIndex];
+  uint64_t parentVersion = 0;
 
-    while(entry != nullptr) {
-      if(entry->m_name == name) {
-        return entry;
-      }
+  for(auto scope = m_parent; nullptr != scope; scope = scope->m_parent) {
+    parentVersion += scope->m_version.load(std::memory_order_relaxed);
+  }
+
+  return get(name, parentVersion);
+}
+
+Symbol* Scope::get(NameId name, uint64_t parentVersion) {
+  const auto ownVersion = m_version.load(std::memory_order_relaxed);
+  const auto version = ownVersion + parentVersion;
+  const int resolvedIndex = indexOf(static_cast<int>(name), ResolvedCapacity);
+
+  if(version == m_resolvedVersion) {
+    auto& resolved = m_resolved[resolvedIndex];
+
+    if(resolved.m_name == name) {
+      return resolved.m_symbol;
+    }
+  } else {
+    if(nullptr == m_resolved) {
+      m_resolved = m_arena->newArray<Resolved>(ResolvedCapacity);
+    }
+
+    for(int i = 0; i < ResolvedCapacity; ++i) {
+      m_resolved[i].m_name = kInvalidName;
+      m_resolved[i].m_symbol = nullptr;
+    }
+
+    m_resolvedVersion = version;
+  }
 
-      entry = entry->m_next;
+  // The parents remember what they resolved as well so the sibling
+  // scopes of this one find the name there.
+  auto result = getLocal(name);
+
+  if(nullptr == result) {
+    result = nullptr == m_parent->m_parent
+      ? m_parent->getLocal(name)
+      : m_parent->get(name, parentVersion - m_parent->m_version.load(std::memory_order_relaxed));
+  }
+
+  auto& resolved = m_resolved[resolvedIndex];
+
+  resolved.m_name = name;
+  resolved.m_symbol = result;
+
+  return result;
+}
+
+Symbol* Scope::getLocal(NameId name) {
+  // Names are dense ids so the id itself is used as the hash code.
+  const int keyIndex = indexOf(static_cast<int>(name), m_tableSize);
+  Symbol* entry = m_table[keyIndex];
+
+  while(entry != nullptr) {
+    if(entry->m_name == name) {
+      return entry;
     }
 
-    scope = scope->m_parent;
-  } while(scope != nullptr);
+    entry = entry->m_next;
+  }
 
   return nullptr;
 }
 
-bool Scope::put(Name* name, Symbol* symbol) {
-  const int hashCode = name->m_hashCode;
+Symbol* Scope::find(NameId name) {
+  for(auto scope = this; nullptr != scope; scope = scope->m_parent) {
+    auto result = scope->getLocal(name);
+
+    if(nullptr != result) {
+      return result;
+    }
+  }
+
+  return nullptr;
+}
+
+bool Scope::put(NameId name, Symbol* symbol) {
+  const int hashCode = static_cast<int>(name);
   const int keyIndex = indexOf(hashCode, m_tableSize);
 
   Symbol* entry = m_table[keyIndex];
@@ -83,6 +160,7 @@ bool Scope::put(Name* name, Symbol* symbol) {
 
   symbol->m_next = m_table[keyIndex];
   m_table[keyIndex] = symbol;
+  m_version.fetch_add(1, std::memory_order_relaxed);
 
   if(m_size++ >= m_threshold) {
     resize(2 * m_tableSize);
@@ -95,8 +173,8 @@ bool Scope::put(Symbol* symbol) {
   return put(symbol->name(), symbol);
 }
 
-Symbol* Scope::putOrOverload(Name* name, Symbol* symbol) {
-  const int hashCode = name->m_hashCode;
+Symbol* Scope::putOrOverload(NameId name, Symbol* symbol) {
+  const int hashCode = static_cast<int>(name);
   const int keyIndex = indexOf(hashCode, m_tableSize);
 
   Symbol* prev = nullptr;
@@ -115,10 +193,13 @@ Symbol* Scope::putOrOverload(Name* name, Symbol* symbol) {
         overload->m_next = next->m_next;
         if(prev != nullptr) {
           prev->m_next = overload;
+        } else {
+          m_table[keyIndex] = overload;
         }
 
         overload->add(next);
         overload->add(symbol);
+        m_version.fetch_add(1, std::memory_order_relaxed);
 
         return overload;
       }
@@ -130,6 +211,7 @@ Symbol* Scope::putOrOverload(Name* name, Symbol* symbol) {
 
   symbol->m_next = m_table[keyIndex];
   m_table[keyIndex] = symbol;
+  m_version.fetch_add(1, std::memory_order_relaxed);
 
   if(m_size++ >= m_threshold) {
     resize(2 * m_tableSize);
@@ -138,6 +220,52 @@ Symbol* Scope::putOrOverload(Name* name, Symbol* symbol) {
   return symbol;
 }
 
+bool Scope::remove(Symbol* symbol) {
+  const auto name = symbol->name();
+  const int keyIndex = indexOf(static_cast<int>(name), m_tableSize);
+
+  Symbol* prev = nullptr;
+  Symbol* next = m_table[keyIndex];
+
+  while(next != nullptr) {
+    if(next->m_name == name) {
+      if(next != symbol) {
+        return next->kind() == SymbolKind::kOverload &&
+               static_cast<OverloadSymbol*>(next)->remove(symbol);
+      }
+
+      if(prev != nullptr) {
+        prev->m_next = next->m_next;
+      } else {
+        m_table[keyIndex] = next->m_next;
+      }
+
+      next->m_next = nullptr;
+      --m_size;
+      m_version.fetch_add(1, std::memory_order_relaxed);
+
+      return true;
+    }
+
+    prev = next;
+    next = next->m_next;
+  }
+
+  return false;
+}
+
+void Scope::foreach(std::function<void(Symbol*)> f) { //NOLINT
+  for(int i = 0; i < m_tableSize; ++i) {
+    auto symbol = m_table[i];
+
+    while(symbol != nullptr) {
+      // Read the next symbol first in case f moves the symbol.
+      auto next = symbol->m_next;
+      f(symbol);
+      symbol = next;
+    }
+  }
+}
 
 void Scope::resize(int newSize) {
   auto oldTable = m_table;
@@ -148,6 +276,7 @@ void Scope::resize(int newSize) {
     return;
   }
 
+  TraceScope trace("scopes", "resize", "capacity", newSize);
   Symbol** newTable = m_arena->newArray<Symbol*>(newSize);
   ArrayFill(newTable, 0, newSize);
   transfer(oldTable, oldSize, newTable, newSize);
@@ -164,7 +293,7 @@ void Scope::transfer(Symbol** src, int srcSize, Symbol** dst, int dstSize) {
     if (symbol != nullptr) {
       do {
         Symbol* next = symbol->m_next;
-        int index = indexOf(symbol->name()->m_hashCode, dstSize);
+        int index = indexOf(static_cast<int>(symbol->name()), dstSize);
 
         symbol->m_next = dst[index];
         dst[index] = symbol;
@@ -177,15 +306,20 @@ void Scope::transfer(Symbol** src, int srcSize, Symbol** dst, int dstSize) {
   ArrayFill(src, 0, srcSize);
 }
 
-Symbol* SymbolTable::get(Name* name) {
+Symbol* SymbolTable::get(NameId name) {
   // #1 lookup module of name
   // #2 lookup name in module
+  std::lock_guard<std::mutex> lock(m_resolvedMutex);
 
-  //TODO(joa): cache this lookup
+  auto cached = m_resolved.get(name);
+
+  if(nullptr != cached) {
+    return cached;
+  }
 
   Scope* currentScope = m_scope;
-  const char* chars = name->value();
-  int32_t length = name->length();
+  const char* chars = m_names->value(name);
+  int32_t length = m_names->length(name);
   int32_t lastIndex = 0;
 
   //TODO(joa): this is sloppy, what if name begins with '.'?
@@ -195,13 +329,13 @@ Symbol* SymbolTable::get(Name* name) {
       int32_t moduleNameLength = i - lastIndex;
 
       if(moduleNameLength > 0) {
+        // A name that has never been interned cannot be the name
+        // of any module so we do not intern it here.
+        auto moduleName = m_names->find(chars + lastIndex, moduleNameLength);
         auto symbol =
-          static_cast<ModuleSymbol*>(
-            currentScope->get(
-              m_names->get(
-                chars + lastIndex,
-                moduleNameLength,
-                /*copyValue=*/false)));
+          kInvalidName == moduleName
+            ? nullptr
+            : static_cast<ModuleSymbol*>(currentScope->find(moduleName));
 
         if(nullptr == symbol) {
 #ifdef DEBUG
@@ -221,8 +355,9 @@ Symbol* SymbolTable::get(Name* name) {
     }
   }
 
+  auto memberName = m_names->find(chars + lastIndex, length - lastIndex);
   auto result =
-    currentScope->get(m_names->get(chars + lastIndex, length - lastIndex, false));
+    kInvalidName == memberName ? nullptr : currentScope->find(memberName);
 
 #ifdef DEBUG
   if(nullptr == result) {
@@ -234,6 +369,10 @@ Symbol* SymbolTable::get(Name* name) {
   }
 #endif
 
+  if(nullptr != result) {
+    m_resolved.put(name, result);
+  }
+
   return result;
 }
 } //namespace syms
@@ -1,7 +1,9 @@
 #ifndef _BRUTUS_SCOPES_H
 #define _BRUTUS_SCOPES_H
 
+#include <atomic>
 #include <limits>
+#include <mutex>
 
 #include "brutus.h"
 #include "arena.h"
@@ -27,6 +29,9 @@ namespace brutus {
           static const int DefaultCapacity = 1 << 2;
           static const int MaximumCapacity = 1 << 30;
 
+          // The number of names whose resolution a scope remembers.
+          static const int ResolvedCapacity = 1 << 3;
+
           void* operator new(size_t size, Arena* arena) {
             return arena->alloc(size);
           }
@@ -44,23 +49,50 @@ namespace brutus {
           ~Scope() {}
 
           // true if it has been added, false otherwise
-          bool put(Name* name, Symbol* symbol);
+          bool put(NameId name, Symbol* symbol);
 
           bool put(Symbol* symbol);
 
-          Symbol* putOrOverload(Name* name, Symbol* symbol);
+          Symbol* putOrOverload(NameId name, Symbol* symbol);
+
+          // Removes a symbol of this scope. If the symbol is one of an
+          // overload only that alternative is removed. Returns false if
+          // the symbol is not a member of this scope.
+          bool remove(Symbol* symbol);
 
           // null if not present
-          Symbol* get(Name* name);
+          //
+          // The result is remembered by this scope so looking up the
+          // same name again is a single probe, unless this scope or one
+          // of its parents has changed in between.
+          Symbol* get(NameId name);
+
+          // Same as get but the parent scopes are not searched.
+          Symbol* getLocal(NameId name);
+
+          // Same as get but nothing is remembered, so other threads may
+          // look up names in the same scopes at the same time.
+          Symbol* find(NameId name);
 
           // true if present, false otherwise
-          bool contains(Name* name);
+          bool contains(NameId name);
 
           bool contains(Symbol* symbol);
 
+          // Calls f for each symbol of this scope. The symbols of
+          // the parent scopes are not visited.
+          void foreach(std::function<void(Symbol*)> f); //NOLINT
+
           void init(Scope* parent, ScopeKind kind);
 
         private:
+          // A name and what it resolved to, which may be nullptr.
+          class Resolved {
+            public:
+              NameId m_name;
+              Symbol* m_symbol;
+          };
+
           void* operator new(size_t size);
 
           Arena* const m_arena;
@@ -71,9 +103,20 @@ namespace brutus {
           float m_loadFactor;
           Scope* m_parent;
           ScopeKind m_kind;
+          Resolved* m_resolved;
+          uint64_t m_resolvedVersion;
+
+          // Incremented whenever a symbol is added to or removed from
+          // this scope. What a scope has resolved is valid as long as
+          // the sum of the versions of the scope and its parents has
+          // not changed, so a change of a scope only affects the scopes
+          // below it.
+          std::atomic<uint64_t> m_version;
+
+          // Same as get given the sum of the versions of the parents.
+          Symbol* get(NameId name, uint64_t parentVersion);
 
           void initTable();
-          int hashCodeOf(const char* value, int length);
           void resize(int newCapacity);
           void transfer(Symbol** src, int srcSize, Symbol** dst, int dstSize);
 
@@ -94,12 +137,8 @@ namespace brutus {
           DISALLOW_COPY_AND_ASSIGN(Scope);
       }; //class Scope
 
-      class SymbolTable : public ArenaMember {
+      class SymbolTable {
         public:
-          void* operator new(size_t size, Arena* arena) {
-            return arena->alloc(size);
-          }
-
           SymbolTable(NameTable* names, Arena* arena)
               : m_scope(new (arena) Scope(arena)),
                 m_names(names),
@@ -109,19 +148,30 @@ namespace brutus {
 
           ~SymbolTable() {}
 
-          Symbol* get(Name* name);
+          // Resolves a fully qualified name like "brutus.Int". Several
+          // threads may resolve names at the same time.
+          Symbol* get(NameId name);
+
+          // Forgets all resolved names. Must be called once a symbol
+          // has been removed from any scope.
+          ALWAYS_INLINE void invalidate() {
+            m_resolved.clear();
+          }
 
           ALWAYS_INLINE Scope* global() const {
             return m_scope;
           }
 
         private:
-          void* operator new(size_t size);
-
           Scope* const m_scope;
           NameTable* const m_names;
           Arena* const m_arena;
 
+          // Qualified names resolved by get(). Indexed by the id of
+          // the qualified name so a repeated lookup is a single load.
+          NameMap<Symbol*> m_resolved;
+          std::mutex m_resolvedMutex;
+
           DISALLOW_COPY_AND_ASSIGN(SymbolTable);
       }; // class SymbolTable
     } //namespace sym
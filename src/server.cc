@@ -0,0 +1,272 @@
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#ifndef OS_WINDOWS
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "../include/brutus.h"
+
+// Usage: brutus_server <socket>
+//
+// Keeps a compiler with the prelude resident and compiles the units
+// clients send over a Unix domain socket. The prelude is loaded from
+// prelude.img, or compiled from lang.b if there is no image, once at
+// startup. Every request only parses, enters and links its own units
+// on top of it. Their ASTs and symbols live in the arenas of their
+// units and are freed when the response has been sent.
+//
+// A connection may send any number of requests. A request is a list
+// of commands, one per line:
+//
+//   source <length>   followed by length characters of text
+//   file <path>       a file the server reads itself
+//   compile           compiles the sources of the request
+//   shutdown          stops the server
+//
+// The response to compile is a line per diagnostic, where unit is the
+// index of the source within the request, followed by a summary:
+//
+//   <unit>:<line>:<column>: error: <message>
+//   done <errors> <warnings> <microseconds>
+//
+// Requests are served one at a time.
+
+#ifndef OS_WINDOWS
+// Reads lines and blocks of bytes from a socket.
+class Connection {
+  public:
+    explicit Connection(int fd) : m_fd(fd), m_position(0) {}
+
+    bool readLine(std::string* line) {
+      line->clear();
+
+      for(;;) {
+        const auto end = m_buffer.find('\n', m_position);
+
+        if(std::string::npos != end) {
+          line->assign(m_buffer, m_position, end - m_position);
+          m_position = end + 1;
+          return true;
+        }
+
+        if(!fill()) {
+          return false;
+        }
+      }
+    }
+
+    bool readBytes(size_t length, std::string* bytes) {
+      while(m_buffer.size() - m_position < length) {
+        if(!fill()) {
+          return false;
+        }
+      }
+
+      bytes->assign(m_buffer, m_position, length);
+      m_position += length;
+      return true;
+    }
+
+    bool write(const std::string& text) {
+      auto data = text.data();
+      auto length = text.size();
+
+      while(length > 0) {
+        const auto result = ::write(m_fd, data, length);
+
+        if(result <= 0) {
+          return false;
+        }
+
+        data += result;
+        length -= static_cast<size_t>(result);
+      }
+
+      return true;
+    }
+
+  private:
+    const int m_fd;
+    std::string m_buffer;
+    size_t m_position;
+
+    bool fill() {
+      char chunk[0x10000];
+      const auto result = read(m_fd, chunk, sizeof(chunk)); //NOLINT
+
+      if(result <= 0) {
+        return false;
+      }
+
+      m_buffer.erase(0, m_position);
+      m_position = 0;
+      m_buffer.append(chunk, static_cast<size_t>(result));
+      return true;
+    }
+};
+
+void appendNumber(std::string* text, uint64_t value) {
+  text->append(std::to_string(static_cast<unsigned long long>(value))); //NOLINT
+}
+
+// Compiles the units of one request and writes the response. The
+// units are removed afterwards.
+bool compile(brutus::Session* session, Connection* connection, int firstUnit, std::string* response) {
+  int numErrors = 0;
+  int numWarnings = 0;
+
+  session->compile();
+  session->forEachMessage([&](const brutus::Message& message) {
+    if(message.m_unit < firstUnit) {
+      return;
+    }
+
+    const auto isError = brutus::Severity::kError == message.m_severity;
+
+    appendNumber(response, static_cast<uint64_t>(message.m_unit - firstUnit));
+    response->push_back(':');
+    appendNumber(response, message.m_line);
+    response->push_back(':');
+    appendNumber(response, message.m_column);
+    response->append(isError ? ": error: " : ": warning: ");
+    response->append(message.m_text);
+    response->push_back('\n');
+
+    if(isError) {
+      ++numErrors;
+    } else {
+      ++numWarnings;
+    }
+  });
+
+  response->append("done ");
+  appendNumber(response, static_cast<uint64_t>(numErrors));
+  response->push_back(' ');
+  appendNumber(response, static_cast<uint64_t>(numWarnings));
+  response->push_back(' ');
+  appendNumber(response, session->wallNS() / 1000);
+  response->push_back('\n');
+
+  session->clear();
+
+  const auto result = connection->write(*response);
+  response->clear();
+
+  return result;
+}
+
+// Serves the requests of a connection until it is closed. Returns
+// false if the server should stop.
+bool serve(brutus::Session* session, int fd) {
+  Connection connection(fd);
+  std::string line;
+  std::string text;
+  std::string response;
+  int firstUnit = session->numUnits();
+
+  while(connection.readLine(&line)) {
+    if(0 == line.compare(0, 7, "source ")) {
+      const auto length = static_cast<size_t>(strtoull(line.c_str() + 7, nullptr, 10));
+
+      if(!connection.readBytes(length, &text)) {
+        break;
+      }
+
+      session->addSource(text.data(), text.size());
+    } else if(0 == line.compare(0, 5, "file ")) {
+      if(-1 == session->addFile(line.c_str() + 5)) {
+        response.append("error Could not read \"" + line.substr(5) + "\".\n");
+      }
+    } else if("compile" == line) {
+      if(!compile(session, &connection, firstUnit, &response)) {
+        break;
+      }
+
+      firstUnit = session->numUnits();
+    } else if("shutdown" == line) {
+      session->clear();
+      return false;
+    } else {
+      response.append("error Unknown command \"" + line + "\".\n");
+    }
+  }
+
+  // Sources of an unfinished request are dropped with the connection.
+  session->clear();
+  return true;
+}
+#endif
+
+int main(int argc, char** argv) {
+#ifdef OS_WINDOWS
+  (void)argc;
+  (void)argv;
+  std::cerr << "The compile server needs Unix domain sockets." << std::endl;
+  return 1;
+#else
+  if(argc != 2) {
+    std::cerr << "Usage: brutus_server <socket>" << std::endl;
+    return 1;
+  }
+
+  const auto path = argv[1];
+  brutus::Session session;
+
+  if(!session.loadImage("prelude.img")) {
+    if(-1 == session.addDependency("lang.b")) {
+      std::cerr << "Could not read \"lang.b\"." << std::endl;
+      return 1;
+    }
+
+    session.compile();
+  }
+
+  struct sockaddr_un address;
+
+  if(strlen(path) >= sizeof(address.sun_path)) { //NOLINT
+    std::cerr << "The path of the socket is too long." << std::endl;
+    return 1;
+  }
+
+  memset(&address, 0, sizeof(address)); //NOLINT
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, path, sizeof(address.sun_path) - 1); //NOLINT
+
+  const auto listener = socket(AF_UNIX, SOCK_STREAM, 0);
+
+  unlink(path);
+
+  if(-1 == listener ||
+     0 != bind(listener, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) || //NOLINT
+     0 != listen(listener, 16)) {
+    std::cerr << "Could not listen on \"" << path << "\"." << std::endl;
+    return 1;
+  }
+
+  // A client that goes away must not take the server with it.
+  signal(SIGPIPE, SIG_IGN);
+
+  bool isRunning = true;
+
+  while(isRunning) {
+    const auto fd = accept(listener, nullptr, nullptr);
+
+    if(-1 == fd) {
+      continue;
+    }
+
+    isRunning = serve(&session, fd);
+    close(fd);
+  }
+
+  close(listener);
+  unlink(path);
+
+  return 0;
+#endif
+}
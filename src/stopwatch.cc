@@ -2,10 +2,14 @@
 
 namespace brutus {
 void Stopwatch::start() {
-  m_total = m_total.zero();
+  reset();
   m_start = now();  
 }
 
+void Stopwatch::reset() {
+  m_total = Duration::zero();
+}
+
 void Stopwatch::resume() {
   m_start = now(); 
 }
@@ -19,6 +23,10 @@ void Stopwatch::stop() {
   m_total += delta;
 }
 
+void Stopwatch::add(Duration duration) {
+  m_total += duration;
+}
+
 void Stopwatch::log() const {
   auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(m_total);
   auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(m_total);
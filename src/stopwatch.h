@@ -13,14 +13,21 @@ namespace brutus {
       typedef std::chrono::duration<Rep , Clock::period> Duration;
       typedef std::chrono::time_point<Clock> TimePoint;
 
-      explicit Stopwatch() {}
+      explicit Stopwatch() : m_total(Duration::zero()) {}
       void start();
       void stop();
       void pause(); 
       void resume();
       void log() const;
       void stopAndLog();
+
+      // Forgets the time measured so far.
+      void reset();
       void time(std::function<void()> f);
+
+      // Adds time that has been measured elsewhere, for instance by
+      // another thread.
+      void add(Duration duration);
       template<typename T> T time(std::function<T()> f);
       Duration total();
       Rep totalMS();
@@ -40,5 +40,22 @@ void FileCharStream::foreach(
     f(next());
   }
 }
+
+//
+
+bool MemoryCharStream::hasNext() {
+  return m_index < m_size;
+}
+
+char MemoryCharStream::next() {
+  return m_index < m_size ? m_data[m_index++] : '\0';
+}
+
+void MemoryCharStream::foreach(
+    std::function<void(char)> f) { //NOLINT
+  while(m_index < m_size) {
+    f(m_data[m_index++]);
+  }
+}
 } //namespace internal
 } //namespace brutus
@@ -37,6 +37,26 @@ namespace brutus {
 
         DISALLOW_COPY_AND_ASSIGN(FileCharStream);
     }; // class FileCharStream
+
+    // A stream over characters that are already in memory. The
+    // characters are not copied and must outlive the stream.
+    class MemoryCharStream : public CharStream {
+      public:
+        explicit MemoryCharStream(const char* data, size_t size) :
+          m_data(data),
+          m_size(size),
+          m_index(0) {}
+        bool hasNext();
+        char next();
+        void foreach(std::function<void(char)> f); //NOLINT
+
+      private:
+        const char* const m_data;
+        const size_t m_size;
+        size_t m_index;
+
+        DISALLOW_COPY_AND_ASSIGN(MemoryCharStream);
+    }; // class MemoryCharStream
   } //namespace internal
 } //namespace brutus
 #endif
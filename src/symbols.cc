@@ -10,7 +10,7 @@ SymbolKind ErrorSymbol::kind() const {
   return SymbolKind::kError;
 }
 
-void ErrorSymbol::init(Name* name, Symbol* parent, ast::Node* ast, ErrorReason reason) {
+void ErrorSymbol::init(NameId name, Symbol* parent, ast::Node* ast, ErrorReason reason) {
   Symbol::init(name, parent, ast, nullptr);//TODO(joa): ERROR TYPE
   m_reason = reason;
 }
@@ -28,7 +28,7 @@ SymbolKind OverloadSymbol::kind() const {
   return SymbolKind::kOverload;
 }
 
-void OverloadSymbol::init(Name* name, Symbol* parent, ast::Node* ast) {
+void OverloadSymbol::init(NameId name, Symbol* parent, ast::Node* ast) {
   Symbol::init(name, parent, ast, nullptr);//TODO(joa): OVERLOAD TYPE
 
   auto symbol = m_first;
@@ -44,6 +44,38 @@ void OverloadSymbol::add(Symbol* symbol) {
   m_first = symbol;
 }
 
+bool OverloadSymbol::remove(Symbol* symbol) {
+  Symbol* prev = nullptr;
+  auto next = m_first;
+
+  while(next != nullptr) {
+    if(next == symbol) {
+      if(prev != nullptr) {
+        prev->m_next = next->m_next;
+      } else {
+        m_first = next->m_next;
+      }
+
+      next->m_next = nullptr;
+      return true;
+    }
+
+    prev = next;
+    next = next->m_next;
+  }
+
+  return false;
+}
+
+void OverloadSymbol::foreach(std::function<void(Symbol*)> f) { //NOLINT
+  auto symbol = m_first;
+
+  while(symbol != nullptr) {
+    f(symbol);
+    symbol = symbol->m_next;
+  }
+}
+
 //
 
 VariableSymbol::VariableSymbol() {}
@@ -52,7 +84,7 @@ SymbolKind VariableSymbol::kind() const {
   return SymbolKind::kVariable;
 }
 
-void VariableSymbol::init(Name* name, Symbol* parent, ast::Node* ast) {
+void VariableSymbol::init(NameId name, Symbol* parent, ast::Node* ast) {
   Symbol::init(name, parent, ast, nullptr);
 }
 
@@ -65,7 +97,7 @@ SymbolKind EmptySymbol::kind() const {
 }
 
 void EmptySymbol::init(Symbol* parent, ast::Node* ast) {
-  Symbol::init(nullptr, parent, ast, nullptr);
+  Symbol::init(kInvalidName, parent, ast, nullptr);
 }
 } //namespace syms
 } //namespace internal
@@ -29,7 +29,9 @@ namespace brutus {
 
       enum class ErrorReason {
         kUnknown,
-        kNoSuchName
+        kNoSuchName,
+        kNoSuchModule,
+        kNoSuchMember
       };
       
       class OverloadSymbol;
@@ -40,7 +42,7 @@ namespace brutus {
             return arena->alloc(size);
           }
           
-          ALWAYS_INLINE Name* name() const {
+          ALWAYS_INLINE NameId name() const {
             return m_name;
           }
 
@@ -65,7 +67,7 @@ namespace brutus {
           }
 
           explicit Symbol() 
-              : m_name(nullptr), 
+              : m_name(kInvalidName),
                 m_parent(nullptr), 
                 m_ast(nullptr), 
                 m_next(nullptr) {}
@@ -74,14 +76,14 @@ namespace brutus {
           virtual SymbolKind kind() const = 0;
 
         protected:
-          ALWAYS_INLINE void init(Name* name, Symbol* parent, ast::Node* ast, types::Type* type) {
+          ALWAYS_INLINE void init(NameId name, Symbol* parent, ast::Node* ast, types::Type* type) {
             m_name = name;
             m_parent = parent;
             m_ast = ast;
             m_type = type;
           }
 
-          Name* m_name;
+          NameId m_name;
           Symbol* m_parent;
           ast::Node* m_ast;
           types::Type* m_type;
@@ -104,7 +106,7 @@ namespace brutus {
         public:
           DeclarativeSymbol() : m_scope(nullptr) {}
           
-          void init(Name* name, Symbol* parent, ast::Node* ast, Scope* scope, types::Type* type) {
+          void init(NameId name, Symbol* parent, ast::Node* ast, Scope* scope, types::Type* type) {
             Symbol::init(name, parent, ast, type);
             m_scope = scope;
           }
@@ -137,7 +139,7 @@ namespace brutus {
       class ErrorSymbol : public Symbol {
         public:
           ErrorSymbol();
-          void init(Name* name, Symbol* parent, ast::Node* ast, ErrorReason reason);
+          void init(NameId name, Symbol* parent, ast::Node* ast, ErrorReason reason);
           ErrorReason reason() const;
           SYMBOL_OVERRIDES();
 
@@ -150,8 +152,12 @@ namespace brutus {
       class OverloadSymbol : public Symbol {
         public:
           OverloadSymbol();
-          void init(Name* name, Symbol* parent, ast::Node* ast);
+          void init(NameId name, Symbol* parent, ast::Node* ast);
           void add(Symbol* symbol);
+
+          // false if the symbol is not an alternative of this overload
+          bool remove(Symbol* symbol);
+          void foreach(std::function<void(Symbol*)> f); //NOLINT
           SYMBOL_OVERRIDES();
 
         private:
@@ -163,7 +169,7 @@ namespace brutus {
       class VariableSymbol : public Symbol {
         public:
           VariableSymbol();
-          void init(Name* name, Symbol* parent, ast::Node* ast);
+          void init(NameId name, Symbol* parent, ast::Node* ast);
           SYMBOL_OVERRIDES();
 
         private:
@@ -0,0 +1,190 @@
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+
+#include "trace.h"
+
+namespace brutus {
+namespace internal {
+class TraceBuffer {
+  public:
+    explicit TraceBuffer(int tid, TraceBuffer* next)
+        : m_numEvents(0),
+          m_tid(tid),
+          m_name(nullptr),
+          m_nameIndex(0),
+          m_next(next) {}
+
+    ALWAYS_INLINE void append(const TraceEvent& event) {
+      const auto index = m_numEvents.load(std::memory_order_relaxed);
+
+      m_events[index & (Tracer::BufferCapacity - 1)] = event;
+      m_numEvents.store(index + 1, std::memory_order_release);
+    }
+
+    TraceEvent m_events[Tracer::BufferCapacity];
+
+    // Number of events ever appended. Only the last BufferCapacity
+    // of them are kept.
+    std::atomic<uint64_t> m_numEvents;
+
+    const int m_tid;
+    const char* m_name;
+    int m_nameIndex;
+    TraceBuffer* const m_next;
+
+  private:
+    DISALLOW_COPY_AND_ASSIGN(TraceBuffer);
+}; //class TraceBuffer
+
+ASSERT_POW2(Tracer::BufferCapacity);
+
+std::atomic<bool> Tracer::s_isEnabled(NO);
+
+// Buffers of all threads that recorded an event since the trace has
+// been started. A thread that recorded during an earlier trace gets a
+// new buffer, the generation tells them apart.
+static std::mutex s_mutex;
+static TraceBuffer* s_buffers = nullptr;
+static int s_numBuffers = 0;
+static std::atomic<uint32_t> s_generation(0);
+static std::chrono::steady_clock::time_point s_origin;
+
+static thread_local TraceBuffer* t_buffer = nullptr;
+static thread_local uint32_t t_generation = 0;
+
+static void deleteBuffers() {
+  auto buffer = s_buffers;
+
+  while(nullptr != buffer) {
+    auto next = buffer->m_next;
+    delete buffer;
+    buffer = next;
+  }
+
+  s_buffers = nullptr;
+  s_numBuffers = 0;
+}
+
+void Tracer::start() {
+  std::lock_guard<std::mutex> lock(s_mutex);
+
+  s_isEnabled.store(NO);
+  deleteBuffers();
+  s_origin = std::chrono::steady_clock::now();
+  ++s_generation;
+  s_isEnabled.store(YES, std::memory_order_release);
+}
+
+void Tracer::stop() {
+  s_isEnabled.store(NO);
+}
+
+uint64_t Tracer::now() {
+  return static_cast<uint64_t>(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - s_origin).count());
+}
+
+TraceBuffer* Tracer::buffer() {
+  const auto generation = s_generation.load(std::memory_order_acquire);
+
+  if(nullptr == t_buffer || t_generation != generation) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+
+    s_buffers = new TraceBuffer(s_numBuffers++, s_buffers);
+    t_buffer = s_buffers;
+    t_generation = generation;
+  }
+
+  return t_buffer;
+}
+
+void Tracer::record(const char* category, const char* name,
+                    uint64_t start, const char* argName, int64_t arg) {
+  TraceEvent event;
+
+  event.m_category = category;
+  event.m_name = name;
+  event.m_argName = argName;
+  event.m_arg = arg;
+  event.m_start = start;
+  event.m_duration = now() - start;
+
+  buffer()->append(event);
+}
+
+void Tracer::nameThread(const char* name, int index) {
+  if(!isEnabled()) {
+    return;
+  }
+
+  auto buffer = Tracer::buffer();
+
+  buffer->m_name = name;
+  buffer->m_nameIndex = index;
+}
+
+ALWAYS_INLINE static void writeMicros(std::ostream& output, uint64_t ns) {
+  output << ns / 1000 << '.' << std::setw(3) << std::setfill('0') << ns % 1000 << std::setfill(' ');
+}
+
+void Tracer::write(std::ostream& output) {
+  std::lock_guard<std::mutex> lock(s_mutex);
+  uint64_t numDropped = 0;
+  bool isFirst = YES;
+
+  output << "{\"traceEvents\": [" << std::endl;
+
+  for(auto buffer = s_buffers; nullptr != buffer; buffer = buffer->m_next) {
+    const auto numEvents = buffer->m_numEvents.load(std::memory_order_acquire);
+    const auto first = numEvents > BufferCapacity ? numEvents - BufferCapacity : 0;
+
+    numDropped += first;
+
+    if(nullptr != buffer->m_name) {
+      output
+        << (isFirst ? "" : ",\n")
+        << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->m_tid
+        << ", \"args\": {\"name\": \"" << buffer->m_name << ' ' << buffer->m_nameIndex << "\"}}";
+      isFirst = NO;
+    }
+
+    for(auto i = first; i < numEvents; ++i) {
+      auto& event = buffer->m_events[i & (BufferCapacity - 1)];
+
+      output
+        << (isFirst ? "" : ",\n")
+        << "{\"name\": \"" << event.m_name
+        << "\", \"cat\": \"" << event.m_category
+        << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer->m_tid
+        << ", \"ts\": ";
+      writeMicros(output, event.m_start);
+      output << ", \"dur\": ";
+      writeMicros(output, event.m_duration);
+
+      if(nullptr != event.m_argName) {
+        output << ", \"args\": {\"" << event.m_argName << "\": " << event.m_arg << '}';
+      }
+
+      output << '}';
+      isFirst = NO;
+    }
+  }
+
+  output << std::endl << "], \"displayTimeUnit\": \"ns\", \"otherData\": {\"droppedEvents\": " << numDropped << "}}" << std::endl;
+}
+
+bool Tracer::write(const char* path) {
+  std::ofstream output(path);
+
+  if(!output) {
+    return NO;
+  }
+
+  write(output);
+  return output.good();
+}
+} //namespace internal
+} //namespace brutus
@@ -0,0 +1,117 @@
+#ifndef BRUTUS_TRACE_H_
+#define BRUTUS_TRACE_H_
+
+#include <atomic>
+#include <iostream>
+
+#include "brutus.h"
+
+#define TRACE_CONCAT_(x, y) x##y
+#define TRACE_CONCAT(x, y) TRACE_CONCAT_(x, y)
+
+// Records the time from here to the end of the enclosing block as an
+// event of the given category. Category and name must be literals.
+#define TRACE_SCOPE(category, name) \
+  ::brutus::internal::TraceScope TRACE_CONCAT(traceScope, __LINE__)(category, name)
+
+namespace brutus {
+  namespace internal {
+    // A complete event in the sense of the Chrome trace event format.
+    // Times are in nanoseconds since the trace started.
+    class TraceEvent {
+      public:
+        const char* m_category;
+        const char* m_name;
+        const char* m_argName;
+        int64_t m_arg;
+        uint64_t m_start;
+        uint64_t m_duration;
+    };
+
+    class TraceBuffer;
+
+    // Records events into a ring buffer per thread and writes them in
+    // the trace event format of Chrome, which about://tracing and
+    // Perfetto open.
+    //
+    // Only the owning thread writes to its buffer so recording takes
+    // no lock. A lock is only taken the first time a thread records
+    // an event. A full buffer overwrites its oldest events.
+    //
+    // When tracing is off a TraceScope costs a load and a branch.
+    class Tracer {
+      public:
+        // Events per thread that are kept.
+        static const int BufferCapacity = 1 << 14;
+
+        ALWAYS_INLINE static bool isEnabled() {
+          return s_isEnabled.load(std::memory_order_relaxed);
+        }
+
+        // Discards all events and starts recording.
+        static void start();
+
+        // Stops recording. The events are kept until the next start.
+        static void stop();
+
+        // Writes the events of all threads.
+        static void write(std::ostream& output);
+        static bool write(const char* path);
+
+        // Nanoseconds since the trace started.
+        static uint64_t now();
+
+        static void record(const char* category, const char* name,
+                           uint64_t start, const char* argName, int64_t arg);
+
+        // Names the calling thread in the trace, like "worker 2".
+        static void nameThread(const char* name, int index);
+
+      private:
+        static std::atomic<bool> s_isEnabled;
+
+        static TraceBuffer* buffer();
+    }; //class Tracer
+
+    class TraceScope {
+      public:
+        static const uint64_t NotTracing = ~0ULL;
+
+        ALWAYS_INLINE TraceScope(const char* category, const char* name)
+            : m_category(category),
+              m_name(name),
+              m_argName(nullptr),
+              m_arg(0),
+              m_start(Tracer::isEnabled() ? Tracer::now() : NotTracing) {}
+
+        ALWAYS_INLINE TraceScope(const char* category, const char* name, const char* argName, int64_t arg)
+            : m_category(category),
+              m_name(name),
+              m_argName(argName),
+              m_arg(arg),
+              m_start(Tracer::isEnabled() ? Tracer::now() : NotTracing) {}
+
+        ALWAYS_INLINE ~TraceScope() {
+          if(NotTracing != m_start) {
+            Tracer::record(m_category, m_name, m_start, m_argName, m_arg);
+          }
+        }
+
+        // Attaches a value that is only known at the end of the scope.
+        ALWAYS_INLINE void arg(const char* name, int64_t value) {
+          m_argName = name;
+          m_arg = value;
+        }
+
+      private:
+        const char* const m_category;
+        const char* const m_name;
+        const char* m_argName;
+        int64_t m_arg;
+        const uint64_t m_start;
+
+        DISALLOW_COPY_AND_ASSIGN(TraceScope);
+    }; //class TraceScope
+  } //namespace internal
+} //namespace brutus
+#endif
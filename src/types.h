@@ -122,6 +122,10 @@ namespace brutus {
             return m_returnType;
           }
 
+          void returnType(Type* value) {
+            m_returnType = value;
+          }
+
         private:
           Type* m_owner;
           int m_numParameters;
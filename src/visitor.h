@@ -0,0 +1,154 @@
+#ifndef BRUTUS_VISITOR_H_
+#define BRUTUS_VISITOR_H_
+
+#include "brutus.h"
+#include "ast.h"
+
+namespace brutus {
+  namespace internal {
+    namespace ast {
+      // Calls f for every child of the given node that is not null in
+      // the same order as ASTVisitor visits them.
+      //
+      // There is an overload per kind of node so a handler that knows
+      // the type of its node walks the children without looking at the
+      // kind again. The overload for Node* switches over the kind.
+#define VISIT_CHILD(x) \
+      if(nullptr != (x)) { \
+        f(x); \
+      }
+
+#define VISIT_CHILDREN(x) \
+      { \
+        auto list = (x); \
+        auto nodes = list->nodes(); \
+        for(int i = 0, n = list->size(); i < n; ++i) { \
+          VISIT_CHILD(nodes[i]); \
+        } \
+      }
+
+      template<typename F>
+      ALWAYS_INLINE void forEachChild(Argument* node, F f) {
+        VISIT_CHILD(node->name());
+        VISIT_CHILD(node->value());
+      }
+
+      template<typename F>
+      ALWAYS_INLINE void forEachChild(Assign* node, F f) {
+        VISIT_CHILD(node->target());
+        VISIT_CHILD(node->value());
+      }
+
+      template<typename F>
+      ALWAYS_INLINE void forEachChild(Block* node, F f) {
+        VISIT_CHILDREN(node->expressions());
+      }
+
+      template<typename F>
+      ALWAYS_INLINE void forEachChild(Call* node, F f) {
+        VISIT_CHILD(node->callee());
+        VISIT_CHILDREN(node->arguments());
+      }
+
+      template<typename F>
+      ALWAYS_INLINE void forEachChild(Class* node, F f) {
+        VISIT_CHILD(node->name());
+        VISIT_CHILDREN(node->typeParameters());
+        VISIT_CHILDREN(node->members());
+      }
+
+      template<typename F>
+      ALWAYS_INLINE void forEachChild(Function* node, F f) {
+        VISIT_CHILD(node->name());
+        VISIT_CHILD(node->type());
+        VISIT_CHILDREN(node->typeParameters());
+        VISIT_CHILDREN(node->parameters());
+        VISIT_CHILD(node->expr());
+      }
+
+      template<typename F>
+      ALWAYS_INLINE void forEachChild(If* node, F f) {
+        VISIT_CHILDREN(node->cases());
+      }
+
+      template<typename F>
+      ALWAYS_INLINE void forEachChild(IfCase* node, F f) {
+        VISIT_CHILD(node->condition());
+        VISIT_CHILD(node->expr());
+      }
+
+      template<typename F>
+      ALWAYS_INLINE void forEachChild(Module* node, F f) {
+        VISIT_CHILD(node->name());
+        VISIT_CHILDREN(node->declarations());
+        VISIT_CHILDREN(node->dependencies());
+      }
+
+      template<typename F>
+      ALWAYS_INLINE void forEachChild(ModuleDependency* node, F f) {
+        VISIT_CHILD(node->name());
+        VISIT_CHILD(node->version());
+      }
+
+      template<typename F>
+      ALWAYS_INLINE void forEachChild(Parameter* node, F f) {
+        VISIT_CHILD(node->name());
+        VISIT_CHILD(node->type());
+      }
+
+      template<typename F>
+      ALWAYS_INLINE void forEachChild(Program* node, F f) {
+        VISIT_CHILDREN(node->modules());
+      }
+
+      template<typename F>
+      ALWAYS_INLINE void forEachChild(Select* node, F f) {
+        VISIT_CHILD(node->object());
+        VISIT_CHILD(node->qualifier());
+      }
+
+      template<typename F>
+      ALWAYS_INLINE void forEachChild(TypeParameter* node, F f) {
+        VISIT_CHILD(node->name());
+        VISIT_CHILD(node->bound());
+      }
+
+      template<typename F>
+      ALWAYS_INLINE void forEachChild(Variable* node, F f) {
+        VISIT_CHILD(node->name());
+        VISIT_CHILD(node->type());
+        VISIT_CHILD(node->init());
+      }
+
+#define DEFINE_LEAF(x) \
+      template<typename F> \
+      ALWAYS_INLINE void forEachChild(x* node, F f) { \
+        UNUSED(node); \
+        UNUSED(f); \
+      }
+      DEFINE_LEAF(Error)
+      DEFINE_LEAF(False)
+      DEFINE_LEAF(Identifier)
+      DEFINE_LEAF(Number)
+      DEFINE_LEAF(String)
+      DEFINE_LEAF(This)
+      DEFINE_LEAF(True)
+#undef DEFINE_LEAF
+#undef VISIT_CHILDREN
+#undef VISIT_CHILD
+
+      template<typename F>
+      void forEachChild(Node* node, F f) {
+        switch(node->kind()) {
+#define DISPATCH_NODE_KIND(x) \
+          case NodeKind::k##x: \
+            forEachChild(static_cast<x*>(node), f); \
+            break;
+          AST_NODE_KINDS(DISPATCH_NODE_KIND)
+#undef DISPATCH_NODE_KIND
+        }
+      }
+    } //namespace ast
+  } //namespace internal
+} //namespace brutus
+#endif
@@ -0,0 +1,133 @@
+#include "writer.h"
+
+namespace brutus {
+namespace internal {
+const size_t Writer::BufferSize;
+
+Writer::Writer(FILE* fp)
+    : m_fp(fp),
+      m_target(nullptr),
+      m_buffer(NewArray<char>(BufferSize)),
+      m_length(0),
+      m_isGood(YES) {}
+
+Writer::Writer(ByteBuffer* target)
+    : m_fp(nullptr),
+      m_target(target),
+      m_buffer(NewArray<char>(BufferSize)),
+      m_length(0),
+      m_isGood(YES) {}
+
+Writer::~Writer() {
+  flushBuffer();
+  DeleteArray(m_buffer);
+}
+
+// Formats the digits from the end of a buffer that is large enough
+// for any 64-bit value.
+template<typename T>
+ALWAYS_INLINE static void writeUnsigned(Writer* writer, T value, bool isNegative) {
+  char digits[24];
+  auto p = digits + sizeof(digits); //NOLINT
+
+  do {
+    *--p = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while(0 != value);
+
+  if(isNegative) {
+    *--p = '-';
+  }
+
+  writer->write(p, static_cast<size_t>(digits + sizeof(digits) - p)); //NOLINT
+}
+
+Writer& Writer::operator<<(int32_t value) {
+  return *this << static_cast<int64_t>(value);
+}
+
+Writer& Writer::operator<<(uint32_t value) {
+  return *this << static_cast<uint64_t>(value);
+}
+
+Writer& Writer::operator<<(int64_t value) {
+  // The magnitude of the smallest value does not fit its own type.
+  const auto magnitude = value < 0
+    ? static_cast<uint64_t>(-(value + 1)) + 1
+    : static_cast<uint64_t>(value);
+
+  writeUnsigned(this, magnitude, value < 0);
+  return *this;
+}
+
+Writer& Writer::operator<<(uint64_t value) {
+  writeUnsigned(this, value, NO);
+  return *this;
+}
+
+void Writer::writeJsonString(const char* value) {
+  static const char kHex[] = "0123456789abcdef";
+
+  *this << '"';
+
+  for(auto p = value; '\0' != *p; ++p) {
+    const auto c = static_cast<unsigned char>(*p);
+
+    switch(c) {
+      case '"': write("\\\"", 2); break;
+      case '\\': write("\\\\", 2); break;
+      case '\n': write("\\n", 2); break;
+      case '\r': write("\\r", 2); break;
+      case '\t': write("\\t", 2); break;
+      default:
+        if(c < 0x20) {
+          write("\\u00", 4);
+          *this << kHex[c >> 4] << kHex[c & 0xf];
+        } else {
+          *this << static_cast<char>(c);
+        }
+    }
+  }
+
+  *this << '"';
+}
+
+bool Writer::flush() {
+  flushBuffer();
+
+  if(nullptr != m_fp && 0 != fflush(m_fp)) {
+    m_isGood = NO;
+  }
+
+  return m_isGood;
+}
+
+void Writer::flushBuffer() {
+  writeThrough(m_buffer, m_length);
+  m_length = 0;
+}
+
+void Writer::writeSlow(const char* data, size_t length) {
+  flushBuffer();
+
+  if(length >= BufferSize) {
+    writeThrough(data, length);
+  } else {
+    ArrayCopy(m_buffer, data, length);
+    m_length = length;
+  }
+}
+
+void Writer::writeThrough(const char* data, size_t length) {
+  if(0 == length) {
+    return;
+  }
+
+  if(nullptr != m_target) {
+    m_target->append(data, length);
+  } else if(length != fwrite(data, 1, length, m_fp)) {
+    m_isGood = NO;
+  }
+}
+} //namespace internal
+} //namespace brutus
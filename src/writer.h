@@ -0,0 +1,79 @@
+#ifndef BRUTUS_WRITER_H_
+#define BRUTUS_WRITER_H_
+
+#include <cstdio>
+#include <cstring>
+
+#include "brutus.h"
+#include "alloc.h"
+#include "buffer.h"
+
+namespace brutus {
+  namespace internal {
+    // Collects text in a buffer and passes it on to a file or a byte
+    // buffer in large chunks. Unlike an std::ostream there is no
+    // formatting state, no locale and no flush at the end of a line.
+    //
+    // Whatever is buffered is written when the writer is deleted.
+    class Writer {
+      public:
+        static const size_t BufferSize = 1 << 16;
+
+        explicit Writer(FILE* fp);
+        explicit Writer(ByteBuffer* target);
+        ~Writer();
+
+        ALWAYS_INLINE void write(const char* data, size_t length) {
+          if(length > BufferSize - m_length) {
+            writeSlow(data, length);
+            return;
+          }
+
+          ArrayCopy(m_buffer + m_length, data, length);
+          m_length += length;
+        }
+
+        ALWAYS_INLINE Writer& operator<<(char value) {
+          if(BufferSize == m_length) {
+            flushBuffer();
+          }
+
+          m_buffer[m_length++] = value;
+          return *this;
+        }
+
+        ALWAYS_INLINE Writer& operator<<(const char* value) {
+          write(value, strlen(value));
+          return *this;
+        }
+
+        Writer& operator<<(int32_t value);
+        Writer& operator<<(uint32_t value);
+        Writer& operator<<(int64_t value);
+        Writer& operator<<(uint64_t value);
+
+        // Writes the value in quotes with the characters escaped that
+        // JSON does not allow in a string.
+        void writeJsonString(const char* value);
+
+        // Passes the buffered text on and flushes the file. Returns
+        // NO if anything could not be written since the writer has
+        // been created.
+        bool flush();
+
+      private:
+        FILE* const m_fp;
+        ByteBuffer* const m_target;
+        char* m_buffer;
+        size_t m_length;
+        bool m_isGood;
+
+        void flushBuffer();
+        void writeSlow(const char* data, size_t length);
+        void writeThrough(const char* data, size_t length);
+
+        DISALLOW_COPY_AND_ASSIGN(Writer);
+    }; //class Writer
+  } //namespace internal
+} //namespace brutus
+#endif